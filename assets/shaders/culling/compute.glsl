@@ -0,0 +1,140 @@
+#version 450 core
+
+layout (local_size_x = 64) in;
+
+struct DrawBounds
+{
+    vec4 min_corner;
+    vec4 max_corner;
+};
+
+struct DrawArraysIndirectCommand
+{
+    uint count;
+    uint instance_count;
+    uint first;
+    uint base_instance;
+};
+
+layout (std430, binding = 0) readonly buffer BoundsBuffer
+{
+    DrawBounds bounds[];
+};
+
+layout (std430, binding = 1) buffer CommandBuffer
+{
+    DrawArraysIndirectCommand commands[];
+};
+
+layout (std430, binding = 2) buffer VisibilityBuffer
+{
+    uint visibility[];
+};
+
+layout (binding = 0) uniform sampler2D hi_z_pyramid;
+
+uniform mat4 mvp;
+uniform int number_of_draws;
+uniform int cull_pass;
+
+// Cull passes and the corresponding draw set (segment of the command buffer)
+const int EARLY_PASS = 0;
+const int LATE_PASS = 1;
+const int FRUSTUM_PASS = 2;
+const int EARLY_SET = 0;
+const int LATE_SET = 1;
+const int VISIBLE_SET = 2;
+const int FRUSTUM_SET = 3;
+
+vec4 clip_corners[8];
+
+void transform_corners(DrawBounds draw_bounds)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = vec3((i & 1) != 0 ? draw_bounds.max_corner.x : draw_bounds.min_corner.x,
+                           (i & 2) != 0 ? draw_bounds.max_corner.y : draw_bounds.min_corner.y,
+                           (i & 4) != 0 ? draw_bounds.max_corner.z : draw_bounds.min_corner.z);
+        clip_corners[i] = mvp * vec4(corner, 1.0);
+    }
+}
+
+bool inside_frustum()
+{
+    // The box is outside if all its corners are outside of the same clip plane
+    bvec3 all_below = bvec3(true);
+    bvec3 all_above = bvec3(true);
+    for (int i = 0; i < 8; ++i)
+    {
+        vec4 corner = clip_corners[i];
+        all_below = bvec3(ivec3(all_below) & ivec3(lessThan(corner.xyz, vec3(-corner.w))));
+        all_above = bvec3(ivec3(all_above) & ivec3(greaterThan(corner.xyz, vec3(corner.w))));
+    }
+
+    return !any(all_below) && !any(all_above);
+}
+
+bool occluded()
+{
+    vec3 ndc_min = vec3(1.0);
+    vec3 ndc_max = vec3(-1.0);
+    for (int i = 0; i < 8; ++i)
+    {
+        // Boxes crossing the near plane are conservatively considered visible
+        if (clip_corners[i].w <= 0.0)
+        {
+            return false;
+        }
+        vec3 ndc = clip_corners[i].xyz / clip_corners[i].w;
+        ndc_min = min(ndc_min, ndc);
+        ndc_max = max(ndc_max, ndc);
+    }
+
+    vec2 uv_min = clamp(ndc_min.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uv_max = clamp(ndc_max.xy * 0.5 + 0.5, 0.0, 1.0);
+    float closest_depth = ndc_min.z * 0.5 + 0.5;
+
+    // Choose the level where the screen-space rectangle covers at most 2x2 texels
+    vec2 size_in_texels = (uv_max - uv_min) * vec2(textureSize(hi_z_pyramid, 0));
+    float level = ceil(log2(max(max(size_in_texels.x, size_in_texels.y), 1.0)));
+    level = min(level, float(textureQueryLevels(hi_z_pyramid) - 1));
+
+    float farthest_depth = max(max(textureLod(hi_z_pyramid, uv_min, level).r,
+                                   textureLod(hi_z_pyramid, vec2(uv_max.x, uv_min.y), level).r),
+                               max(textureLod(hi_z_pyramid, vec2(uv_min.x, uv_max.y), level).r,
+                                   textureLod(hi_z_pyramid, uv_max, level).r));
+
+    return closest_depth > farthest_depth;
+}
+
+void main()
+{
+    uint draw = gl_GlobalInvocationID.x;
+    if (draw >= uint(number_of_draws))
+    {
+        return;
+    }
+
+    transform_corners(bounds[draw]);
+    bool visible = inside_frustum();
+    uint offset = uint(number_of_draws);
+
+    if (cull_pass == EARLY_PASS)
+    {
+        // Draw whatever was visible on the previous frame
+        commands[EARLY_SET * offset + draw].instance_count = (visible && visibility[draw] != 0u) ? 1u : 0u;
+    }
+    else if (cull_pass == LATE_PASS)
+    {
+        bool drawn_early = commands[EARLY_SET * offset + draw].instance_count != 0u;
+        visible = visible && !occluded();
+        // Only draws disoccluded on this frame weren't rendered by the early pass
+        commands[LATE_SET * offset + draw].instance_count = (visible && !drawn_early) ? 1u : 0u;
+        commands[VISIBLE_SET * offset + draw].instance_count = (visible || drawn_early) ? 1u : 0u;
+        visibility[draw] = visible ? 1u : 0u;
+    }
+    else
+    {
+        commands[FRUSTUM_SET * offset + draw].instance_count = visible ? 1u : 0u;
+    }
+}
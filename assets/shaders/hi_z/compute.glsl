@@ -0,0 +1,44 @@
+#version 450 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D depth_map;
+layout (r32f, binding = 0) uniform readonly image2D previous_level;
+layout (r32f, binding = 1) uniform writeonly image2D current_level;
+
+uniform int level;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 level_size = imageSize(current_level);
+    if (any(greaterThanEqual(texel, level_size)))
+    {
+        return;
+    }
+
+    float depth;
+    if (level == 0)
+    {
+        depth = texelFetch(depth_map, texel, 0).r;
+    }
+    else
+    {
+        // Keep the farthest depth of the texels covered on the previous level;
+        // odd dimensions make the last row/column cover an extra texel
+        ivec2 previous_size = imageSize(previous_level);
+        ivec2 first_texel = 2 * texel;
+        ivec2 last_texel = min(first_texel + ivec2(1) + (previous_size & ivec2(1)) * ivec2(equal(texel, level_size - 1)),
+                               previous_size - 1);
+        depth = 0.0;
+        for (int y = first_texel.y; y <= last_texel.y; ++y)
+        {
+            for (int x = first_texel.x; x <= last_texel.x; ++x)
+            {
+                depth = max(depth, imageLoad(previous_level, ivec2(x, y)).r);
+            }
+        }
+    }
+
+    imageStore(current_level, texel, vec4(depth));
+}
@@ -4,6 +4,9 @@ in vec3 vertex_frag_pos;
 in vec3 vertex_normal;
 in vec2 vertex_tex_coordinates;
 in vec4 vertex_frag_pos_light_space;
+#ifdef GPU_DRIVEN
+flat in uint vertex_draw_id;
+#endif
 
 out vec4 frag_color;
 
@@ -21,6 +24,11 @@ uniform float bias;
 
 #ifdef DIFFUSE_MAP
 layout (binding = 0) uniform sampler2D diffuse_map;
+#elif defined(GPU_DRIVEN)
+layout (std430, binding = 3) readonly buffer DiffuseColors
+{
+    vec4 diffuse_colors[];
+};
 #else
 uniform vec3 diffuse_color = vec3(1.0, 0.0, 0.0);
 #endif
@@ -58,6 +66,8 @@ void main()
 
     #ifdef DIFFUSE_MAP
     vec3 diffuse_color = texture(diffuse_map, vertex_tex_coordinates).rgb;
+    #elif defined(GPU_DRIVEN)
+    vec3 diffuse_color = diffuse_colors[vertex_draw_id].rgb;
     #endif
 
     // Ambient component
@@ -3,6 +3,10 @@
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_normal;
 layout (location = 2) in vec2 in_tex_coordinates;
+#ifdef GPU_DRIVEN
+layout (location = 3) in uint in_draw_id;
+flat out uint vertex_draw_id;
+#endif
 
 uniform mat4 model = mat4(1.0);
 uniform mat4 mvp = mat4(1.0);
@@ -17,6 +21,9 @@ void main()
 {
     vertex_normal = in_normal;
     vertex_tex_coordinates = in_tex_coordinates;
+    #ifdef GPU_DRIVEN
+    vertex_draw_id = in_draw_id;
+    #endif
     vec4 homogeneous_position = vec4(in_position, 1.0);
     vec4 frag_pos = model * homogeneous_position;
     vertex_frag_pos = vec3(frag_pos);
@@ -0,0 +1,128 @@
+#version 450 core
+
+/*
+Mitchell's radial blur as a compute shader. The rays of a tile of pixels
+converge towards the light, so together they cross a band of the occlusion
+map running from the tile towards the light. Each workgroup loads its band
+once into shared memory, on a grid aligned with the direction of the light,
+and its rays then march inside shared memory. Bands longer than the grid
+are loaded at a coarser spacing, which remains finer than the spacing of
+the taps of the longest ray.
+*/
+
+// Must match the tile size of the dispatch
+#define TILE_SIZE 16
+// Cells of the band along and across the direction of the light; 32 KiB of shared memory
+#define BAND_LENGTH 256
+#define BAND_WIDTH 32
+
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout (binding = 0) uniform sampler2D occlusion_map_sampler;
+layout (rgba16f, binding = 0) uniform writeonly image2D blurred_map;
+uniform vec2 screen_space_light_position;
+// Tile of the first workgroup, when the dispatch covers only part of the target
+uniform uvec2 first_tile = uvec2(0);
+
+struct PostprocessingCoefficients
+{
+    int num_samples;
+    float density;
+    float exposure;
+    float decay;
+    float weight;
+};
+
+uniform PostprocessingCoefficients coefficients;
+
+// Colors of the occlusion map, in [0, 1]; packing them is exact for a mask and rounds colors to 8 bits
+shared uint band[BAND_LENGTH * BAND_WIDTH];
+
+// Frame of the band in texels of the occlusion map: u points towards the light
+vec2 u_axis;
+vec2 v_axis;
+vec2 band_origin;
+vec2 cell_size;
+
+vec2 to_band(vec2 texel)
+{
+    return (vec2(dot(texel, u_axis), dot(texel, v_axis)) - band_origin) / cell_size;
+}
+
+vec3 band_cell(ivec2 cell)
+{
+    return unpackUnorm4x8(band[cell.y * BAND_LENGTH + cell.x]).rgb;
+}
+
+// Bilinear interpolation between the cells of the band
+vec3 band_sample(vec2 texel)
+{
+    vec2 cell = clamp(to_band(texel), vec2(0.0), vec2(BAND_LENGTH - 1, BAND_WIDTH - 1));
+    ivec2 first_cell = min(ivec2(cell), ivec2(BAND_LENGTH - 2, BAND_WIDTH - 2));
+    vec2 fraction = cell - vec2(first_cell);
+    vec3 bottom = mix(band_cell(first_cell), band_cell(first_cell + ivec2(1, 0)), fraction.x);
+    vec3 top = mix(band_cell(first_cell + ivec2(0, 1)), band_cell(first_cell + ivec2(1, 1)), fraction.x);
+    return mix(bottom, top, fraction.y);
+}
+
+void main()
+{
+    ivec2 output_size = imageSize(blurred_map);
+    vec2 occlusion_size = vec2(textureSize(occlusion_map_sampler, 0));
+    vec2 light = screen_space_light_position;
+    uvec2 tile = gl_WorkGroupID.xy + first_tile;
+    vec2 tile_min = vec2(tile * TILE_SIZE) / vec2(output_size);
+    vec2 tile_max = vec2(tile * TILE_SIZE + TILE_SIZE) / vec2(output_size);
+
+    vec2 towards_light = (light - 0.5 * (tile_min + tile_max)) * occlusion_size;
+    u_axis = length(towards_light) > 1e-3 ? normalize(towards_light) : vec2(1.0, 0.0);
+    v_axis = vec2(-u_axis.y, u_axis.x);
+
+    // The band bounds the rays of the corners of the tile, and so the rays of all its pixels
+    vec2 band_min = vec2(1e30);
+    vec2 band_max = vec2(-1e30);
+    for (int i = 0; i < 4; ++i)
+    {
+        vec2 corner = mix(tile_min, tile_max, vec2(i & 1, i >> 1));
+        vec2 ray_end = corner - coefficients.density * (corner - light);
+        for (int end = 0; end < 2; ++end)
+        {
+            vec2 texel = (end == 0 ? corner : ray_end) * occlusion_size;
+            vec2 projection = vec2(dot(texel, u_axis), dot(texel, v_axis));
+            band_min = min(band_min, projection);
+            band_max = max(band_max, projection);
+        }
+    }
+    // A margin of a texel for the bilinear interpolation at the edges
+    band_origin = band_min - 1.0;
+    cell_size = max((band_max + 1.0 - band_origin) / vec2(BAND_LENGTH - 1, BAND_WIDTH - 1), vec2(1.0));
+
+    for (uint cell = gl_LocalInvocationIndex; cell < BAND_LENGTH * BAND_WIDTH; cell += TILE_SIZE * TILE_SIZE)
+    {
+        vec2 position = band_origin + vec2(cell % BAND_LENGTH, cell / BAND_LENGTH) * cell_size;
+        vec2 texel = position.x * u_axis + position.y * v_axis;
+        band[cell] = packUnorm4x8(textureLod(occlusion_map_sampler, texel / occlusion_size, 0.0));
+    }
+    barrier();
+
+    // Invocations of partial tiles still load their cells, but have no pixel to write
+    ivec2 pixel = ivec2(tile * TILE_SIZE + gl_LocalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, output_size)))
+    {
+        return;
+    }
+
+    vec2 tex_coordinates = (vec2(pixel) + 0.5) / vec2(output_size);
+    vec2 delta_tex_coord = (tex_coordinates - light) * coefficients.density * (1.0 / float(coefficients.num_samples));
+    // The pixel itself is unweighted, so it's fetched at full precision
+    vec3 color = textureLod(occlusion_map_sampler, tex_coordinates, 0.0).rgb;
+    float decay = 1.0;
+    for (int i = 0; i < coefficients.num_samples; ++i)
+    {
+        tex_coordinates -= delta_tex_coord;
+        color += band_sample(tex_coordinates * occlusion_size) * decay * coefficients.weight;
+        decay *= coefficients.decay;
+    }
+
+    imageStore(blurred_map, pixel, vec4(color, 1.0));
+}
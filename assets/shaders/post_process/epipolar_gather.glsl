@@ -0,0 +1,148 @@
+#version 450 core
+
+/*
+Second pass of the epipolar radial blur: every pixel finds the two
+epipolar lines around it and reads the decayed sum of the samples of its
+ray from their prefix sums, at a cost independent of num_samples. The
+decay rate of the ray is interpolated between the rates of the scans.
+Where the two lines disagree, e.g. across the silhouette of an occluder,
+the pixel marches its ray through the occlusion map instead.
+*/
+
+in vec2 vertex_tex_coordinates;
+out vec4 frag_color;
+
+layout (binding = 0) uniform sampler2D occlusion_map_sampler;
+layout (binding = 1) uniform sampler2D epipolar_sums_sampler;
+layout (binding = 2) uniform sampler2D epipolar_lines_sampler;
+uniform vec2 screen_space_light_position;
+
+struct PostprocessingCoefficients
+{
+    int num_samples;
+    float density;
+    float exposure;
+    float decay;
+    float weight;
+};
+
+uniform PostprocessingCoefficients coefficients;
+
+// Relative difference between the blur of two lines above which the pixel marches its ray
+const float discontinuity_threshold = 0.25;
+
+// Normalized distance along the perimeter of the screen of a point of its border, counterclockwise
+float perimeter_position(vec2 point)
+{
+    if (point.y <= 0.0)
+    {
+        return 0.25 * point.x;
+    }
+    if (point.x >= 1.0)
+    {
+        return 0.25 + 0.25 * point.y;
+    }
+    if (point.y >= 1.0)
+    {
+        return 0.5 + 0.25 * (1.0 - point.x);
+    }
+    return 0.75 + 0.25 * (1.0 - point.y);
+}
+
+// Prefix sum of a scan of a line at a fractional sample index, interpolated between the samples
+vec3 prefix_sum(int line, int rate, float index)
+{
+    if (index < 0.0)
+    {
+        return vec3(0.0);
+    }
+    index = min(index, float(SAMPLES_PER_LINE - 1));
+    int first_index = min(int(index), SAMPLES_PER_LINE - 2);
+    vec3 first_sum = texelFetch(epipolar_sums_sampler, ivec2(rate * SAMPLES_PER_LINE + first_index, line), 0).rgb;
+    vec3 second_sum = texelFetch(epipolar_sums_sampler, ivec2(rate * SAMPLES_PER_LINE + first_index + 1, line), 0).rgb;
+    return mix(first_sum, second_sum, index - float(first_index));
+}
+
+// Decayed sum of the samples of a scan from index first (excluded) to index last (included)
+vec3 window_sum(int line, int rate, float sample_decay, float first, float last)
+{
+    return prefix_sum(line, rate, last) - pow(sample_decay, last - first) * prefix_sum(line, rate, first);
+}
+
+// Blur of the ray of the pixel read from a line, or a negative value if the line doesn't reach the screen
+vec3 line_blur(int line, float ray_length)
+{
+    // Distance of the first sample to the light, spacing of the samples, length of the line and spacing of its taps
+    vec4 parameters = texelFetch(epipolar_lines_sampler, ivec2(line, 0), 0);
+    if (parameters.y <= 0.0)
+    {
+        return vec3(-1.0);
+    }
+
+    // The ray of the pixel spans the distances [ray_length * (1 - density), ray_length] from the light
+    float last = (ray_length - parameters.x) / parameters.y;
+    float first = (ray_length * (1.0 - coefficients.density) - parameters.x) / parameters.y;
+
+    // Scans whose rays are 2^-rate times as long as the line, around the length of the ray of the pixel
+    float rate = clamp(log2(parameters.z / ray_length), 0.0, float(DECAY_RATES - 1));
+    int first_rate = min(int(rate), DECAY_RATES - 2);
+    float tap_distance = parameters.w * exp2(-float(first_rate));
+    float first_decay = tap_distance > 0.0 ? pow(coefficients.decay, parameters.y / tap_distance) : 1.0;
+    vec3 sum = mix(window_sum(line, first_rate, first_decay, first, last),
+                   window_sum(line, first_rate + 1, first_decay * first_decay, first, last), rate - float(first_rate));
+
+    // Each sample stands for the taps of Mitchell's blur over its spacing
+    float taps_per_sample = float(coefficients.num_samples) * parameters.y /
+                            max(coefficients.density * ray_length, 1e-6);
+    return sum * taps_per_sample * coefficients.weight;
+}
+
+// Mitchell's blur, marched through the occlusion map
+vec3 marched_blur(vec2 light)
+{
+    vec2 delta_tex_coord = (vertex_tex_coordinates - light) * coefficients.density /
+                           float(max(coefficients.num_samples, 1));
+    vec2 tex_coordinates = vertex_tex_coordinates;
+    vec3 color = vec3(0.0);
+    float decay = 1.0;
+    for (int i = 0; i < coefficients.num_samples; ++i)
+    {
+        tex_coordinates -= delta_tex_coord;
+        color += texture(occlusion_map_sampler, tex_coordinates).rgb * decay * coefficients.weight;
+        decay *= coefficients.decay;
+    }
+
+    return color;
+}
+
+void main()
+{
+    vec2 light = screen_space_light_position;
+    vec3 color = texture(occlusion_map_sampler, vertex_tex_coordinates).rgb;
+    vec2 direction = vertex_tex_coordinates - light;
+    float ray_length = length(direction);
+    if (ray_length < 1e-6)
+    {
+        frag_color = vec4(color, 1.0);
+        return;
+    }
+
+    // The ray of the pixel continues to the border of the screen, where the lines end
+    vec2 inverse_direction = 1.0 / direction;
+    vec2 t_far = max((vec2(0.0) - light) * inverse_direction, (vec2(1.0) - light) * inverse_direction);
+    vec2 border = clamp(light + min(t_far.x, t_far.y) * direction, 0.0, 1.0);
+
+    int number_of_lines = textureSize(epipolar_lines_sampler, 0).x;
+    float line_coordinate = perimeter_position(border) * float(number_of_lines) - 0.5;
+    int first_line = int(floor(line_coordinate));
+    float line_fraction = line_coordinate - float(first_line);
+    // The lines wrap around the perimeter
+    vec3 first_blur = line_blur((first_line + number_of_lines) % number_of_lines, ray_length);
+    vec3 second_blur = line_blur((first_line + 1) % number_of_lines, ray_length);
+
+    float difference = length(first_blur - second_blur);
+    bool discontinuity = first_blur.r < 0.0 || second_blur.r < 0.0 ||
+                         difference > discontinuity_threshold * max(length(first_blur + second_blur) * 0.5, 0.05);
+    color += discontinuity ? marched_blur(light) : mix(first_blur, second_blur, line_fraction);
+    frag_color = vec4(color, 1.0);
+}
@@ -0,0 +1,117 @@
+#version 450 core
+
+/*
+First pass of the epipolar radial blur. The blur only varies along the
+lines radiating from the light, so the occlusion map is sampled along a
+fixed number of epipolar lines, one per workgroup, running from the light
+(or from where they enter the screen) to points spread evenly over the
+border of the screen. Parallel prefix scans then compute, for every
+sample, the sum of the samples up to it, each decayed by its distance.
+
+The decay of the taps of Mitchell's blur is exponential along the ray of a
+pixel, at a rate inversely proportional to the length of the ray. A scan is
+computed for the rates of the rays ending at the border and at 1/2, 1/4...
+of the distance to it, between which the pixels interpolate.
+*/
+
+// SAMPLES_PER_LINE and DECAY_RATES are defined by the application; a workgroup has a thread per sample
+layout (local_size_x = SAMPLES_PER_LINE) in;
+
+layout (binding = 0) uniform sampler2D occlusion_map_sampler;
+// Decayed prefix sums, one row per line made of DECAY_RATES spans of SAMPLES_PER_LINE sums
+layout (rgba32f, binding = 0) uniform writeonly image2D epipolar_sums;
+// Per line: distance of the first sample to the light, spacing of the samples and length of the line
+layout (rgba32f, binding = 1) uniform writeonly image2D epipolar_lines;
+uniform vec2 screen_space_light_position;
+
+struct PostprocessingCoefficients
+{
+    int num_samples;
+    float density;
+    float exposure;
+    float decay;
+    float weight;
+};
+
+uniform PostprocessingCoefficients coefficients;
+
+shared vec3 sums[2][SAMPLES_PER_LINE];
+
+// Point of the border of the screen at the normalized distance t along its perimeter, counterclockwise
+vec2 border_point(float t)
+{
+    float edge_position = fract(t * 4.0);
+    switch (int(t * 4.0))
+    {
+    case 0:
+        return vec2(edge_position, 0.0);
+    case 1:
+        return vec2(1.0, edge_position);
+    case 2:
+        return vec2(1.0 - edge_position, 1.0);
+    default:
+        return vec2(0.0, 1.0 - edge_position);
+    }
+}
+
+// Fraction of the segment from the origin to the end at which it enters the screen
+float screen_entry(vec2 origin, vec2 end)
+{
+    vec2 direction = end - origin;
+    vec2 inverse_direction = 1.0 / direction;
+    vec2 t0 = (vec2(0.0) - origin) * inverse_direction;
+    vec2 t1 = (vec2(1.0) - origin) * inverse_direction;
+    vec2 t_near = min(t0, t1);
+    return clamp(max(t_near.x, t_near.y), 0.0, 1.0);
+}
+
+void main()
+{
+    uint line = gl_WorkGroupID.x;
+    uint sample_index = gl_LocalInvocationID.x;
+    int number_of_lines = imageSize(epipolar_sums).y;
+
+    vec2 light = screen_space_light_position;
+    vec2 end = border_point((float(line) + 0.5) / float(number_of_lines));
+    float line_length = distance(light, end);
+    float start_distance = screen_entry(light, end) * line_length;
+    float spacing = (line_length - start_distance) / float(SAMPLES_PER_LINE - 1);
+    // Distance between the taps of the ray ending at the border
+    float tap_distance = coefficients.density * line_length / float(max(coefficients.num_samples, 1));
+
+    vec2 position = mix(light, end, (start_distance + float(sample_index) * spacing) / max(line_length, 1e-6));
+    vec3 occlusion = textureLod(occlusion_map_sampler, position, 0.0).rgb;
+
+    for (int rate = 0; rate < DECAY_RATES; ++rate)
+    {
+        // Rays half as long have taps half as far apart, so their decay per sample is squared
+        float sample_decay = tap_distance > 0.0 ? pow(coefficients.decay, exp2(float(rate)) * spacing / tap_distance)
+                                                : 1.0;
+        sums[0][sample_index] = occlusion;
+        barrier();
+
+        // Hillis-Steele scan: the sum of a sample covers the samples up to offset samples before it
+        int source = 0;
+        for (uint offset = 1; offset < SAMPLES_PER_LINE; offset *= 2)
+        {
+            vec3 sum = sums[source][sample_index];
+            if (sample_index >= offset)
+            {
+                sum += pow(sample_decay, float(offset)) * sums[source][sample_index - offset];
+            }
+            sums[1 - source][sample_index] = sum;
+            source = 1 - source;
+            barrier();
+        }
+
+        imageStore(epipolar_sums, ivec2(rate * SAMPLES_PER_LINE + int(sample_index), line),
+                   vec4(sums[source][sample_index], 1.0));
+        // The sums are read before the next scan overwrites them
+        barrier();
+    }
+
+    if (sample_index == 0)
+    {
+        imageStore(epipolar_lines, ivec2(line, 0), vec4(start_distance, spacing, line_length, tap_distance));
+    }
+}
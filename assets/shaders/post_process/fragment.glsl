@@ -4,7 +4,21 @@ in vec2 vertex_tex_coordinates;
 out vec4 frag_color;
 
 layout (binding = 0) uniform sampler2D occlusion_map_sampler;
+// Blur of the occlusion map rendered by separate passes, possibly at a lower resolution, scaled by its gain
+layout (binding = 1) uniform sampler2D blurred_map_sampler;
+// Depth of the occlusion pre-pass, guiding the upsampling of the blurred map
+layout (binding = 2) uniform sampler2D depth_sampler;
+uniform bool use_blurred_map = false;
+uniform float blurred_map_gain = 1.0;
+// Weight of the occlusion map added to the blurred map
+uniform float occlusion_map_weight = 1.0;
+uniform bool depth_aware_upsample = false;
+// Elements [3][2] and [2][2] of the projection matrix, which linearize depths
+uniform vec2 depth_linearization;
 uniform float alpha = 0.3;
+// Color of the lights when the occlusion map only holds a mask of them, white if it holds their colors
+uniform vec3 light_color = vec3(1.0);
+// Positions of the lights in texture coordinates, with the intensity of their rays in w (0 for hidden lights)
 uniform vec4 screen_space_light_positions[NUM_LIGHTS];
 
 struct PostprocessingCoefficients
@@ -18,39 +32,136 @@ struct PostprocessingCoefficients
 
 uniform bool apply_radial_blur = true;
 uniform PostprocessingCoefficients coefficients;
+// Samples the mip chain of the occlusion map with cone_taps taps instead of taking num_samples taps
+uniform bool cone_sampling = false;
+uniform int cone_taps = 16;
+// Takes a tap per texels_per_sample texels of the ray, between min_samples and num_samples
+uniform bool adaptive_sampling = false;
+uniform int min_samples = 8;
+uniform float texels_per_sample = 2.0;
+// Offsets the taps of each pixel within their steps by interleaved gradient noise
+uniform bool jitter_samples = false;
+// Caps the taps, e.g. for the temporal blur, which spreads them over frames
+uniform int max_samples = 1024;
+// Fraction of a step by which every tap moves towards the pixel, varied over frames by the temporal blur
+uniform float sample_offset = 0.0;
 
 vec3 radial_blur(PostprocessingCoefficients coefficients, vec2 screen_space_position);
+vec3 cone_radial_blur(PostprocessingCoefficients coefficients, vec2 screen_space_position);
 vec3 multi_source_radial_blur(PostprocessingCoefficients coefficients);
+vec3 upsample_blurred_map();
+float interleaved_gradient_noise(vec2 position);
 
 void main()
 {
+#ifdef BLUR_TARGET
+    // The blur is rendered into its own target; the composite applies the exposure
+    frag_color = vec4(multi_source_radial_blur(coefficients), 1.0);
+#else
     frag_color = vec4(0.0);
-    if (apply_radial_blur)
+    if (apply_radial_blur && use_blurred_map)
     {
-        frag_color = vec4(multi_source_radial_blur(coefficients), 1.0);
+        vec3 blurred_color = depth_aware_upsample ? upsample_blurred_map()
+                                                  : texture(blurred_map_sampler, vertex_tex_coordinates).rgb;
+        vec3 color = occlusion_map_weight * texture(occlusion_map_sampler, vertex_tex_coordinates).rgb +
+                     blurred_map_gain * blurred_color;
+        frag_color = vec4(color * coefficients.exposure, 1.0);
+    }
+    else if (apply_radial_blur)
+    {
+        frag_color = vec4(multi_source_radial_blur(coefficients) * coefficients.exposure, 1.0);
     }
     else
     {
         frag_color = texture(occlusion_map_sampler, vertex_tex_coordinates);
     }
+    frag_color.rgb *= light_color;
+#endif
 }
 
 vec3 radial_blur(PostprocessingCoefficients coefficients, vec2 screen_space_position)
 {
-    vec2 delta_tex_coord = (vertex_tex_coordinates - screen_space_position) * coefficients.density * (1.0 / float(coefficients.num_samples));
-    vec2 tex_coordinates = vertex_tex_coordinates;
-    vec3 color = texture(occlusion_map_sampler, tex_coordinates).rgb;
+    if (cone_sampling && coefficients.num_samples > cone_taps)
+    {
+        return cone_radial_blur(coefficients, screen_space_position);
+    }
+
+    int num_samples = coefficients.num_samples;
+    if (adaptive_sampling)
+    {
+        float ray_length = length((vertex_tex_coordinates - screen_space_position) * coefficients.density *
+                                  vec2(textureSize(occlusion_map_sampler, 0)));
+        num_samples = clamp(int(ceil(ray_length / texels_per_sample)), min(min_samples, coefficients.num_samples),
+                            coefficients.num_samples);
+    }
+    num_samples = min(num_samples, max_samples);
+    // Each tap stands for several taps of the full blur, whose decays it sums so that the brightness is kept
+    float taps_per_sample = float(coefficients.num_samples) / float(max(num_samples, 1));
+    float sample_decay = pow(coefficients.decay, taps_per_sample);
+    float weight = coefficients.weight * (abs(1.0 - coefficients.decay) > 1e-6
+                                              ? (1.0 - sample_decay) / (1.0 - coefficients.decay)
+                                              : taps_per_sample);
+
+    vec2 delta_tex_coord = (vertex_tex_coordinates - screen_space_position) * coefficients.density /
+                           float(max(num_samples, 1));
+    // Stratified jitter: every tap moves by the same fraction of a step towards the pixel, staying within its step
+    float offset = sample_offset;
+    if (jitter_samples)
+    {
+        offset += interleaved_gradient_noise(gl_FragCoord.xy);
+    }
+    vec2 tex_coordinates = vertex_tex_coordinates + fract(offset) * delta_tex_coord;
+    vec3 color = texture(occlusion_map_sampler, vertex_tex_coordinates).rgb;
     float decay = 1.0;
-    for (int i = 0; i < coefficients.num_samples; ++i)
+    for (int i = 0; i < num_samples; ++i)
     {
         tex_coordinates -= delta_tex_coord;
         vec3 current_sample = texture(occlusion_map_sampler, tex_coordinates).rgb;
-        current_sample *= decay * coefficients.weight;
+        current_sample *= decay * weight;
         color += current_sample;
-        decay *= coefficients.decay;
+        decay *= sample_decay;
+    }
+
+    return color;
+}
+
+/*
+Cone-traced blur: the taps of radial_blur are grouped into segments of the
+ray growing geometrically from the light towards the pixel, the first one
+holding a single tap. Each segment is sampled once, at the mip level of the
+occlusion map whose texels are as long as the segment, and weighted by the
+decays of the taps it stands for. Segments stay short near the light, where
+every ray converges and mip levels would spread the light across rays.
+*/
+vec3 cone_radial_blur(PostprocessingCoefficients coefficients, vec2 screen_space_position)
+{
+    vec2 delta_tex_coord = (vertex_tex_coordinates - screen_space_position) * coefficients.density /
+                           float(coefficients.num_samples);
+    float tap_length = length(delta_tex_coord * vec2(textureSize(occlusion_map_sampler, 0)));
+    float samples = float(coefficients.num_samples);
+    float growth = pow(samples, 1.0 / float(cone_taps - 1));
+    vec3 color = textureLod(occlusion_map_sampler, vertex_tex_coordinates, 0.0).rgb;
+    // Each segment spans the taps (num_samples - segment_end, num_samples - segment_start] of radial_blur
+    float segment_start = 0.0;
+    float segment_end = 1.0;
+    for (int i = 0; i < cone_taps; ++i)
+    {
+        float taps = segment_end - segment_start;
+        // Centroid of the taps of the segment
+        float tap = samples - max(0.5 * (segment_start + segment_end - 1.0), segment_start);
+        float lod = log2(max(taps * tap_length, 1.0)) - 1.0;
+        vec2 tex_coordinates = vertex_tex_coordinates - tap * delta_tex_coord;
+        vec3 current_sample = textureLod(occlusion_map_sampler, tex_coordinates, lod).rgb;
+        // Sum of the decays of the taps of the segment
+        float decay = coefficients.decay < 1.0 ? pow(coefficients.decay, samples - segment_end) *
+                                                     (1.0 - pow(coefficients.decay, taps)) / (1.0 - coefficients.decay)
+                                               : taps;
+        color += current_sample * decay * coefficients.weight;
+        segment_start = segment_end;
+        segment_end = i == cone_taps - 2 ? samples : segment_end * growth;
     }
 
-    return color * coefficients.exposure;
+    return color;
 }
 
 vec3 multi_source_radial_blur(PostprocessingCoefficients coefficients)
@@ -58,8 +169,53 @@ vec3 multi_source_radial_blur(PostprocessingCoefficients coefficients)
     vec3 multiple_sources_color = vec3(0.0);
     for (int i = 0; i < NUM_LIGHTS; ++i)
     {
-        multiple_sources_color += radial_blur(coefficients, screen_space_light_positions[i].xy);
+        vec4 light = screen_space_light_positions[i];
+        if (light.w > 0.0)
+        {
+            multiple_sources_color += light.w * radial_blur(coefficients, light.xy);
+        }
     }
 
     return multiple_sources_color;
-}
\ No newline at end of file
+}
+
+// Noise of Jimenez, whose values differ the most between neighbouring pixels, so that blurs cancel it out
+float interleaved_gradient_noise(vec2 position)
+{
+    return fract(52.9829189 * fract(dot(position, vec2(0.06711056, 0.00583715))));
+}
+
+float linear_depth(vec2 tex_coordinates)
+{
+    float ndc_depth = 2.0 * texture(depth_sampler, tex_coordinates).r - 1.0;
+    return depth_linearization.x / (ndc_depth + depth_linearization.y);
+}
+
+/*
+Joint bilateral upsampling: the four texels of the blurred map around the
+pixel are weighted bilinearly and by the similarity of their depth with the
+depth of the pixel, so that the rays don't bleed across silhouettes.
+*/
+vec3 upsample_blurred_map()
+{
+    vec2 size = vec2(textureSize(blurred_map_sampler, 0));
+    vec2 position = vertex_tex_coordinates * size - 0.5;
+    ivec2 origin = ivec2(floor(position));
+    vec2 fraction = position - floor(position);
+    float depth = linear_depth(vertex_tex_coordinates);
+
+    vec3 color = vec3(0.0);
+    float total_weight = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(origin + offset, ivec2(0), ivec2(size) - 1);
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        float depth_difference = abs(linear_depth((vec2(texel) + 0.5) / size) - depth) / depth;
+        float weight = bilinear.x * bilinear.y / (0.01 + depth_difference);
+        color += weight * texelFetch(blurred_map_sampler, texel, 0).rgb;
+        total_weight += weight;
+    }
+
+    return color / max(total_weight, 1e-6);
+}
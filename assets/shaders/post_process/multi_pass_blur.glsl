@@ -0,0 +1,38 @@
+#version 450 core
+
+/*
+One pass of the hierarchical radial blur: a few taps towards the light,
+spaced by a fraction of the distance to the light that grows from pass to
+pass. The taps are averaged with their decay weights so that the result
+stays in the range of the input; the composite applies the sum of the
+weights of the taps of the single-pass blur.
+*/
+
+in vec2 vertex_tex_coordinates;
+out vec4 frag_color;
+
+layout (binding = 0) uniform sampler2D input_sampler;
+uniform vec2 screen_space_light_position;
+uniform int taps;
+// Fraction of the distance to the light between consecutive taps
+uniform float step_fraction;
+// Decay between consecutive taps
+uniform float tap_decay;
+
+void main()
+{
+    vec2 delta_tex_coord = (vertex_tex_coordinates - screen_space_light_position) * step_fraction;
+    vec2 tex_coordinates = vertex_tex_coordinates;
+    vec3 color = vec3(0.0);
+    float decay = 1.0;
+    float total_weight = 0.0;
+    for (int i = 0; i < taps; ++i)
+    {
+        color += decay * texture(input_sampler, tex_coordinates).rgb;
+        total_weight += decay;
+        decay *= tap_decay;
+        tex_coordinates -= delta_tex_coord;
+    }
+
+    frag_color = vec4(color / max(total_weight, 1e-6), 1.0);
+}
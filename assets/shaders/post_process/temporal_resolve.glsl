@@ -0,0 +1,51 @@
+#version 450 core
+
+/*
+Temporal accumulation of the radial blur: the blur of the frame, taken with
+a few taps offset differently on every frame, is blended with the history
+of the previous frames, reprojected to the pixel with the depth of the
+occlusion pre-pass. The history is dropped where it falls outside of the
+screen or where the occlusion of the pixel changed, which the alpha channel
+of the history keeps track of.
+*/
+
+in vec2 vertex_tex_coordinates;
+out vec4 frag_color;
+
+layout (binding = 0) uniform sampler2D blurred_map_sampler;
+layout (binding = 1) uniform sampler2D history_sampler;
+layout (binding = 2) uniform sampler2D depth_sampler;
+layout (binding = 3) uniform sampler2D occlusion_map_sampler;
+// Maps the normalized device coordinates of the frame to the clip coordinates of the previous frame
+uniform mat4 reprojection;
+// Weight of the history in the blend, 0 to restart the accumulation
+uniform float history_weight;
+// Largest change of the luminance of the occlusion map for which the history is kept
+uniform float occlusion_threshold;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main()
+{
+    vec3 color = texture(blurred_map_sampler, vertex_tex_coordinates).rgb;
+    float occlusion = luminance(texture(occlusion_map_sampler, vertex_tex_coordinates).rgb);
+
+    float depth = texture(depth_sampler, vertex_tex_coordinates).r;
+    vec4 previous_position = reprojection * vec4(vec3(vertex_tex_coordinates, depth) * 2.0 - 1.0, 1.0);
+    vec2 previous_tex_coordinates = previous_position.xy / previous_position.w * 0.5 + 0.5;
+    bool on_screen = previous_position.w > 0.0 && all(greaterThanEqual(previous_tex_coordinates, vec2(0.0))) &&
+                     all(lessThanEqual(previous_tex_coordinates, vec2(1.0)));
+    if (on_screen && history_weight > 0.0)
+    {
+        vec4 history = texture(history_sampler, previous_tex_coordinates);
+        if (abs(history.a - occlusion) <= occlusion_threshold)
+        {
+            color = mix(color, history.rgb, history_weight);
+        }
+    }
+
+    frag_color = vec4(color, occlusion);
+}
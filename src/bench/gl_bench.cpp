@@ -0,0 +1,266 @@
+/*
+Micro-benchmarks of the CPU hot paths of the gl library that run without an
+OpenGL context. Every benchmark prints a JSON line with its time and heap
+allocations per iteration; see micro_benchmark.hpp.
+*/
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <tiny_obj_loader.h>
+
+#include "bench/micro_benchmark.hpp"
+#include "gl/bounds.hpp"
+#include "gl/camera.hpp"
+#include "gl/image.hpp"
+#include "gl/io.hpp"
+#include "gl/model.hpp"
+#include "gl/shader.hpp"
+#include "gl/software_occlusion.hpp"
+
+namespace
+{
+
+struct Options
+{
+    bench::Settings settings{};
+    // Only benchmarks whose name contains the filter run
+    std::string filter{};
+};
+
+constexpr std::string_view usage{"Usage: gl_bench [--filter TEXT] [--repetitions N] [--warmup N]\n"};
+
+Options parse_options(const std::vector<std::string_view>& arguments)
+{
+    Options options;
+    for (std::size_t i = 0; i + 1 < arguments.size(); i += 2)
+    {
+        const std::string_view option{arguments[i]};
+        const std::string value{arguments[i + 1]};
+        if (option == "--filter")
+        {
+            options.filter = value;
+        }
+        else if (option == "--repetitions" || option == "--warmup")
+        {
+            std::size_t parsed_characters{0};
+            const unsigned long count{std::stoul(value, &parsed_characters)};
+            if (parsed_characters != value.size() || (option == "--repetitions" && count == 0))
+            {
+                throw std::invalid_argument("Invalid value " + value + " for option " + std::string{option});
+            }
+            (option == "--repetitions" ? options.settings.repetitions : options.settings.warmup_repetitions) = count;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option: " + std::string{option});
+        }
+    }
+    if (arguments.size() % 2 != 0)
+    {
+        throw std::invalid_argument("Unknown option or missing value: " + std::string{arguments.back()});
+    }
+    return options;
+}
+
+/*
+OBJ shape of a grid of quads split into two triangles, with normals and
+texture coordinates, whose rows of quads alternate between materials.
+*/
+struct ObjGrid
+{
+    tinyobj::attrib_t attrib;
+    tinyobj::shape_t shape;
+};
+
+ObjGrid make_obj_grid(int quads_per_side, int rows_per_material)
+{
+    ObjGrid grid;
+    const int vertices_per_side{quads_per_side + 1};
+    for (int y = 0; y < vertices_per_side; ++y)
+    {
+        for (int x = 0; x < vertices_per_side; ++x)
+        {
+            const float u{static_cast<float>(x) / static_cast<float>(quads_per_side)};
+            const float v{static_cast<float>(y) / static_cast<float>(quads_per_side)};
+            grid.attrib.vertices.insert(grid.attrib.vertices.end(), {u, std::sin(u * v), v});
+            grid.attrib.normals.insert(grid.attrib.normals.end(), {0.0f, 1.0f, 0.0f});
+            grid.attrib.texcoords.insert(grid.attrib.texcoords.end(), {u, v});
+        }
+    }
+
+    for (int y = 0; y < quads_per_side; ++y)
+    {
+        for (int x = 0; x < quads_per_side; ++x)
+        {
+            const int corner{y * vertices_per_side + x};
+            for (const int vertex : {corner, corner + 1, corner + vertices_per_side + 1, corner,
+                                     corner + vertices_per_side + 1, corner + vertices_per_side})
+            {
+                grid.shape.mesh.indices.emplace_back(tinyobj::index_t{vertex, vertex, vertex});
+            }
+            for (int triangle = 0; triangle < 2; ++triangle)
+            {
+                grid.shape.mesh.num_face_vertices.emplace_back(3);
+                grid.shape.mesh.material_ids.emplace_back(y / rows_per_material % 4);
+            }
+        }
+    }
+    return grid;
+}
+
+// Bounding boxes spread around the origin, e.g. the meshes of a scene around the camera
+std::vector<gl::AABB> make_boxes(std::size_t count)
+{
+    std::vector<gl::AABB> boxes(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float angle{static_cast<float>(i) * 0.37f};
+        const float distance{2.0f + static_cast<float>(i % 64)};
+        const glm::vec3 center{distance * std::cos(angle), static_cast<float>(i % 7) - 3.0f,
+                               distance * std::sin(angle)};
+        boxes[i].expand(center - glm::vec3{0.5f});
+        boxes[i].expand(center + glm::vec3{0.5f});
+    }
+    return boxes;
+}
+
+void write_file(const std::filesystem::path& filename, std::string_view contents)
+{
+    std::ofstream file{filename};
+    file << contents;
+    if (!file)
+    {
+        throw std::runtime_error("Failure to write file " + filename.string());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try
+    {
+        options = parse_options(std::vector<std::string_view>(argv + 1, argv + argc));
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n' << usage;
+        return EXIT_FAILURE;
+    }
+
+    const auto benchmark = [&options](std::string_view name, auto&& iteration) {
+        if (name.find(options.filter) != std::string_view::npos)
+        {
+            bench::write_json_line(std::cout, bench::run(name, options.settings, iteration));
+        }
+    };
+
+    try
+    {
+        // Inputs are generated rather than read from the assets, so that runs are reproducible anywhere
+        const ObjGrid grid{make_obj_grid(128, 16)};
+        benchmark("io/convert_shape", [&grid](std::size_t) {
+            bench::keep(gl::convert_shape(grid.attrib, grid.shape, true));
+        });
+
+        gl::Model model;
+        model.scale = glm::vec3{0.5f};
+        benchmark("model/transform", [&model](std::size_t i) {
+            model.euler_angles.y = static_cast<float>(i % 360) * 0.01f;
+            bench::keep(model.transform());
+        });
+
+        gl::FPSCamera camera{glm::vec3{0.0f, 1.0f, 3.0f}};
+        benchmark("camera/view_projection", [&camera](std::size_t i) {
+            camera.process_mouse_movement(i % 2 == 0 ? 1.0f : -1.0f, 0.5f);
+            bench::keep(camera.view_projection());
+        });
+
+        // Uniforms of the Blinn-Phong shaders, looked up the way the set_*_uniform functions do
+        gl::ShaderProgram::UniformLocations uniform_locations;
+        constexpr std::array<const char*, 12> uniform_names{
+            "model",         "view",          "projection",    "light_space_matrix", "view_position", "light.direction",
+            "light.ambient", "light.diffuse", "light.specular", "bias",              "shadow_map",    "diffuse_color"};
+        for (std::uint32_t location = 0; const char* name : uniform_names)
+        {
+            uniform_locations.emplace(name, location++);
+        }
+        benchmark("shader/uniform_lookup", [&uniform_locations, &uniform_names](std::size_t i) {
+            const std::string& uniform_name{uniform_names[i % uniform_names.size()]};
+            bench::keep(uniform_locations.find(uniform_name)->second);
+        });
+
+        const std::filesystem::path directory{std::filesystem::temp_directory_path() / "gl_bench"};
+        std::filesystem::create_directories(directory);
+        // The directive parser drops the character ending the included file name, i.e. the \r of CRLF line endings
+        std::string shader_source{"#version 460 core\r\n#include common.glsl\r\n"};
+        for (int line = 0; line < 200; ++line)
+        {
+            shader_source += "vec3 value_" + std::to_string(line) + " = vec3(" + std::to_string(line) + ".0);\n";
+        }
+        write_file(directory / "common.glsl", "float saturate(float x) { return clamp(x, 0.0, 1.0); }\n");
+        const std::string shader_path{(directory / "shader.frag").string()};
+        const gl::ShaderInfo shader_info{.filepath = shader_path,
+                                         .type = gl::Shader::Type::Fragment,
+                                         .define_variables = {"USE_SHADOWS", "SAMPLES 64"}};
+        benchmark("shader/preprocessor_directives", [&shader_source, &shader_info](std::size_t) {
+            bench::keep(gl::process_shader_preprocessor_directives(shader_source, shader_info));
+        });
+
+        gl::Image image{.width = 256, .height = 256};
+        image.pixels.resize(static_cast<std::size_t>(image.width * image.height) * 4);
+        for (std::size_t i = 0; i < image.pixels.size(); ++i)
+        {
+            image.pixels[i] = static_cast<std::uint8_t>((i * 7) ^ (i >> 10));
+        }
+        const std::string image_path{(directory / "image.png").string()};
+        gl::write_png(image_path, image);
+        benchmark("image/read_png", [&image_path](std::size_t) { bench::keep(gl::read_png(image_path)); });
+
+        const std::vector<gl::AABB> boxes{make_boxes(1024)};
+        const glm::mat4 transform{model.transform()};
+        benchmark("bounds/transformed", [&boxes, &transform](std::size_t i) {
+            bench::keep(boxes[i % boxes.size()].transformed(transform));
+        });
+
+        // Frustum culling alone, with an empty depth buffer, then behind the occluders of a wall
+        camera.set_aspect_ratio(4.0f / 3.0f);
+        const glm::mat4 view_projection{camera.view_projection()};
+        gl::SoftwareOcclusionCuller culler{256, 128, 1};
+        culler.render_occluders(view_projection);
+        benchmark("culling/frustum", [&culler, &boxes, &view_projection](std::size_t i) {
+            bench::keep(culler.is_visible(boxes[i % boxes.size()], view_projection));
+        });
+
+        culler.set_occluders({glm::vec3{-50.0f, -50.0f, -1.0f}, glm::vec3{50.0f, -50.0f, -1.0f},
+                              glm::vec3{50.0f, 50.0f, -1.0f}, glm::vec3{-50.0f, -50.0f, -1.0f},
+                              glm::vec3{50.0f, 50.0f, -1.0f}, glm::vec3{-50.0f, 50.0f, -1.0f}});
+        culler.render_occluders(view_projection);
+        benchmark("culling/occlusion", [&culler, &boxes, &view_projection](std::size_t i) {
+            bench::keep(culler.is_visible(boxes[i % boxes.size()], view_projection));
+        });
+        benchmark("culling/render_occluders",
+                  [&culler, &view_projection](std::size_t) { culler.render_occluders(view_projection); });
+
+        std::filesystem::remove_all(directory);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include "micro_benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+
+namespace
+{
+
+std::atomic<std::uint64_t> allocation_count{0};
+std::atomic<std::uint64_t> allocated_byte_count{0};
+
+} // namespace
+
+/*
+Replacing the global allocation functions counts every allocation of the
+executable; the array and nothrow forms call this one. Over-aligned
+allocations aren't counted, since nothing benchmarked here makes them.
+*/
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_byte_count.fetch_add(size, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/) noexcept
+{
+    std::free(pointer);
+}
+
+namespace bench
+{
+
+AllocationCounters allocation_counters()
+{
+    return AllocationCounters{.allocations = allocation_count.load(std::memory_order_relaxed),
+                              .bytes = allocated_byte_count.load(std::memory_order_relaxed)};
+}
+
+Result make_result(std::string_view name, std::size_t iterations, std::vector<double> repetition_ns,
+                   const AllocationCounters& allocations)
+{
+    Result result{.name = std::string{name}, .iterations = iterations, .repetitions = repetition_ns.size()};
+    if (repetition_ns.empty())
+    {
+        return result;
+    }
+
+    for (double& nanoseconds : repetition_ns)
+    {
+        nanoseconds /= static_cast<double>(iterations);
+    }
+    std::sort(repetition_ns.begin(), repetition_ns.end());
+    const std::size_t middle{repetition_ns.size() / 2};
+    result.min_ns = repetition_ns.front();
+    result.median_ns = repetition_ns.size() % 2 == 1 ? repetition_ns[middle]
+                                                     : 0.5 * (repetition_ns[middle - 1] + repetition_ns[middle]);
+    result.mean_ns = std::accumulate(repetition_ns.cbegin(), repetition_ns.cend(), 0.0) /
+                     static_cast<double>(repetition_ns.size());
+    result.max_ns = repetition_ns.back();
+
+    const auto measured_iterations = static_cast<double>(iterations * repetition_ns.size());
+    result.allocations = static_cast<double>(allocations.allocations) / measured_iterations;
+    result.allocated_bytes = static_cast<double>(allocations.bytes) / measured_iterations;
+    return result;
+}
+
+void write_json_line(std::ostream& stream, const Result& result)
+{
+    const auto precision = stream.precision(3);
+    const auto flags = stream.setf(std::ios::fixed, std::ios::floatfield);
+
+    // Benchmark names are identifiers, so they need no escaping
+    stream << "{\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+           << ", \"repetitions\": " << result.repetitions << ", \"min_ns\": " << result.min_ns
+           << ", \"median_ns\": " << result.median_ns << ", \"mean_ns\": " << result.mean_ns
+           << ", \"max_ns\": " << result.max_ns << ", \"allocations\": " << result.allocations
+           << ", \"allocated_bytes\": " << result.allocated_bytes << "}\n";
+
+    stream.precision(precision);
+    stream.flags(flags);
+}
+
+} // namespace bench
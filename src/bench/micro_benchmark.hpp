@@ -0,0 +1,118 @@
+#ifndef MICRO_BENCHMARK_HPP
+#define MICRO_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+
+struct Settings
+{
+    // Repetitions run before measuring, e.g. to fill the caches and let the CPU frequency settle
+    std::size_t warmup_repetitions{3};
+    std::size_t repetitions{15};
+    // The number of iterations of a repetition is doubled until the repetition lasts at least this long
+    std::chrono::nanoseconds min_repetition_time{std::chrono::milliseconds{20}};
+};
+
+/*
+Times per iteration over the measured repetitions, and heap allocations
+per iteration counted by the replaced global operator new.
+*/
+struct Result
+{
+    std::string name;
+    std::size_t iterations{0};
+    std::size_t repetitions{0};
+    double min_ns{0.0};
+    double median_ns{0.0};
+    double mean_ns{0.0};
+    double max_ns{0.0};
+    double allocations{0.0};
+    double allocated_bytes{0.0};
+};
+
+// Number of allocations and allocated bytes since the start of the program
+struct AllocationCounters
+{
+    std::uint64_t allocations{0};
+    std::uint64_t bytes{0};
+};
+
+AllocationCounters allocation_counters();
+
+// Summarizes the nanoseconds per iteration of the measured repetitions
+Result make_result(std::string_view name, std::size_t iterations, std::vector<double> repetition_ns,
+                   const AllocationCounters& allocations);
+
+/*
+Calls iteration(i) in repetitions of a calibrated number of iterations and
+measures the time and allocations of each iteration. Results of the
+iterations must be passed to keep() so that the compiler doesn't remove
+their computation.
+*/
+template <typename Iteration>
+Result run(std::string_view name, const Settings& settings, Iteration&& iteration)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto run_repetition = [&iteration](std::size_t iterations) {
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            iteration(i);
+        }
+        return Clock::now() - start;
+    };
+
+    // Calibration also warms up the benchmark
+    std::size_t iterations{1};
+    while (run_repetition(iterations) < settings.min_repetition_time && iterations < (std::size_t{1} << 30))
+    {
+        iterations *= 2;
+    }
+    for (std::size_t repetition = 0; repetition < settings.warmup_repetitions; ++repetition)
+    {
+        run_repetition(iterations);
+    }
+
+    std::vector<double> repetition_ns;
+    repetition_ns.reserve(settings.repetitions);
+    const AllocationCounters start_allocations{allocation_counters()};
+    for (std::size_t repetition = 0; repetition < settings.repetitions; ++repetition)
+    {
+        const auto duration = run_repetition(iterations);
+        repetition_ns.emplace_back(
+            static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+    }
+    const AllocationCounters end_allocations{allocation_counters()};
+
+    // The measurements don't allocate, since the vector was reserved
+    return make_result(name, iterations, std::move(repetition_ns),
+                       AllocationCounters{.allocations = end_allocations.allocations - start_allocations.allocations,
+                                          .bytes = end_allocations.bytes - start_allocations.bytes});
+}
+
+// Prints a result as a single line JSON object, with a fixed set and order of keys
+void write_json_line(std::ostream& stream, const Result& result);
+
+template <typename T>
+void keep(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink{nullptr};
+    sink = &value;
+#endif
+}
+
+} // namespace bench
+
+#endif // MICRO_BENCHMARK_HPP
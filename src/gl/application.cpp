@@ -11,32 +11,71 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cassert>
 #include <exception>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
+#include "cpu_profiler.hpp"
+#include "debug_output.hpp"
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
 #include "framebuffer.hpp"
+#include "headless_context.hpp"
 #include "mesh.hpp"
 #include "shader.hpp"
-#include "skybox.hpp"
+#include "state.hpp"
 #include "texture.hpp"
 
 namespace gl
 {
 
-Application::Application(int window_width, int window_height, std::string_view title) :
+Application::Application(int window_width, int window_height, std::string_view title,
+                         ContextSettings context_settings) :
     width_{window_width}, height_{window_height}, aspect_ratio_{static_cast<float>(width_) / height_}
 {
-    create_context(title);
-    initialize_imgui();
-    load_opengl();
+    GL_PROFILE_THREAD_NAME("Main");
+    if (context_settings.headless)
+    {
+        GL_PROFILE_PHASE("Create headless context");
+        create_headless_context(context_settings.samples, context_settings.debug);
+    }
+    else
+    {
+        {
+            GL_PROFILE_PHASE("Create context");
+            create_context(title, context_settings.samples, context_settings.debug);
+        }
+        {
+            GL_PROFILE_PHASE("Initialize ImGui");
+            initialize_imgui();
+        }
+        {
+            GL_PROFILE_PHASE("Load OpenGL");
+            load_opengl();
+        }
+    }
+
+    if (context_settings.debug)
+    {
+        debug_output().enable();
+        // The offscreen framebuffer is created with the context, before the debug output could be enabled
+        if (headless_context_)
+        {
+            debug_output().label(GL_FRAMEBUFFER, offscreen_framebuffer_, "Offscreen framebuffer");
+            debug_output().label(GL_RENDERBUFFER, offscreen_color_->id(), "Offscreen color");
+            debug_output().label(GL_RENDERBUFFER, offscreen_depth_->id(), "Offscreen depth");
+        }
+    }
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    camera_.set_aspect_ratio(aspect_ratio_);
+    state_cache().set_depth(DepthState{});
+    state_cache().set_raster(RasterState{});
     glEnable(GL_MULTISAMPLE);
 }
 
-void Application::create_context(std::string_view title)
+void Application::create_context(std::string_view title, int samples, bool debug)
 {
     glfwSetErrorCallback(error_callback);
 
@@ -49,7 +88,8 @@ void Application::create_context(std::string_view title)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_SAMPLES, 8);
+    glfwWindowHint(GLFW_SAMPLES, samples);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debug ? GLFW_TRUE : GLFW_FALSE);
 
     window_ = glfwCreateWindow(width_, height_, title.data(), nullptr, nullptr);
     if (!window_)
@@ -59,7 +99,7 @@ void Application::create_context(std::string_view title)
     }
 
     glfwMakeContextCurrent(window_);
-    glfwSetWindowSizeCallback(window_, framebuffer_size_callback);
+    glfwSetFramebufferSizeCallback(window_, framebuffer_size_callback);
     glfwSetWindowUserPointer(window_, this);
     glfwSetKeyCallback(window_, key_callback);
     glfwSetCursorPosCallback(window_, mouse_movement_callback);
@@ -67,14 +107,43 @@ void Application::create_context(std::string_view title)
     glfwSetScrollCallback(window_, scroll_callback);
 }
 
+void Application::create_headless_context(int samples, bool debug)
+{
+    headless_context_ = std::make_unique<HeadlessContext>(4, 5, debug);
+    if (!gladLoadGLLoader(HeadlessContext::proc_address))
+    {
+        headless_context_.reset();
+        throw std::runtime_error("Failure to initialize GLAD");
+    }
+
+    // Surfaceless contexts have no default framebuffer, so the passes targeting the window render offscreen
+    const auto width = static_cast<std::uint32_t>(width_);
+    const auto height = static_cast<std::uint32_t>(height_);
+    const GpuMemoryTracker::OwnerScope owner{"Offscreen framebuffer"};
+    offscreen_color_.emplace(width, height, GL_RGBA8, samples);
+    offscreen_depth_.emplace(width, height, GL_DEPTH24_STENCIL8, samples);
+    glCreateFramebuffers(1, &offscreen_framebuffer_);
+    glNamedFramebufferRenderbuffer(offscreen_framebuffer_, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                   offscreen_color_->id());
+    glNamedFramebufferRenderbuffer(offscreen_framebuffer_, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+                                   offscreen_depth_->id());
+    if (glCheckNamedFramebufferStatus(offscreen_framebuffer_, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error("Failure to create the offscreen framebuffer");
+    }
+
+    state_cache().bind_framebuffer(offscreen_framebuffer_);
+    state_cache().set_viewport(0, 0, width_, height_);
+}
+
 void error_callback(int error, const char* description)
 {
     std::cerr << "GLFW Error (" << error << "): " << description << std::endl;
 }
 
-void framebuffer_size_callback(GLFWwindow* /*window*/, int width, int height)
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    static_cast<Application*>(glfwGetWindowUserPointer(window))->resize(width, height);
 }
 
 void key_callback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/)
@@ -213,6 +282,25 @@ void Application::load_opengl()
 Application::~Application()
 {
     cleanup();
+    if (headless_context_)
+    {
+        glDeleteFramebuffers(1, &offscreen_framebuffer_);
+        offscreen_color_.reset();
+        offscreen_depth_.reset();
+    }
+
+    // Derived applications have destroyed their members by now, so the resources still registered were leaked
+    gpu_memory().report_leaks(std::cerr);
+    if (debug_output().is_enabled())
+    {
+        debug_output().write_log(std::cerr);
+    }
+    if (headless_context_)
+    {
+        headless_context_.reset();
+        return;
+    }
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -226,23 +314,154 @@ void Application::cleanup()
 
 void Application::run()
 {
+    if (headless_context_)
+    {
+        throw std::logic_error("Headless applications have no window to run");
+    }
+
     float delta_time = 0.0f;
     float previous_time = 0.0f;
 
     while (!glfwWindowShouldClose(window_))
     {
+        GL_PROFILE_SCOPE("frame", "Frame");
         float current_time = static_cast<float>(glfwGetTime());
         delta_time = current_time - previous_time;
         previous_time = current_time;
 
         process_input(delta_time);
+        if (playback_)
+        {
+            // The playback overrides the user's input and advances at the fixed time step of the track
+            delta_time = static_cast<float>(CameraTrack::time_step);
+            if (!step_playback())
+            {
+                stop_playback();
+            }
+        }
         update(delta_time);
-        render();
+        if (recording_)
+        {
+            if (!recording_->track.empty())
+            {
+                recording_->time += delta_time;
+            }
+            recording_->track.add_keyframe(recording_->time, CameraTrack::pose_of(camera_));
+        }
+        {
+            GL_PROFILE_SCOPE("frame", "Render");
+            frame_stats().begin_frame();
+            render();
+            frame_stats().end_frame();
+        }
+        // ImGui and code outside the gl library change the GL state directly
+        state_cache().invalidate();
+        present();
+        {
+            GL_PROFILE_SCOPE("frame", "Poll events");
+            glfwPollEvents();
+        }
+    }
+}
+
+bool Application::is_headless() const
+{
+    return headless_context_ != nullptr;
+}
+
+std::uint32_t Application::default_framebuffer() const
+{
+    return offscreen_framebuffer_;
+}
+
+void Application::present()
+{
+    GL_PROFILE_SCOPE("frame", "Present");
+    if (headless_context_)
+    {
+        glFlush();
+    }
+    else
+    {
         glfwSwapBuffers(window_);
-        glfwPollEvents();
     }
 }
 
+Image Application::capture_frame() const
+{
+    assert(headless_context_);
+    return read_framebuffer(offscreen_framebuffer_, width_, height_);
+}
+
+void Application::start_recording()
+{
+    recording_.emplace();
+}
+
+CameraTrack Application::stop_recording()
+{
+    assert(recording_);
+    CameraTrack track{std::move(recording_->track)};
+    recording_.reset();
+    return track;
+}
+
+bool Application::is_recording() const
+{
+    return recording_.has_value();
+}
+
+void Application::record_parameter(std::string_view name, float value)
+{
+    if (recording_)
+    {
+        recording_->track.add_parameter_change(recording_->time, std::string{name}, value);
+    }
+}
+
+void Application::start_playback(CameraTrack track)
+{
+    playback_.emplace(Playback{.track = std::move(track)});
+}
+
+void Application::stop_playback()
+{
+    playback_.reset();
+}
+
+bool Application::is_playing_back() const
+{
+    return playback_.has_value();
+}
+
+void Application::apply_track_parameter(std::string_view /*name*/, float /*value*/)
+{
+}
+
+bool Application::step_playback()
+{
+    assert(playback_);
+    if (playback_->frame >= playback_->track.number_of_frames())
+    {
+        return false;
+    }
+
+    // Times are computed from the frame index rather than accumulated, so they don't drift
+    const double time{static_cast<double>(playback_->frame) * CameraTrack::time_step};
+    CameraTrack::apply(playback_->track.pose_at(time), camera_);
+    const std::vector<CameraTrack::ParameterChange>& changes{playback_->track.parameter_changes()};
+    for (; playback_->next_parameter_change < changes.size() &&
+           changes[playback_->next_parameter_change].time <= time;
+         ++playback_->next_parameter_change)
+    {
+        const CameraTrack::ParameterChange& change = changes[playback_->next_parameter_change];
+        apply_track_parameter(change.name, change.value);
+    }
+
+    ++playback_->frame;
+    return true;
+}
+
 void Application::process_input(float delta_time)
 {
     if (glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -300,13 +519,28 @@ void Application::render()
     render_imgui_editor();
 }
 
+void Application::resize(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    width_ = width;
+    height_ = height;
+    aspect_ratio_ = static_cast<float>(width_) / static_cast<float>(height_);
+    camera_.set_aspect_ratio(aspect_ratio_);
+    state_cache().set_viewport(0, 0, width_, height_);
+}
+
 void Application::reset_viewport()
 {
-    glViewport(current_viewport_[0], current_viewport_[1], current_viewport_[2], current_viewport_[3]);
+    state_cache().set_viewport(current_viewport_[0], current_viewport_[1], current_viewport_[2], current_viewport_[3]);
 }
 
 void Application::render_imgui_editor()
 {
+    GL_PROFILE_SCOPE("frame", "ImGui");
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -2,22 +2,43 @@
 #define APPLICATION_HPP
 
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string_view>
 
 #include <glm/glm.hpp>
 
 #include "camera.hpp"
+#include "camera_track.hpp"
+#include "image.hpp"
+#include "renderbuffer.hpp"
 
 struct GLFWwindow;
 
 namespace gl
 {
 
+// Forward declaration
+class HeadlessContext;
+
+struct ContextSettings
+{
+    /*
+    Renders into an offscreen framebuffer of a surfaceless context instead of
+    a window; input and ImGui aren't available.
+    */
+    bool headless{false};
+    // Samples per pixel of the window's (or offscreen) framebuffer
+    int samples{8};
+    // Creates a debug context and enables its debug output, see DebugOutput
+    bool debug{false};
+};
+
 class Application
 {
 public:
-    Application(int window_width, int window_height, std::string_view title);
+    Application(int window_width, int window_height, std::string_view title, ContextSettings context_settings = {});
     Application(const Application&) = delete;
     Application(Application&&) = delete;
     Application& operator=(const Application&) = delete;
@@ -29,6 +50,8 @@ public:
     virtual void update(float delta_time);
     virtual void render();
     virtual void render_imgui_editor();
+    // Called when the framebuffer of the window is resized; empty sizes (minimized windows) are ignored
+    virtual void resize(int width, int height);
 
     // Functions to interact with GLFW callback functions
     FPSCamera& camera();
@@ -39,15 +62,40 @@ public:
     void switch_free_mouse_movement();
     bool is_mouse_movement_free() const;
 
+    bool is_headless() const;
+    // Framebuffer displayed by the application: the offscreen framebuffer of headless contexts, 0 otherwise
+    std::uint32_t default_framebuffer() const;
+    // Swaps the window's buffers; headless contexts only flush the submitted commands
+    void present();
+    // Reads the frame rendered into the offscreen framebuffer of a headless context
+    Image capture_frame() const;
+
+    /*
+    Camera tracks: while recording, the pose of the camera is recorded on
+    every frame along with the parameters passed to record_parameter().
+    During a playback, the camera follows the track at its fixed time step
+    and ignores the user's input.
+    */
+    void start_recording();
+    // Stops the recording and returns the recorded track
+    CameraTrack stop_recording();
+    bool is_recording() const;
+    // Records the change of a parameter if a track is being recorded
+    void record_parameter(std::string_view name, float value);
+    void start_playback(CameraTrack track);
+    void stop_playback();
+    bool is_playing_back() const;
+
     /*
     Reset viewport to the Application's width and height values
     */
     void reset_viewport();
 
 protected:
-    const int width_;
-    const int height_;
-    const float aspect_ratio_;
+    // Size of the window's framebuffer
+    int width_;
+    int height_;
+    float aspect_ratio_;
 
     std::array<int, 4> current_viewport_{};
     GLFWwindow* window_{nullptr};
@@ -57,12 +105,48 @@ protected:
 
     FPSCamera camera_{glm::vec3{0.0, 0.0f, 3.0f}};
 
+    // Applies the parameter changes of a track during its playback
+    virtual void apply_track_parameter(std::string_view name, float value);
+    /*
+    Poses the camera on the next frame of the playback and applies the
+    parameter changes up to it; returns false once the track has ended.
+    */
+    bool step_playback();
+
 private:
+    struct Recording
+    {
+        CameraTrack track;
+        double time{0.0};
+    };
+
+    struct Playback
+    {
+        CameraTrack track;
+        std::size_t frame{0};
+        std::size_t next_parameter_change{0};
+    };
+
+    std::optional<Recording> recording_{};
+    std::optional<Playback> playback_{};
+
+    std::unique_ptr<HeadlessContext> headless_context_{};
+    std::optional<Renderbuffer> offscreen_color_{};
+    std::optional<Renderbuffer> offscreen_depth_{};
+    std::uint32_t offscreen_framebuffer_{0};
+
     /*
     Create a window and OpenGL context. If creation
     was unsuccesfull, throws a runtime exception.
     */
-    void create_context(std::string_view title);
+    void create_context(std::string_view title, int samples, bool debug);
+
+    /*
+    Create a surfaceless OpenGL context, load its functions and the
+    offscreen framebuffer standing for the window's. Throws a runtime
+    exception if the context can't be created.
+    */
+    void create_headless_context(int samples, bool debug);
 
     /*
     Initializes ImGui
@@ -0,0 +1,196 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <utility>
+
+#include "json.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+double nearest_rank(const std::vector<double>& sorted_values, double percentile)
+{
+    const auto rank =
+        static_cast<std::size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted_values.size())));
+    return sorted_values[std::clamp<std::size_t>(rank, 1, sorted_values.size()) - 1];
+}
+
+void write_summary(std::ostream& stream, const std::vector<double>& durations_ms)
+{
+    const DurationSummary summary{summarize_durations(durations_ms)};
+    stream << "{\"mean\": " << summary.mean_ms << ", \"median\": " << summary.median_ms
+           << ", \"p95\": " << summary.p95_ms << ", \"p99\": " << summary.p99_ms << ", \"max\": " << summary.max_ms
+           << "}";
+}
+
+void write_counters(std::ostream& stream, const BenchmarkReport::Counters& counters)
+{
+    stream << "{";
+    for (std::size_t i = 0; i < counters.size(); ++i)
+    {
+        // Counter names as snake case keys, e.g. "draw_calls"
+        std::string key{FrameStats::counter_name(static_cast<FrameStats::Counter>(i))};
+        std::transform(key.begin(), key.end(), key.begin(), [](char character) {
+            return character == ' ' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+        });
+        stream << (i == 0 ? "\"" : ", \"") << key << "\": " << counters[i];
+    }
+    stream << "}";
+}
+
+// Lower case names of the categories of GPU memory, e.g. "textures"
+std::string category_key(std::size_t category)
+{
+    std::string key{GpuMemoryTracker::category_name(static_cast<GpuMemoryTracker::Category>(category))};
+    std::transform(key.begin(), key.end(), key.begin(), [](char character) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    });
+    return key;
+}
+
+void write_gpu_memory(std::ostream& stream, const GpuMemoryTracker::Snapshot& snapshot)
+{
+    stream << "{\"total_bytes\": " << snapshot.total_bytes << ", \"peak_bytes\": " << snapshot.peak_bytes
+           << ", \"budget_bytes\": ";
+    if (snapshot.budget_bytes)
+    {
+        stream << snapshot.budget_bytes.value();
+    }
+    else
+    {
+        stream << "null";
+    }
+    for (std::size_t category = 0; category < snapshot.totals.size(); ++category)
+    {
+        stream << ", \"" << category_key(category) << "_bytes\": " << snapshot.totals[category];
+    }
+    stream << ",\n   \"owners\": [";
+    for (std::size_t i = 0; i < snapshot.owners.size(); ++i)
+    {
+        const GpuMemoryTracker::OwnerTotals& owner = snapshot.owners[i];
+        stream << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(stream, owner.owner);
+        for (std::size_t category = 0; category < owner.bytes.size(); ++category)
+        {
+            stream << ", \"" << category_key(category) << "_bytes\": " << owner.bytes[category];
+        }
+        stream << ", \"resources\": " << owner.resources << "}";
+    }
+    stream << "\n  ]}";
+}
+
+} // namespace
+
+DurationSummary summarize_durations(std::vector<double> durations_ms)
+{
+    if (durations_ms.empty())
+    {
+        return DurationSummary{};
+    }
+
+    std::sort(durations_ms.begin(), durations_ms.end());
+    return DurationSummary{
+        .mean_ms = std::accumulate(durations_ms.cbegin(), durations_ms.cend(), 0.0) /
+                   static_cast<double>(durations_ms.size()),
+        .median_ms = nearest_rank(durations_ms, 50.0),
+        .p95_ms = nearest_rank(durations_ms, 95.0),
+        .p99_ms = nearest_rank(durations_ms, 99.0),
+        .max_ms = durations_ms.back()};
+}
+
+MannWhitneyResult mann_whitney_u(const std::vector<double>& baseline, const std::vector<double>& current)
+{
+    if (baseline.empty() || current.empty())
+    {
+        return MannWhitneyResult{};
+    }
+
+    // Samples sorted by value, tagged with whether they're current ones
+    std::vector<std::pair<double, bool>> samples;
+    samples.reserve(baseline.size() + current.size());
+    std::transform(baseline.cbegin(), baseline.cend(), std::back_inserter(samples),
+                   [](double value) { return std::pair{value, false}; });
+    std::transform(current.cbegin(), current.cend(), std::back_inserter(samples),
+                   [](double value) { return std::pair{value, true}; });
+    std::sort(samples.begin(), samples.end());
+
+    // Tied samples share the mean of their ranks
+    double current_rank_sum{0.0};
+    double tie_correction{0.0};
+    for (std::size_t first = 0; first < samples.size();)
+    {
+        std::size_t last{first + 1};
+        while (last < samples.size() && samples[last].first == samples[first].first)
+        {
+            ++last;
+        }
+        const double rank{static_cast<double>(first + last + 1) / 2.0};
+        for (std::size_t i = first; i < last; ++i)
+        {
+            current_rank_sum += samples[i].second ? rank : 0.0;
+        }
+        const auto ties = static_cast<double>(last - first);
+        tie_correction += ties * ties * ties - ties;
+        first = last;
+    }
+
+    const auto baseline_size = static_cast<double>(baseline.size());
+    const auto current_size = static_cast<double>(current.size());
+    const auto total_size = baseline_size + current_size;
+    MannWhitneyResult result{.u = current_rank_sum - current_size * (current_size + 1.0) / 2.0};
+    const double variance{baseline_size * current_size / 12.0 *
+                          (total_size + 1.0 - tie_correction / (total_size * (total_size - 1.0)))};
+    if (variance > 0.0)
+    {
+        result.z = (result.u - baseline_size * current_size / 2.0 - 0.5) / std::sqrt(variance);
+        result.p_value = 0.5 * std::erfc(result.z / std::sqrt(2.0));
+    }
+    return result;
+}
+
+void write_json(std::ostream& stream, const BenchmarkReport& report)
+{
+    const auto precision = stream.precision(4);
+    const auto flags = stream.setf(std::ios::fixed, std::ios::floatfield);
+
+    stream << "{\n  \"renderer\": ";
+    write_json_string(stream, report.renderer);
+    stream << ",\n  \"width\": " << report.width << ",\n  \"height\": " << report.height
+           << ",\n  \"samples\": " << report.samples << ",\n  \"frames\": " << report.cpu_frame_ms.size()
+           << ",\n  \"warmup_frames\": " << report.warmup_frames
+           << ",\n  \"dropped_gpu_frames\": " << report.dropped_gpu_frames << ",\n  \"cpu_frame_ms\": ";
+    write_summary(stream, report.cpu_frame_ms);
+    stream << ",\n  \"gpu_frame_ms\": ";
+    write_summary(stream, report.gpu_frame_ms);
+    stream << ",\n  \"frame_counters\": ";
+    write_counters(stream, report.frame_counters);
+    stream << ",\n  \"passes\": [";
+    for (std::size_t i = 0; i < report.passes.size(); ++i)
+    {
+        const BenchmarkReport::Pass& pass = report.passes[i];
+        stream << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(stream, pass.name);
+        stream << ", \"frames\": " << pass.gpu_ms.size() << ",\n     \"cpu_ms\": ";
+        write_summary(stream, pass.cpu_ms);
+        stream << ",\n     \"gpu_ms\": ";
+        write_summary(stream, pass.gpu_ms);
+        stream << ",\n     \"counters\": ";
+        write_counters(stream, pass.counters);
+        stream << "}";
+    }
+    stream << "\n  ],\n  \"gpu_memory\": ";
+    write_gpu_memory(stream, report.gpu_memory);
+    stream << "\n}\n";
+
+    stream.precision(precision);
+    stream.flags(flags);
+}
+
+} // namespace gl
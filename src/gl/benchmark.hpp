@@ -0,0 +1,81 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
+
+namespace gl
+{
+
+// Distribution of a set of durations; percentiles use the nearest-rank method
+struct DurationSummary
+{
+    double mean_ms{0.0};
+    double median_ms{0.0};
+    double p95_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+};
+
+DurationSummary summarize_durations(std::vector<double> durations_ms);
+
+/*
+Mann-Whitney U test of whether the current samples tend to be larger than
+the baseline ones, e.g. whether a pass got slower. Unlike comparing means,
+the test makes no assumption on the distribution of the samples and is
+robust to the outliers of noisy timings. Uses the normal approximation with
+tie and continuity corrections, which requires about 8 samples per side.
+The samples must be independent, e.g. the medians of separate runs rather
+than the times of consecutive frames.
+*/
+struct MannWhitneyResult
+{
+    // U statistic of the current samples
+    double u{0.0};
+    double z{0.0};
+    // One-sided probability of a U at least this large if both sets come from the same distribution
+    double p_value{1.0};
+};
+
+MannWhitneyResult mann_whitney_u(const std::vector<double>& baseline, const std::vector<double>& current);
+
+// Frame and pass times measured by a benchmark run, one value per measured frame
+struct BenchmarkReport
+{
+    // Mean counts per measured frame, indexed by FrameStats::Counter
+    using Counters = std::array<double, FrameStats::number_of_counters>;
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<double> cpu_ms{};
+        std::vector<double> gpu_ms{};
+        Counters counters{};
+    };
+
+    std::string renderer;
+    int width{0};
+    int height{0};
+    int samples{0};
+    std::size_t warmup_frames{0};
+    std::size_t dropped_gpu_frames{0};
+    std::vector<double> cpu_frame_ms{};
+    std::vector<double> gpu_frame_ms{};
+    Counters frame_counters{};
+    std::vector<Pass> passes{};
+    // Video memory of the resources alive at the end of the run
+    GpuMemoryTracker::Snapshot gpu_memory{};
+};
+
+// Writes the settings of the run and the summaries of its frame and pass times as a JSON object
+void write_json(std::ostream& stream, const BenchmarkReport& report);
+
+} // namespace gl
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,63 @@
+#include "bounds.hpp"
+
+namespace gl
+{
+
+bool AABB::empty() const
+{
+    return min_corner.x > max_corner.x || min_corner.y > max_corner.y || min_corner.z > max_corner.z;
+}
+
+glm::vec3 AABB::center() const
+{
+    return 0.5f * (min_corner + max_corner);
+}
+
+glm::vec3 AABB::extents() const
+{
+    return 0.5f * (max_corner - min_corner);
+}
+
+void AABB::expand(const glm::vec3& point)
+{
+    min_corner = glm::min(min_corner, point);
+    max_corner = glm::max(max_corner, point);
+}
+
+void AABB::expand(const AABB& other)
+{
+    min_corner = glm::min(min_corner, other.min_corner);
+    max_corner = glm::max(max_corner, other.max_corner);
+}
+
+AABB AABB::transformed(const glm::mat4& transform) const
+{
+    if (empty())
+    {
+        return *this;
+    }
+
+    // Arvo's method: project the extents onto the absolute value of the linear part
+    const glm::vec3 new_center{transform * glm::vec4{center(), 1.0f}};
+    const glm::vec3 half_extents{extents()};
+    glm::vec3 new_extents{0.0f};
+    for (int column = 0; column < 3; ++column)
+    {
+        new_extents += glm::abs(glm::vec3{transform[column]}) * half_extents[column];
+    }
+
+    return AABB{.min_corner = new_center - new_extents, .max_corner = new_center + new_extents};
+}
+
+AABB compute_bounds(const std::vector<float>& vertices_data, int stride)
+{
+    AABB bounds;
+    for (std::size_t offset = 0; offset + 2 < vertices_data.size(); offset += static_cast<std::size_t>(stride))
+    {
+        bounds.expand(glm::vec3{vertices_data[offset], vertices_data[offset + 1], vertices_data[offset + 2]});
+    }
+
+    return bounds;
+}
+
+} // namespace gl
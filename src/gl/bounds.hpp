@@ -0,0 +1,39 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gl
+{
+
+// Axis-aligned bounding box; a default-constructed box is empty
+struct AABB
+{
+    glm::vec3 min_corner{std::numeric_limits<float>::max()};
+    glm::vec3 max_corner{std::numeric_limits<float>::lowest()};
+
+    bool empty() const;
+    glm::vec3 center() const;
+    glm::vec3 extents() const;
+    void expand(const glm::vec3& point);
+    void expand(const AABB& other);
+
+    /*
+    Returns the box enclosing this box after being transformed
+    by an affine transform (e.g. a model matrix).
+    */
+    AABB transformed(const glm::mat4& transform) const;
+};
+
+/*
+Computes the bounding box of interleaved vertex data, assuming
+that the position is stored in the first three floats of each vertex.
+*/
+AABB compute_bounds(const std::vector<float>& vertices_data, int stride);
+
+} // namespace gl
+
+#endif // BOUNDS_HPP
@@ -195,6 +195,12 @@ float FPSCamera::zoom() const
     return zoom_;
 }
 
+void FPSCamera::set_zoom(float zoom)
+{
+    zoom_ = std::max(std::min(zoom, 45.0f), 1.0f);
+    projection_update_ = true;
+}
+
 void FPSCamera::process_keyboard_input(CameraMovement direction, float delta_time)
 {
     const float velocity = speed_ * delta_time;
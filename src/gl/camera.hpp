@@ -61,6 +61,8 @@ public:
     // Product of view and projection matrices
     const glm::mat4& view_projection();
     float zoom() const;
+    // Field of view in degrees, clamped to the range allowed by mouse scrolling
+    void set_zoom(float zoom);
     void process_keyboard_input(CameraMovement direction, float delta_time);
     void process_mouse_movement(float xoffset, float yoffset);
     void process_mouse_scroll(float yoffset);
@@ -0,0 +1,222 @@
+#include "camera_track.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "camera.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+constexpr std::array<char, 4> magic_number{'G', 'L', 'C', 'T'};
+constexpr std::uint32_t format_version{1};
+
+template <typename T>
+void write_little_endian(std::ostream& stream, T value)
+{
+    for (std::size_t byte = 0; byte < sizeof(T); ++byte)
+    {
+        stream.put(static_cast<char>((value >> (8 * byte)) & 0xFF));
+    }
+}
+
+template <typename T>
+T read_little_endian(std::istream& stream)
+{
+    T value{0};
+    for (std::size_t byte = 0; byte < sizeof(T); ++byte)
+    {
+        const auto character = static_cast<T>(static_cast<unsigned char>(stream.get()));
+        value |= static_cast<T>(character << (8 * byte));
+    }
+    return value;
+}
+
+void write_float(std::ostream& stream, float value)
+{
+    write_little_endian(stream, std::bit_cast<std::uint32_t>(value));
+}
+
+void write_double(std::ostream& stream, double value)
+{
+    write_little_endian(stream, std::bit_cast<std::uint64_t>(value));
+}
+
+float read_float(std::istream& stream)
+{
+    return std::bit_cast<float>(read_little_endian<std::uint32_t>(stream));
+}
+
+double read_double(std::istream& stream)
+{
+    return std::bit_cast<double>(read_little_endian<std::uint64_t>(stream));
+}
+
+} // namespace
+
+CameraTrack::Pose CameraTrack::pose_of(const FPSCamera& camera)
+{
+    return Pose{.position = camera.position(), .pitch_yaw = camera.get_pitch_yaw(), .zoom = camera.zoom()};
+}
+
+void CameraTrack::apply(const Pose& pose, FPSCamera& camera)
+{
+    camera.set_position(pose.position);
+    camera.set_pitch_yaw(pose.pitch_yaw);
+    camera.set_zoom(pose.zoom);
+}
+
+void CameraTrack::add_keyframe(double time, const Pose& pose)
+{
+    assert(keyframes_.empty() || keyframes_.back().time <= time);
+    keyframes_.emplace_back(Keyframe{.time = time, .pose = pose});
+}
+
+void CameraTrack::add_parameter_change(double time, std::string name, float value)
+{
+    assert(parameter_changes_.empty() || parameter_changes_.back().time <= time);
+    parameter_changes_.emplace_back(ParameterChange{.time = time, .name = std::move(name), .value = value});
+}
+
+bool CameraTrack::empty() const
+{
+    return keyframes_.empty();
+}
+
+double CameraTrack::duration() const
+{
+    return keyframes_.empty() ? 0.0 : keyframes_.back().time;
+}
+
+std::size_t CameraTrack::number_of_frames() const
+{
+    return keyframes_.empty() ? 0 : static_cast<std::size_t>(std::floor(duration() / time_step)) + 1;
+}
+
+CameraTrack::Pose CameraTrack::pose_at(double time) const
+{
+    assert(!keyframes_.empty());
+    const auto next = std::upper_bound(keyframes_.cbegin(), keyframes_.cend(), time,
+                                       [](double time, const Keyframe& keyframe) { return time < keyframe.time; });
+    if (next == keyframes_.cbegin())
+    {
+        return keyframes_.front().pose;
+    }
+    if (next == keyframes_.cend())
+    {
+        return keyframes_.back().pose;
+    }
+
+    const Keyframe& previous = *(next - 1);
+    const auto weight = static_cast<float>((time - previous.time) / (next->time - previous.time));
+    return Pose{.position = glm::mix(previous.pose.position, next->pose.position, weight),
+                .pitch_yaw = glm::mix(previous.pose.pitch_yaw, next->pose.pitch_yaw, weight),
+                .zoom = glm::mix(previous.pose.zoom, next->pose.zoom, weight)};
+}
+
+const std::vector<CameraTrack::ParameterChange>& CameraTrack::parameter_changes() const
+{
+    return parameter_changes_;
+}
+
+void CameraTrack::save(std::string_view filename) const
+{
+    std::ofstream file{std::string{filename}, std::ios::binary};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + std::string{filename} + " for writing");
+    }
+
+    file.write(magic_number.data(), magic_number.size());
+    write_little_endian(file, format_version);
+    write_little_endian(file, static_cast<std::uint32_t>(keyframes_.size()));
+    write_little_endian(file, static_cast<std::uint32_t>(parameter_changes_.size()));
+    for (const Keyframe& keyframe : keyframes_)
+    {
+        write_double(file, keyframe.time);
+        for (const float component : {keyframe.pose.position.x, keyframe.pose.position.y, keyframe.pose.position.z,
+                                      keyframe.pose.pitch_yaw.x, keyframe.pose.pitch_yaw.y, keyframe.pose.zoom})
+        {
+            write_float(file, component);
+        }
+    }
+    for (const ParameterChange& change : parameter_changes_)
+    {
+        assert(change.name.size() <= std::numeric_limits<std::uint16_t>::max());
+        write_double(file, change.time);
+        write_float(file, change.value);
+        write_little_endian(file, static_cast<std::uint16_t>(change.name.size()));
+        file.write(change.name.data(), static_cast<std::streamsize>(change.name.size()));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error("Failure to write file " + std::string{filename});
+    }
+}
+
+CameraTrack CameraTrack::load(std::string_view filename)
+{
+    std::ifstream file{std::string{filename}, std::ios::binary};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + std::string{filename});
+    }
+
+    const auto invalid_track = [&filename]() {
+        return std::runtime_error("File " + std::string{filename} + " isn't a valid camera track");
+    };
+
+    std::array<char, 4> magic{};
+    file.read(magic.data(), magic.size());
+    if (!file || magic != magic_number || read_little_endian<std::uint32_t>(file) != format_version)
+    {
+        throw invalid_track();
+    }
+
+    const auto number_of_keyframes = read_little_endian<std::uint32_t>(file);
+    const auto number_of_parameter_changes = read_little_endian<std::uint32_t>(file);
+    CameraTrack track;
+    for (std::uint32_t i = 0; i < number_of_keyframes && file; ++i)
+    {
+        Keyframe keyframe{.time = read_double(file)};
+        keyframe.pose.position = glm::vec3{read_float(file), read_float(file), read_float(file)};
+        keyframe.pose.pitch_yaw = glm::vec2{read_float(file), read_float(file)};
+        keyframe.pose.zoom = read_float(file);
+        if (!track.keyframes_.empty() && !(track.keyframes_.back().time <= keyframe.time))
+        {
+            throw invalid_track();
+        }
+        track.keyframes_.emplace_back(keyframe);
+    }
+    for (std::uint32_t i = 0; i < number_of_parameter_changes && file; ++i)
+    {
+        ParameterChange change{.time = read_double(file)};
+        change.value = read_float(file);
+        change.name.resize(read_little_endian<std::uint16_t>(file));
+        file.read(change.name.data(), static_cast<std::streamsize>(change.name.size()));
+        if (!track.parameter_changes_.empty() && !(track.parameter_changes_.back().time <= change.time))
+        {
+            throw invalid_track();
+        }
+        track.parameter_changes_.emplace_back(std::move(change));
+    }
+
+    if (!file)
+    {
+        throw invalid_track();
+    }
+    return track;
+}
+
+} // namespace gl
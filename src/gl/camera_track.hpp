@@ -0,0 +1,84 @@
+#ifndef CAMERA_TRACK_HPP
+#define CAMERA_TRACK_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gl
+{
+
+// Forward declaration
+class FPSCamera;
+
+/*
+Recorded camera poses and parameter changes (e.g. post-processing
+coefficients changed through the UI), timed in seconds from the start of
+the recording. Tracks are played back at a fixed time step, interpolating
+the recorded poses, so that a track renders the same frames on every run
+regardless of the frame rate of the recording or of the playback.
+
+Tracks are stored in a compact binary format; see save().
+*/
+class CameraTrack
+{
+public:
+    static constexpr double time_step{1.0 / 60.0};
+
+    struct Pose
+    {
+        glm::vec3 position{0.0f};
+        glm::vec2 pitch_yaw{0.0f};
+        float zoom{45.0f};
+    };
+
+    struct Keyframe
+    {
+        double time{0.0};
+        Pose pose{};
+    };
+
+    struct ParameterChange
+    {
+        double time{0.0};
+        std::string name;
+        float value{0.0f};
+    };
+
+    static Pose pose_of(const FPSCamera& camera);
+    static void apply(const Pose& pose, FPSCamera& camera);
+
+    // Times must not decrease between calls
+    void add_keyframe(double time, const Pose& pose);
+    void add_parameter_change(double time, std::string name, float value);
+
+    bool empty() const;
+    double duration() const;
+    // Number of frames rendered by a playback at the fixed time step
+    std::size_t number_of_frames() const;
+    // Pose linearly interpolated between the keyframes surrounding the given time
+    Pose pose_at(double time) const;
+    const std::vector<ParameterChange>& parameter_changes() const;
+
+    /*
+    Writes the track as little-endian binary data: the "GLCT" magic number,
+    the format version, the number of keyframes and of parameter changes as
+    32-bit integers, then each keyframe (a double time and six floats) and
+    each parameter change (a double time, a float value, a 16-bit name length
+    and the name). Throws if the file can't be written.
+    */
+    void save(std::string_view filename) const;
+    // Throws if the file can't be read or isn't a valid track
+    static CameraTrack load(std::string_view filename);
+
+private:
+    std::vector<Keyframe> keyframes_{};
+    std::vector<ParameterChange> parameter_changes_{};
+};
+
+} // namespace gl
+
+#endif // CAMERA_TRACK_HPP
@@ -0,0 +1,215 @@
+#include "cpu_profiler.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "json.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+// Phases are also recorded as events of this category
+constexpr const char* phase_category{"startup"};
+
+} // namespace
+
+CpuProfiler::Scope::Scope(const char* category, const char* name) :
+    category_{category}, name_{name}, start_ns_{cpu_profiler().now_ns()}
+{
+}
+
+CpuProfiler::Scope::Scope(const char* category, std::string_view name) :
+    category_{category}, name_{cpu_profiler().intern(name)}, start_ns_{cpu_profiler().now_ns()}
+{
+}
+
+CpuProfiler::Scope::~Scope()
+{
+    cpu_profiler().record(category_, name_, start_ns_);
+}
+
+CpuProfiler::PhaseScope::PhaseScope(const char* name) : name_{name}, start_ns_{cpu_profiler().now_ns()}
+{
+}
+
+CpuProfiler::PhaseScope::~PhaseScope()
+{
+    CpuProfiler& profiler = cpu_profiler();
+    const std::uint64_t duration_ns{profiler.now_ns() - start_ns_};
+    profiler.record(phase_category, name_, start_ns_);
+
+    const std::lock_guard lock{profiler.mutex_};
+    profiler.phases_.emplace_back(Phase{.name = name_, .duration_ms = static_cast<double>(duration_ns) / 1.0e6});
+}
+
+CpuProfiler::CpuProfiler() : epoch_{std::chrono::steady_clock::now()}
+{
+}
+
+void CpuProfiler::set_thread_name(std::string_view name)
+{
+    ThreadBuffer& buffer = thread_buffer();
+    const std::lock_guard lock{mutex_};
+    buffer.thread_name = name;
+}
+
+std::vector<CpuProfiler::Phase> CpuProfiler::phases() const
+{
+    const std::lock_guard lock{mutex_};
+    return phases_;
+}
+
+std::size_t CpuProfiler::recorded_events() const
+{
+    const std::lock_guard lock{mutex_};
+    std::size_t events{0};
+    for (const auto& buffer : thread_buffers_)
+    {
+        const std::size_t size{buffer->size.load(std::memory_order_acquire)};
+        events += size - first_retained_event(size);
+    }
+    return events;
+}
+
+std::size_t CpuProfiler::overwritten_events() const
+{
+    const std::lock_guard lock{mutex_};
+    std::size_t events{0};
+    for (const auto& buffer : thread_buffers_)
+    {
+        events += first_retained_event(buffer->size.load(std::memory_order_acquire));
+    }
+    return events;
+}
+
+void CpuProfiler::export_chrome_trace(std::string_view filename) const
+{
+    std::ofstream file{std::string{filename}};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + std::string{filename} + " for writing");
+    }
+
+    // Timestamps and durations of the trace event format are in microseconds
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first_event{true};
+    const auto separate = [&file, &first_event]() {
+        file << (first_event ? "\n" : ",\n");
+        first_event = false;
+    };
+
+    const std::lock_guard lock{mutex_};
+    for (const auto& buffer : thread_buffers_)
+    {
+        separate();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+             << ",\"args\":{\"name\":";
+        write_json_string(file, buffer->thread_name.empty() ? "Thread " + std::to_string(buffer->thread_id)
+                                                            : buffer->thread_name);
+        file << "}}";
+
+        // The lock keeps the owning thread from recycling the chunks read here
+        const std::size_t size{buffer->size.load(std::memory_order_acquire)};
+        for (std::size_t i = first_retained_event(size); i < size; ++i)
+        {
+            const Chunk* chunk =
+                buffer->chunks[(i / events_per_chunk) % max_chunks_per_thread].load(std::memory_order_acquire);
+            const Event& event = chunk->events[i % events_per_chunk];
+            separate();
+            file << "{\"name\":";
+            write_json_string(file, event.name);
+            file << ",\"cat\":";
+            write_json_string(file, event.category);
+            file << ",\"ph\":\"X\",\"ts\":" << static_cast<double>(event.start_ns) / 1.0e3
+                 << ",\"dur\":" << static_cast<double>(event.duration_ns) / 1.0e3 << ",\"pid\":1,\"tid\":"
+                 << buffer->thread_id << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file)
+    {
+        throw std::runtime_error("Failure to write file " + std::string{filename});
+    }
+}
+
+std::size_t CpuProfiler::first_retained_event(std::size_t size)
+{
+    if (size < max_events_per_thread)
+    {
+        return 0;
+    }
+    // The chunk being written holds the newest events followed by the oldest ones, which it's overwriting
+    return size / events_per_chunk * events_per_chunk + events_per_chunk - max_events_per_thread;
+}
+
+std::uint64_t CpuProfiler::now_ns() const
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count());
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::thread_buffer()
+{
+    // Buffers are registered on the first event of each thread; only the registration takes the lock
+    thread_local ThreadBuffer* buffer{nullptr};
+    if (buffer == nullptr)
+    {
+        const std::lock_guard lock{mutex_};
+        auto& registered_buffer = thread_buffers_.emplace_back(std::make_unique<ThreadBuffer>());
+        registered_buffer->thread_id = static_cast<std::uint32_t>(thread_buffers_.size());
+        buffer = registered_buffer.get();
+    }
+    return *buffer;
+}
+
+void CpuProfiler::record(const char* category, const char* name, std::uint64_t start_ns)
+{
+    const std::uint64_t end_ns{now_ns()};
+    ThreadBuffer& buffer = thread_buffer();
+
+    // Only the owning thread writes its buffer, so relaxed loads of its own counters are enough
+    const std::size_t index{buffer.size.load(std::memory_order_relaxed)};
+    const std::size_t chunk_index{(index / events_per_chunk) % max_chunks_per_thread};
+    Chunk* chunk = buffer.chunks[chunk_index].load(std::memory_order_relaxed);
+    if (chunk == nullptr)
+    {
+        chunk = buffer.owned_chunks.emplace_back(std::make_unique<Chunk>()).get();
+        buffer.chunks[chunk_index].store(chunk, std::memory_order_release);
+    }
+
+    const bool recycles_chunk{index >= max_events_per_thread && index % events_per_chunk == 0};
+    const Event event{.category = category, .name = name, .start_ns = start_ns, .duration_ns = end_ns - start_ns};
+    if (recycles_chunk)
+    {
+        // The oldest chunk may be read by an export, which holds the lock until it's done
+        const std::lock_guard lock{mutex_};
+        chunk->events[0] = event;
+        buffer.size.store(index + 1, std::memory_order_release);
+        return;
+    }
+
+    chunk->events[index % events_per_chunk] = event;
+    // Publishes the event to the export
+    buffer.size.store(index + 1, std::memory_order_release);
+}
+
+const char* CpuProfiler::intern(std::string_view name)
+{
+    // Nodes of unordered_set are never moved, so the names remain valid while new ones are inserted
+    ThreadBuffer& buffer = thread_buffer();
+    return buffer.interned_names.emplace(name).first->c_str();
+}
+
+CpuProfiler& cpu_profiler()
+{
+    static CpuProfiler profiler{};
+    return profiler;
+}
+
+} // namespace gl
@@ -0,0 +1,163 @@
+#ifndef CPU_PROFILER_HPP
+#define CPU_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace gl
+{
+
+/*
+Records the CPU time of named scopes as complete events that can be exported
+in the Chrome trace event format, which Perfetto and chrome://tracing open.
+
+Each thread appends its events to its own buffer, made of fixed-size chunks
+that are never moved, so recording takes no lock and the export can read
+the events published by every thread while they keep recording. Buffers
+are kept by the profiler after their thread exits. A full buffer is a ring:
+its oldest chunk is recycled for the newest events, so long sessions keep
+their latest events. Recycling a chunk takes the lock, which waits for an
+export in progress to finish reading it.
+
+Scopes are declared with the GL_PROFILE_* macros, which expand to nothing
+unless the gl library is built with GL_ENABLE_CPU_PROFILER.
+*/
+class CpuProfiler
+{
+public:
+    static constexpr std::size_t events_per_chunk{4096};
+    static constexpr std::size_t max_chunks_per_thread{256};
+    static constexpr std::size_t max_events_per_thread{events_per_chunk * max_chunks_per_thread};
+
+    // Scope measured once, e.g. a startup phase of the application
+    struct Phase
+    {
+        std::string name;
+        double duration_ms{0.0};
+    };
+
+    class Scope
+    {
+    public:
+        Scope(const char* category, const char* name);
+        Scope(const char* category, std::string_view name);
+        Scope(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+        ~Scope();
+
+    private:
+        const char* category_;
+        const char* name_;
+        std::uint64_t start_ns_;
+    };
+
+    // Scope whose duration is also kept as a phase, listed separately from the events
+    class PhaseScope
+    {
+    public:
+        explicit PhaseScope(const char* name);
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope(PhaseScope&&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+        PhaseScope& operator=(PhaseScope&&) = delete;
+        ~PhaseScope();
+
+    private:
+        const char* name_;
+        std::uint64_t start_ns_;
+    };
+
+    CpuProfiler();
+    CpuProfiler(const CpuProfiler&) = delete;
+    CpuProfiler(CpuProfiler&&) = delete;
+    CpuProfiler& operator=(const CpuProfiler&) = delete;
+    CpuProfiler& operator=(CpuProfiler&&) = delete;
+    ~CpuProfiler() = default;
+
+    // Names the calling thread in the exported trace
+    void set_thread_name(std::string_view name);
+
+    std::vector<Phase> phases() const;
+    // Events kept by the buffers, and events overwritten by newer ones once the buffers were full
+    std::size_t recorded_events() const;
+    std::size_t overwritten_events() const;
+    // Writes the events of every thread as a Chrome trace; throws if the file can't be written
+    void export_chrome_trace(std::string_view filename) const;
+
+private:
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        std::uint64_t start_ns;
+        std::uint64_t duration_ns;
+    };
+
+    struct Chunk
+    {
+        std::array<Event, events_per_chunk> events;
+    };
+
+    struct ThreadBuffer
+    {
+        std::uint32_t thread_id{0};
+        std::string thread_name{};
+        std::array<std::atomic<Chunk*>, max_chunks_per_thread> chunks{};
+        std::vector<std::unique_ptr<Chunk>> owned_chunks{};
+        // Events published to the export since the thread started recording, written only by the owning thread
+        std::atomic<std::size_t> size{0};
+        // Storage of the names that aren't string literals (e.g. render pass names)
+        std::unordered_set<std::string> interned_names{};
+    };
+
+    const std::chrono::steady_clock::time_point epoch_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers_{};
+    std::vector<Phase> phases_{};
+
+    // Index of the first event of a buffer of a given size that the export can read
+    static std::size_t first_retained_event(std::size_t size);
+
+    std::uint64_t now_ns() const;
+    ThreadBuffer& thread_buffer();
+    void record(const char* category, const char* name, std::uint64_t start_ns);
+    const char* intern(std::string_view name);
+};
+
+CpuProfiler& cpu_profiler();
+
+} // namespace gl
+
+#ifdef GL_ENABLE_CPU_PROFILER
+#define GL_PROFILE_CONCATENATE_IMPL(lhs, rhs) lhs##rhs
+#define GL_PROFILE_CONCATENATE(lhs, rhs) GL_PROFILE_CONCATENATE_IMPL(lhs, rhs)
+// Measures the enclosing scope; the name must be a string literal
+#define GL_PROFILE_SCOPE(category, name)                                                                              \
+    const gl::CpuProfiler::Scope GL_PROFILE_CONCATENATE(profile_scope_, __LINE__) { category, name }
+// Measures the enclosing scope under a name built at runtime, which is copied once per thread
+#define GL_PROFILE_SCOPE_DYNAMIC(category, name)                                                                      \
+    const gl::CpuProfiler::Scope GL_PROFILE_CONCATENATE(profile_scope_, __LINE__)                                     \
+    {                                                                                                                 \
+        category, std::string_view { name }                                                                           \
+    }
+#define GL_PROFILE_PHASE(name)                                                                                        \
+    const gl::CpuProfiler::PhaseScope GL_PROFILE_CONCATENATE(profile_phase_, __LINE__) { name }
+#define GL_PROFILE_THREAD_NAME(name) gl::cpu_profiler().set_thread_name(name)
+#else
+#define GL_PROFILE_SCOPE(category, name) static_cast<void>(0)
+#define GL_PROFILE_SCOPE_DYNAMIC(category, name) static_cast<void>(0)
+#define GL_PROFILE_PHASE(name) static_cast<void>(0)
+#define GL_PROFILE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+#endif // CPU_PROFILER_HPP
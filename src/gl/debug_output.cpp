@@ -0,0 +1,201 @@
+#include "debug_output.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "frame_stats.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+// Minimum GL_MAX_LABEL_LENGTH required by the specification, including the null terminator
+constexpr std::size_t max_label_length{256};
+
+DebugOutput::MessageType to_message_type(GLenum type)
+{
+    switch (type)
+    {
+    case GL_DEBUG_TYPE_ERROR:
+        return DebugOutput::MessageType::Error;
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+        return DebugOutput::MessageType::DeprecatedBehavior;
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+        return DebugOutput::MessageType::UndefinedBehavior;
+    case GL_DEBUG_TYPE_PORTABILITY:
+        return DebugOutput::MessageType::Portability;
+    case GL_DEBUG_TYPE_PERFORMANCE:
+        return DebugOutput::MessageType::Performance;
+    default:
+        return DebugOutput::MessageType::Other;
+    }
+}
+
+std::string_view severity_name(GLenum severity)
+{
+    switch (severity)
+    {
+    case GL_DEBUG_SEVERITY_HIGH:
+        return "high";
+    case GL_DEBUG_SEVERITY_MEDIUM:
+        return "medium";
+    case GL_DEBUG_SEVERITY_LOW:
+        return "low";
+    default:
+        return "notification";
+    }
+}
+
+} // namespace
+
+DebugOutput::Group::Group(std::string_view name)
+{
+    if (debug_output().is_enabled())
+    {
+        const std::size_t length{std::min(name.size(), max_label_length - 1)};
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, static_cast<GLsizei>(length), name.data());
+        pushed_ = true;
+    }
+}
+
+DebugOutput::Group::~Group()
+{
+    if (pushed_)
+    {
+        glPopDebugGroup();
+    }
+}
+
+void DebugOutput::enable()
+{
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(callback, this);
+    // Debug groups are echoed as messages, which would only repeat the pass names
+    for (const GLenum type : {GL_DEBUG_TYPE_PUSH_GROUP, GL_DEBUG_TYPE_POP_GROUP, GL_DEBUG_TYPE_MARKER})
+    {
+        glDebugMessageControl(GL_DONT_CARE, type, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    }
+    enabled_ = true;
+
+    GLint context_flags{0};
+    glGetIntegerv(GL_CONTEXT_FLAGS, &context_flags);
+    if ((context_flags & GL_CONTEXT_FLAG_DEBUG_BIT) == 0)
+    {
+        std::cerr << "Debug output enabled on a context without the debug flag; some messages may be missing\n";
+    }
+}
+
+bool DebugOutput::is_enabled() const
+{
+    return enabled_;
+}
+
+void DebugOutput::label(GLenum identifier, std::uint32_t name, std::string_view label) const
+{
+    if (!enabled_ || name == 0)
+    {
+        return;
+    }
+
+    const std::size_t length{std::min(label.size(), max_label_length - 1)};
+    glObjectLabel(identifier, name, static_cast<GLsizei>(length), label.data());
+}
+
+const DebugOutput::Counts& DebugOutput::counts() const
+{
+    return counts_;
+}
+
+const std::vector<DebugOutput::Message>& DebugOutput::log() const
+{
+    return log_;
+}
+
+void DebugOutput::clear()
+{
+    counts_.fill(0);
+    log_.clear();
+    log_indices_.clear();
+}
+
+void DebugOutput::write_log(std::ostream& stream) const
+{
+    for (const Message& message : log_)
+    {
+        stream << "GL " << type_name(message.type) << " (" << severity_name(message.severity) << ", id "
+               << message.id << ", " << message.count << "x): " << message.text << '\n';
+    }
+}
+
+std::string_view DebugOutput::type_name(MessageType type)
+{
+    switch (type)
+    {
+    case MessageType::Error:
+        return "Error";
+    case MessageType::DeprecatedBehavior:
+        return "Deprecated behavior";
+    case MessageType::UndefinedBehavior:
+        return "Undefined behavior";
+    case MessageType::Portability:
+        return "Portability";
+    case MessageType::Performance:
+        return "Performance";
+    case MessageType::Other:
+        return "Other";
+    default:
+        return "Unknown";
+    }
+}
+
+void APIENTRY DebugOutput::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                    const GLchar* message, const void* user_parameter)
+{
+    // Messages are null-terminated when the length is negative
+    const std::string_view text{length < 0 ? std::string_view{message}
+                                           : std::string_view{message, static_cast<std::size_t>(length)}};
+    static_cast<DebugOutput*>(const_cast<void*>(user_parameter))->add_message(source, type, id, severity, text);
+}
+
+void DebugOutput::add_message(GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view text)
+{
+    const MessageType message_type{to_message_type(type)};
+    ++counts_[static_cast<std::size_t>(message_type)];
+    if (message_type == MessageType::Performance)
+    {
+        frame_stats().add(FrameStats::Counter::PerformanceWarnings);
+    }
+
+    // Drivers often end messages with a new line
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+    {
+        text.remove_suffix(1);
+    }
+
+    const auto [index, inserted] =
+        log_indices_.try_emplace(std::tuple{source, message_type, id, std::string{text}}, log_.size());
+    if (inserted)
+    {
+        log_.emplace_back(
+            Message{.source = source, .type = message_type, .id = id, .severity = severity, .text = std::string{text}});
+        // Errors are printed as they happen; the other messages are only logged
+        if (message_type == MessageType::Error || message_type == MessageType::UndefinedBehavior ||
+            severity == GL_DEBUG_SEVERITY_HIGH)
+        {
+            std::cerr << "GL " << type_name(message_type) << " (" << severity_name(severity) << ", id " << id
+                      << "): " << text << '\n';
+        }
+    }
+    ++log_[index->second].count;
+}
+
+DebugOutput& debug_output()
+{
+    thread_local DebugOutput output{};
+    return output;
+}
+
+} // namespace gl
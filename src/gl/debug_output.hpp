@@ -0,0 +1,111 @@
+#ifndef DEBUG_OUTPUT_HPP
+#define DEBUG_OUTPUT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gl
+{
+
+/*
+Debug output of the context (KHR_debug, core since OpenGL 4.3). Once
+enabled, the driver reports errors, undefined behavior and performance
+warnings (shader recompiles, shadow copies, implicit synchronizations...)
+through a callback. The output is synchronous, so that messages are
+reported during the call causing them and attributed to the pass issuing
+it. Messages are deduplicated into a log counting their occurrences.
+
+While enabled, objects are labeled and render graph passes are pushed as
+debug groups, which name them in the messages and in graphics debuggers;
+labels and groups are skipped while disabled. Like the state cache, there's
+one per thread, for the context current on the thread.
+*/
+class DebugOutput
+{
+public:
+    enum class MessageType
+    {
+        Error = 0,
+        DeprecatedBehavior,
+        UndefinedBehavior,
+        Portability,
+        Performance,
+        Other,
+        Count
+    };
+
+    static constexpr std::size_t number_of_message_types{static_cast<std::size_t>(MessageType::Count)};
+    // Number of messages indexed by MessageType, counting repeated messages
+    using Counts = std::array<std::uint64_t, number_of_message_types>;
+
+    struct Message
+    {
+        GLenum source{GL_DEBUG_SOURCE_API};
+        MessageType type{MessageType::Other};
+        GLuint id{0};
+        GLenum severity{GL_DEBUG_SEVERITY_NOTIFICATION};
+        std::string text;
+        std::uint64_t count{0};
+    };
+
+    // Pushes a debug group for its lifetime
+    class Group
+    {
+    public:
+        explicit Group(std::string_view name);
+        Group(const Group&) = delete;
+        Group(Group&&) = delete;
+        Group& operator=(const Group&) = delete;
+        Group& operator=(Group&&) = delete;
+        ~Group();
+
+    private:
+        bool pushed_{false};
+    };
+
+    /*
+    Installs the message callback on the current context. Contexts created
+    without the debug flag may report fewer messages, or none.
+    */
+    void enable();
+    bool is_enabled() const;
+
+    // identifier is the namespace of the object, e.g. GL_TEXTURE or GL_BUFFER
+    void label(GLenum identifier, std::uint32_t name, std::string_view label) const;
+
+    const Counts& counts() const;
+    // Unique messages in order of first occurrence
+    const std::vector<Message>& log() const;
+    void clear();
+    // Prints the unique messages with their number of occurrences
+    void write_log(std::ostream& stream) const;
+
+    static std::string_view type_name(MessageType type);
+
+private:
+    bool enabled_{false};
+    Counts counts_{};
+    std::vector<Message> log_{};
+    // Index in the log of the messages, by source, type, identifier and text
+    std::map<std::tuple<GLenum, MessageType, GLuint, std::string>, std::size_t> log_indices_{};
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                  const GLchar* message, const void* user_parameter);
+    void add_message(GLenum source, GLenum type, GLuint id, GLenum severity, std::string_view text);
+};
+
+// Debug output of the context current on the calling thread
+DebugOutput& debug_output();
+
+} // namespace gl
+
+#endif // DEBUG_OUTPUT_HPP
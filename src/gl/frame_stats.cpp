@@ -0,0 +1,84 @@
+#include "frame_stats.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace gl
+{
+
+FrameStats::FrameStats()
+{
+    passes_.emplace_back(PassCounters{.name = std::string{unassigned_pass}});
+}
+
+void FrameStats::begin_frame()
+{
+    passes_.resize(1);
+    passes_.front().counters.fill(0);
+    current_pass_ = 0;
+}
+
+void FrameStats::end_frame()
+{
+    end_pass();
+    last_frame_ = passes_;
+}
+
+void FrameStats::begin_pass(std::string_view name)
+{
+    passes_.emplace_back(PassCounters{.name = std::string{name}});
+    current_pass_ = passes_.size() - 1;
+}
+
+void FrameStats::end_pass()
+{
+    current_pass_ = 0;
+}
+
+const std::vector<FrameStats::PassCounters>& FrameStats::last_frame() const
+{
+    return last_frame_;
+}
+
+FrameStats::Counters FrameStats::last_frame_total() const
+{
+    Counters total{};
+    for (const PassCounters& pass : last_frame_)
+    {
+        std::transform(total.cbegin(), total.cend(), pass.counters.cbegin(), total.begin(), std::plus<>{});
+    }
+    return total;
+}
+
+std::string_view FrameStats::counter_name(Counter counter)
+{
+    switch (counter)
+    {
+    case Counter::DrawCalls:
+        return "Draw calls";
+    case Counter::Triangles:
+        return "Triangles";
+    case Counter::ProgramBinds:
+        return "Program binds";
+    case Counter::TextureBinds:
+        return "Texture binds";
+    case Counter::FramebufferBinds:
+        return "Framebuffer binds";
+    case Counter::UniformUploads:
+        return "Uniform uploads";
+    case Counter::BufferBytes:
+        return "Buffer bytes";
+    case Counter::PerformanceWarnings:
+        return "Performance warnings";
+    default:
+        return "Unknown";
+    }
+}
+
+FrameStats& frame_stats()
+{
+    thread_local FrameStats stats{};
+    return stats;
+}
+
+} // namespace gl
@@ -0,0 +1,84 @@
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gl
+{
+
+/*
+Counts the work submitted by the gl library on every frame: draw calls,
+triangles, bound programs, textures and framebuffers, uniform uploads and
+bytes uploaded to buffers, broken down by the render graph pass submitting
+them. Binds are counted as requested by the renderer; the state cache
+reports how many of them actually reached the driver.
+
+Like the state cache, there's a registry per thread, counting the work of
+the context current on the thread.
+*/
+class FrameStats
+{
+public:
+    enum class Counter
+    {
+        DrawCalls = 0,
+        // Triangles of the draws whose size is known on the CPU (GPU-driven draws aren't counted)
+        Triangles,
+        ProgramBinds,
+        TextureBinds,
+        FramebufferBinds,
+        UniformUploads,
+        BufferBytes,
+        // Performance messages of the driver's debug output, which is only enabled in debug mode
+        PerformanceWarnings,
+        Count
+    };
+
+    static constexpr std::size_t number_of_counters{static_cast<std::size_t>(Counter::Count)};
+    using Counters = std::array<std::uint64_t, number_of_counters>;
+
+    struct PassCounters
+    {
+        std::string name;
+        Counters counters{};
+    };
+
+    // Name of the counts submitted outside of any pass (e.g. uploads while loading)
+    static constexpr std::string_view unassigned_pass{"Outside passes"};
+
+    FrameStats();
+
+    void add(Counter counter, std::uint64_t value = 1)
+    {
+        passes_[current_pass_].counters[static_cast<std::size_t>(counter)] += value;
+    }
+
+    // Resets the counts, e.g. discarding the uploads made while loading the scene
+    void begin_frame();
+    // Publishes the counts of the frame as the last frame's
+    void end_frame();
+    void begin_pass(std::string_view name);
+    void end_pass();
+
+    // Counts of the last complete frame, by pass in submission order; counts outside passes come first
+    const std::vector<PassCounters>& last_frame() const;
+    Counters last_frame_total() const;
+    static std::string_view counter_name(Counter counter);
+
+private:
+    std::vector<PassCounters> passes_{};
+    std::vector<PassCounters> last_frame_{};
+    std::size_t current_pass_{0};
+};
+
+// Frame statistics of the context current on the calling thread
+FrameStats& frame_stats();
+
+} // namespace gl
+
+#endif // FRAME_STATS_HPP
@@ -4,6 +4,9 @@
 #include <exception>
 #include <iostream>
 
+#include "frame_stats.hpp"
+#include "state.hpp"
+
 namespace gl
 {
 
@@ -70,6 +73,7 @@ Framebuffer& Framebuffer::operator=(Framebuffer&& other) noexcept
 
 Framebuffer::~Framebuffer()
 {
+    state_cache().forget_framebuffer(id_);
     glDeleteFramebuffers(1, &id_);
 }
 
@@ -81,14 +85,15 @@ void Framebuffer::clear()
 
 void Framebuffer::bind()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, id_);
-    glViewport(0, 0, width_, height_);
+    frame_stats().add(FrameStats::Counter::FramebufferBinds);
+    state_cache().bind_framebuffer(id_);
+    state_cache().set_viewport(0, 0, static_cast<GLsizei>(width_), static_cast<GLsizei>(height_));
     clear();
 }
 
 void Framebuffer::unbind()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state_cache().bind_framebuffer(0);
 }
 
 std::uint32_t Framebuffer::width() const
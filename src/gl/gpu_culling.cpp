@@ -0,0 +1,379 @@
+#include "gpu_culling.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "debug_output.hpp"
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
+#include "model.hpp"
+#include "state.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+// Layout defined by the OpenGL specification for glMultiDrawArraysIndirect
+struct DrawArraysIndirectCommand
+{
+    std::uint32_t count;
+    std::uint32_t instance_count;
+    std::uint32_t first;
+    std::uint32_t base_instance;
+};
+
+// std430 layout of the bounds read by the culling compute shader
+struct DrawBounds
+{
+    glm::vec4 min_corner;
+    glm::vec4 max_corner;
+};
+
+// Values of the "cull_pass" uniform of the culling compute shader
+constexpr int early_cull_pass{0};
+constexpr int late_cull_pass{1};
+constexpr int frustum_cull_pass{2};
+
+// Attribute location of the per-draw identifier
+constexpr GLuint draw_id_location{3};
+
+constexpr std::uint32_t culling_work_group_size{64};
+constexpr std::uint32_t hi_z_work_group_size{8};
+
+GLsizei number_of_mip_levels(std::uint32_t width, std::uint32_t height)
+{
+    GLsizei levels{1};
+    for (std::uint32_t dimension = std::max(width, height); dimension > 1; dimension /= 2)
+    {
+        ++levels;
+    }
+
+    return levels;
+}
+
+Texture create_pyramid(std::uint32_t width, std::uint32_t height)
+{
+    const GpuMemoryTracker::OwnerScope owner{"Hi-Z pyramid"};
+    Texture pyramid{width, height,
+                    Texture::Attributes{.wrap_s = GL_CLAMP_TO_EDGE,
+                                        .wrap_t = GL_CLAMP_TO_EDGE,
+                                        .min_filter = GL_NEAREST_MIPMAP_NEAREST,
+                                        .mag_filter = GL_NEAREST,
+                                        .internal_format = GL_R32F,
+                                        .pixel_data_format = GL_RED,
+                                        .pixel_data_type = GL_FLOAT,
+                                        .mip_levels = number_of_mip_levels(width, height)}};
+    debug_output().label(GL_TEXTURE, pyramid.id(), "Hi-Z pyramid");
+    return pyramid;
+}
+
+} // namespace
+
+HiZPyramid::HiZPyramid() :
+    downsample_shader_{std::initializer_list<ShaderInfo>{{"assets/shaders/hi_z/compute.glsl", Shader::Type::Compute}}}
+{
+}
+
+void HiZPyramid::build(Texture& depth)
+{
+    // The depth is resized along with the window and the occlusion scale
+    if (!pyramid_ || depth.width() != pyramid_->width() || depth.height() != pyramid_->height())
+    {
+        pyramid_.emplace(create_pyramid(depth.width(), depth.height()));
+    }
+
+    downsample_shader_.use();
+    depth.bind(0);
+
+    std::uint32_t level_width{pyramid_->width()};
+    std::uint32_t level_height{pyramid_->height()};
+    for (GLint level = 0; level < pyramid_->mip_levels(); ++level)
+    {
+        // Level 0 is copied from the depth texture; the remaining levels reduce the previous one
+        pyramid_->bind_image(0, GL_READ_ONLY, std::max(level - 1, 0));
+        pyramid_->bind_image(1, GL_WRITE_ONLY, level);
+        downsample_shader_.set_int_uniform("level", level);
+        glDispatchCompute((level_width + hi_z_work_group_size - 1) / hi_z_work_group_size,
+                          (level_height + hi_z_work_group_size - 1) / hi_z_work_group_size, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        level_width = std::max(level_width / 2, 1u);
+        level_height = std::max(level_height / 2, 1u);
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void HiZPyramid::bind(std::uint32_t texture_unit)
+{
+    pyramid_.value().bind(texture_unit);
+}
+
+const Texture& HiZPyramid::texture() const
+{
+    return pyramid_.value();
+}
+
+GpuDrivenModel::GpuDrivenModel(Model& model) :
+    culling_shader_{
+        std::initializer_list<ShaderInfo>{{"assets/shaders/culling/compute.glsl", Shader::Type::Compute}}}
+{
+    std::vector<MeshRenderData*> draws;
+    for (auto& mesh_data : model.opaque_render_data())
+    {
+        draws.emplace_back(&mesh_data);
+    }
+
+    if (draws.empty())
+    {
+        throw std::invalid_argument("GPU-driven model requires at least one opaque mesh");
+    }
+
+    // Colored meshes come first, followed by textured meshes grouped by diffuse map
+    const auto diffuse_map_id = [](const MeshRenderData* mesh_data) {
+        return mesh_data->material.diffuse_map.has_value() ? mesh_data->material.diffuse_map->id() : 0u;
+    };
+    std::stable_sort(draws.begin(), draws.end(),
+                     [&diffuse_map_id](const MeshRenderData* lhs, const MeshRenderData* rhs) {
+                         return diffuse_map_id(lhs) < diffuse_map_id(rhs);
+                     });
+
+    const std::vector<int>& attributes_sizes{draws.front()->mesh.attributes_sizes()};
+    if (attributes_sizes.size() > draw_id_location)
+    {
+        throw std::invalid_argument("GPU-driven model supports at most three vertex attributes");
+    }
+
+    const int stride{draws.front()->mesh.stride()};
+    GLsizeiptr vertex_buffer_size{0};
+    for (const MeshRenderData* mesh_data : draws)
+    {
+        if (mesh_data->mesh.attributes_sizes() != attributes_sizes)
+        {
+            throw std::invalid_argument("All meshes of a GPU-driven model must share the same vertex format");
+        }
+        vertex_buffer_size += static_cast<GLsizeiptr>(mesh_data->mesh.number_of_vertices() * stride * sizeof(float));
+    }
+
+    // Merge the vertex buffers of all meshes into a single buffer
+    glCreateBuffers(1, &vertex_buffer_identifier_);
+    glNamedBufferStorage(vertex_buffer_identifier_, vertex_buffer_size, nullptr, 0);
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, vertex_buffer_identifier_,
+                                   static_cast<std::uint64_t>(vertex_buffer_size));
+
+    number_of_draws_ = static_cast<std::uint32_t>(draws.size());
+    std::vector<DrawArraysIndirectCommand> commands;
+    std::vector<DrawBounds> bounds;
+    std::vector<glm::vec4> colors;
+    std::vector<std::uint32_t> draw_ids;
+    commands.reserve(draws.size());
+    bounds.reserve(draws.size());
+    colors.reserve(draws.size());
+    draw_ids.reserve(draws.size());
+
+    GLintptr vertex_buffer_offset{0};
+    std::uint32_t first_vertex{0};
+    for (std::uint32_t draw = 0; draw < number_of_draws_; ++draw)
+    {
+        MeshRenderData& mesh_data{*draws[draw]};
+        const auto number_of_vertices = static_cast<std::uint32_t>(mesh_data.mesh.number_of_vertices());
+        const auto size = static_cast<GLsizeiptr>(number_of_vertices * stride * sizeof(float));
+        glCopyNamedBufferSubData(mesh_data.mesh.vertex_buffer_id(), vertex_buffer_identifier_, 0, vertex_buffer_offset,
+                                 size);
+        vertex_buffer_offset += size;
+
+        // The base instance offsets the instanced draw id attribute, identifying the draw on the shaders
+        commands.emplace_back(DrawArraysIndirectCommand{
+            .count = number_of_vertices, .instance_count = 0, .first = first_vertex, .base_instance = draw});
+        first_vertex += number_of_vertices;
+
+        const AABB& mesh_bounds{mesh_data.mesh.bounds()};
+        bounds.emplace_back(DrawBounds{.min_corner = glm::vec4{mesh_bounds.min_corner, 1.0f},
+                                       .max_corner = glm::vec4{mesh_bounds.max_corner, 1.0f}});
+        colors.emplace_back(mesh_data.material.diffuse_color, mesh_data.material.alpha);
+        draw_ids.emplace_back(draw);
+
+        if (!mesh_data.material.diffuse_map.has_value())
+        {
+            ++number_of_colored_draws_;
+        }
+        else if (texture_batches_.empty() ||
+                 texture_batches_.back().diffuse_map != &mesh_data.material.diffuse_map.value())
+        {
+            texture_batches_.emplace_back(TextureBatch{
+                .diffuse_map = &mesh_data.material.diffuse_map.value(), .first_draw = draw, .draw_count = 1});
+        }
+        else
+        {
+            ++texture_batches_.back().draw_count;
+        }
+    }
+
+    // One segment of commands for each DrawSet
+    const std::size_t number_of_draw_sets{to_underlying(DrawSet::Frustum) + 1};
+    std::vector<DrawArraysIndirectCommand> all_commands;
+    all_commands.reserve(number_of_draw_sets * commands.size());
+    for (std::size_t draw_set = 0; draw_set < number_of_draw_sets; ++draw_set)
+    {
+        all_commands.insert(all_commands.end(), commands.cbegin(), commands.cend());
+    }
+
+    // Every mesh is considered visible on the first frame
+    const std::vector<std::uint32_t> visibility(draws.size(), 1);
+
+    glCreateBuffers(1, &command_buffer_identifier_);
+    glNamedBufferStorage(command_buffer_identifier_,
+                         static_cast<GLsizeiptr>(all_commands.size() * sizeof(DrawArraysIndirectCommand)),
+                         all_commands.data(), 0);
+    glCreateBuffers(1, &bounds_buffer_identifier_);
+    glNamedBufferStorage(bounds_buffer_identifier_, static_cast<GLsizeiptr>(bounds.size() * sizeof(DrawBounds)),
+                         bounds.data(), 0);
+    glCreateBuffers(1, &visibility_buffer_identifier_);
+    glNamedBufferStorage(visibility_buffer_identifier_,
+                         static_cast<GLsizeiptr>(visibility.size() * sizeof(std::uint32_t)), visibility.data(), 0);
+    glCreateBuffers(1, &color_buffer_identifier_);
+    glNamedBufferStorage(color_buffer_identifier_, static_cast<GLsizeiptr>(colors.size() * sizeof(glm::vec4)),
+                         colors.data(), 0);
+    glCreateBuffers(1, &draw_id_buffer_identifier_);
+    glNamedBufferStorage(draw_id_buffer_identifier_, static_cast<GLsizeiptr>(draw_ids.size() * sizeof(std::uint32_t)),
+                         draw_ids.data(), 0);
+    frame_stats().add(FrameStats::Counter::BufferBytes,
+                      all_commands.size() * sizeof(DrawArraysIndirectCommand) + bounds.size() * sizeof(DrawBounds) +
+                          visibility.size() * sizeof(std::uint32_t) + colors.size() * sizeof(glm::vec4) +
+                          draw_ids.size() * sizeof(std::uint32_t));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, command_buffer_identifier_,
+                                   all_commands.size() * sizeof(DrawArraysIndirectCommand));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, bounds_buffer_identifier_,
+                                   bounds.size() * sizeof(DrawBounds));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, visibility_buffer_identifier_,
+                                   visibility.size() * sizeof(std::uint32_t));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, color_buffer_identifier_,
+                                   colors.size() * sizeof(glm::vec4));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, draw_id_buffer_identifier_,
+                                   draw_ids.size() * sizeof(std::uint32_t));
+    debug_output().label(GL_BUFFER, vertex_buffer_identifier_, "GPU-driven vertices");
+    debug_output().label(GL_BUFFER, command_buffer_identifier_, "GPU-driven draw commands");
+    debug_output().label(GL_BUFFER, bounds_buffer_identifier_, "GPU-driven bounds");
+    debug_output().label(GL_BUFFER, visibility_buffer_identifier_, "GPU-driven visibility");
+    debug_output().label(GL_BUFFER, color_buffer_identifier_, "GPU-driven colors");
+    debug_output().label(GL_BUFFER, draw_id_buffer_identifier_, "GPU-driven draw ids");
+
+    // Vertex format of the merged buffer, equal to the format of the original meshes
+    glCreateVertexArrays(1, &vertex_array_identifier_);
+    glVertexArrayVertexBuffer(vertex_array_identifier_, 0, vertex_buffer_identifier_, 0,
+                              static_cast<GLsizei>(stride * sizeof(float)));
+    int offset{0};
+    for (GLuint index = 0; index < attributes_sizes.size(); ++index)
+    {
+        glEnableVertexArrayAttrib(vertex_array_identifier_, index);
+        glVertexArrayAttribFormat(vertex_array_identifier_, index, attributes_sizes[index], GL_FLOAT, GL_FALSE,
+                                  static_cast<GLuint>(offset * sizeof(float)));
+        glVertexArrayAttribBinding(vertex_array_identifier_, index, 0);
+        offset += attributes_sizes[index];
+    }
+
+    /*
+    The draw id is an instanced attribute: instanced attributes are offset by the
+    base instance of each indirect command, allowing shaders to fetch per-draw data
+    without ARB_shader_draw_parameters (not core on OpenGL 4.5).
+    */
+    glVertexArrayVertexBuffer(vertex_array_identifier_, 1, draw_id_buffer_identifier_, 0, sizeof(std::uint32_t));
+    glVertexArrayBindingDivisor(vertex_array_identifier_, 1, 1);
+    glEnableVertexArrayAttrib(vertex_array_identifier_, draw_id_location);
+    glVertexArrayAttribIFormat(vertex_array_identifier_, draw_id_location, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vertex_array_identifier_, draw_id_location, 1);
+
+    culling_shader_.set_int_uniform("number_of_draws", static_cast<int>(number_of_draws_));
+}
+
+GpuDrivenModel::~GpuDrivenModel()
+{
+    state_cache().forget_vertex_array(vertex_array_identifier_);
+    glDeleteVertexArrays(1, &vertex_array_identifier_);
+    for (const std::uint32_t buffer : {vertex_buffer_identifier_, draw_id_buffer_identifier_, bounds_buffer_identifier_,
+                                       command_buffer_identifier_, visibility_buffer_identifier_,
+                                       color_buffer_identifier_})
+    {
+        gpu_memory().unregister_resource(GpuMemoryTracker::Category::Buffers, buffer);
+    }
+    glDeleteBuffers(1, &vertex_buffer_identifier_);
+    glDeleteBuffers(1, &draw_id_buffer_identifier_);
+    glDeleteBuffers(1, &bounds_buffer_identifier_);
+    glDeleteBuffers(1, &command_buffer_identifier_);
+    glDeleteBuffers(1, &visibility_buffer_identifier_);
+    glDeleteBuffers(1, &color_buffer_identifier_);
+}
+
+void GpuDrivenModel::cull_early(const glm::mat4& mvp)
+{
+    dispatch(early_cull_pass, mvp);
+}
+
+void GpuDrivenModel::cull_late(const glm::mat4& mvp, HiZPyramid& hi_z_pyramid)
+{
+    hi_z_pyramid.bind(0);
+    dispatch(late_cull_pass, mvp);
+}
+
+void GpuDrivenModel::cull_frustum(const glm::mat4& mvp)
+{
+    dispatch(frustum_cull_pass, mvp);
+}
+
+void GpuDrivenModel::dispatch(int cull_pass, const glm::mat4& mvp)
+{
+    culling_shader_.use();
+    culling_shader_.set_mat4_uniform("mvp", mvp);
+    culling_shader_.set_int_uniform("cull_pass", cull_pass);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds_buffer_identifier_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, command_buffer_identifier_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, visibility_buffer_identifier_);
+    glDispatchCompute((number_of_draws_ + culling_work_group_size - 1) / culling_work_group_size, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuDrivenModel::render(DrawSet draw_set)
+{
+    render_range(draw_set, 0, number_of_draws_);
+}
+
+void GpuDrivenModel::render_colored(DrawSet draw_set)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, color_buffer_identifier_);
+    render_range(draw_set, 0, number_of_colored_draws_);
+}
+
+void GpuDrivenModel::render_textured(DrawSet draw_set)
+{
+    for (const TextureBatch& batch : texture_batches_)
+    {
+        batch.diffuse_map->bind(0);
+        render_range(draw_set, batch.first_draw, batch.draw_count);
+    }
+}
+
+void GpuDrivenModel::render_range(DrawSet draw_set, std::uint32_t first_draw, std::uint32_t draw_count)
+{
+    if (draw_count == 0)
+    {
+        return;
+    }
+
+    const std::size_t first_command{to_underlying(draw_set) * number_of_draws_ + first_draw};
+    // The number of triangles of the draws depends on the culling results, which stay on the GPU
+    frame_stats().add(FrameStats::Counter::DrawCalls);
+    state_cache().bind_vertex_array(vertex_array_identifier_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_identifier_);
+    glMultiDrawArraysIndirect(GL_TRIANGLES,
+                              reinterpret_cast<const void*>(first_command * sizeof(DrawArraysIndirectCommand)),
+                              static_cast<GLsizei>(draw_count), 0);
+}
+
+std::size_t GpuDrivenModel::number_of_draws() const
+{
+    return number_of_draws_;
+}
+
+} // namespace gl
@@ -0,0 +1,125 @@
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+namespace gl
+{
+
+// Forward declaration
+class Model;
+
+/*
+Hierarchical-Z pyramid: a R32F texture where each mip level stores
+the farthest depth of the 2x2 texels of the previous level. The
+pyramid is built with a compute shader from a depth texture.
+*/
+class HiZPyramid
+{
+public:
+    HiZPyramid();
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid(HiZPyramid&&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(HiZPyramid&&) = delete;
+    ~HiZPyramid() = default;
+
+    // Builds the pyramid from a depth texture, allocating it on the first build and whenever the dimensions of the
+    // depth change
+    void build(Texture& depth);
+    // The pyramid only exists once it has been built
+    void bind(std::uint32_t texture_unit);
+    const Texture& texture() const;
+
+private:
+    std::optional<Texture> pyramid_;
+    ShaderProgram downsample_shader_;
+};
+
+/*
+Sets of indirect draw commands generated by the culling compute shader.
+Early contains the draws visible on the previous frame that pass the
+frustum test; Late contains the draws that became visible after testing
+against the Hi-Z pyramid of the current frame; Visible is the union of
+both; Frustum contains the result of a frustum-only test (e.g. for the
+shadow map pass).
+*/
+enum class DrawSet
+{
+    Early = 0,
+    Late,
+    Visible,
+    Frustum
+};
+
+/*
+GPU-driven representation of a model: the opaque meshes of the model are
+merged into a single vertex buffer and drawn with glMultiDrawArraysIndirect,
+while a compute shader tests the bounds of each mesh against the view
+frustum and a Hi-Z pyramid to fill the indirect command buffer. The CPU
+cost of culling and drawing doesn't depend on the number of meshes.
+
+The model must outlive this object, since the diffuse maps of its materials
+are referenced (not copied) when drawing textured meshes.
+*/
+class GpuDrivenModel
+{
+public:
+    explicit GpuDrivenModel(Model& model);
+    GpuDrivenModel(const GpuDrivenModel&) = delete;
+    GpuDrivenModel(GpuDrivenModel&&) = delete;
+    GpuDrivenModel& operator=(const GpuDrivenModel&) = delete;
+    GpuDrivenModel& operator=(GpuDrivenModel&&) = delete;
+    ~GpuDrivenModel();
+
+    // Fills DrawSet::Early using the visibility of the previous frame
+    void cull_early(const glm::mat4& mvp);
+    // Fills DrawSet::Late and DrawSet::Visible, updating the visibility for the next frame
+    void cull_late(const glm::mat4& mvp, HiZPyramid& hi_z_pyramid);
+    // Fills DrawSet::Frustum
+    void cull_frustum(const glm::mat4& mvp);
+
+    // Render all meshes of the draw set with the currently bound shader
+    void render(DrawSet draw_set);
+    // Render meshes without diffuse map; the diffuse color is read by the
+    // fragment shader from the storage buffer at binding 3 (indexed by draw id)
+    void render_colored(DrawSet draw_set);
+    // Render meshes with diffuse map, binding each diffuse map to unit 0
+    void render_textured(DrawSet draw_set);
+
+    std::size_t number_of_draws() const;
+
+private:
+    struct TextureBatch
+    {
+        Texture* diffuse_map;
+        std::uint32_t first_draw;
+        std::uint32_t draw_count;
+    };
+
+    ShaderProgram culling_shader_;
+    std::uint32_t number_of_draws_{0};
+    std::uint32_t number_of_colored_draws_{0};
+    std::vector<TextureBatch> texture_batches_;
+    std::uint32_t vertex_array_identifier_{0};
+    std::uint32_t vertex_buffer_identifier_{0};
+    std::uint32_t draw_id_buffer_identifier_{0};
+    std::uint32_t bounds_buffer_identifier_{0};
+    std::uint32_t command_buffer_identifier_{0};
+    std::uint32_t visibility_buffer_identifier_{0};
+    std::uint32_t color_buffer_identifier_{0};
+
+    void dispatch(int cull_pass, const glm::mat4& mvp);
+    void render_range(DrawSet draw_set, std::uint32_t first_draw, std::uint32_t draw_count);
+};
+
+} // namespace gl
+
+#endif // GPU_CULLING_HPP
@@ -0,0 +1,207 @@
+#include "gpu_memory.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace gl
+{
+
+namespace
+{
+
+double to_mebibytes(std::uint64_t bytes)
+{
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+GpuMemoryTracker::OwnerScope::OwnerScope(std::string owner)
+{
+    gpu_memory().push_owner(std::move(owner));
+}
+
+GpuMemoryTracker::OwnerScope::~OwnerScope()
+{
+    gpu_memory().pop_owner();
+}
+
+void GpuMemoryTracker::register_resource(Category category, std::uint32_t id, std::uint64_t bytes)
+{
+    if (id == 0)
+    {
+        return;
+    }
+
+    // A name can be reused by the driver once deleted, so a stale entry is replaced
+    unregister_resource(category, id);
+    allocations_.emplace(std::pair{category, id},
+                         Allocation{.bytes = bytes,
+                                    .owner = owners_.empty() ? std::string{unassigned_owner} : owners_.back()});
+    totals_[static_cast<std::size_t>(category)] += bytes;
+
+    const std::uint64_t total{total_bytes()};
+    peak_bytes_ = std::max(peak_bytes_, total);
+    if (budget_bytes_ && total > budget_bytes_.value() && !budget_warning_issued_)
+    {
+        budget_warning_issued_ = true;
+        const auto precision = std::cerr.precision(1);
+        const auto flags = std::cerr.setf(std::ios::fixed, std::ios::floatfield);
+        std::cerr << "GPU memory budget exceeded: " << to_mebibytes(total) << " MiB used of "
+                  << to_mebibytes(budget_bytes_.value()) << " MiB\n";
+        std::cerr.precision(precision);
+        std::cerr.flags(flags);
+    }
+}
+
+void GpuMemoryTracker::unregister_resource(Category category, std::uint32_t id)
+{
+    const auto allocation = allocations_.find(std::pair{category, id});
+    if (allocation == allocations_.end())
+    {
+        return;
+    }
+
+    totals_[static_cast<std::size_t>(category)] -= allocation->second.bytes;
+    allocations_.erase(allocation);
+    if (budget_bytes_ && total_bytes() <= budget_bytes_.value())
+    {
+        budget_warning_issued_ = false;
+    }
+}
+
+void GpuMemoryTracker::push_owner(std::string owner)
+{
+    owners_.emplace_back(std::move(owner));
+}
+
+void GpuMemoryTracker::pop_owner()
+{
+    owners_.pop_back();
+}
+
+void GpuMemoryTracker::set_budget(std::optional<std::uint64_t> budget_bytes)
+{
+    budget_bytes_ = budget_bytes;
+    budget_warning_issued_ = false;
+}
+
+std::optional<std::uint64_t> GpuMemoryTracker::budget() const
+{
+    return budget_bytes_;
+}
+
+bool GpuMemoryTracker::is_over_budget() const
+{
+    return budget_bytes_ && total_bytes() > budget_bytes_.value();
+}
+
+std::uint64_t GpuMemoryTracker::total_bytes() const
+{
+    return std::accumulate(totals_.cbegin(), totals_.cend(), std::uint64_t{0});
+}
+
+GpuMemoryTracker::Snapshot GpuMemoryTracker::snapshot() const
+{
+    Snapshot snapshot{
+        .totals = totals_, .total_bytes = total_bytes(), .peak_bytes = peak_bytes_, .budget_bytes = budget_bytes_};
+
+    std::map<std::string_view, OwnerTotals> owners;
+    for (const auto& [key, allocation] : allocations_)
+    {
+        OwnerTotals& owner = owners[allocation.owner];
+        owner.bytes[static_cast<std::size_t>(key.first)] += allocation.bytes;
+        ++owner.resources;
+    }
+    for (auto& [name, owner] : owners)
+    {
+        owner.owner = name;
+        snapshot.owners.emplace_back(std::move(owner));
+    }
+
+    const auto owner_bytes = [](const OwnerTotals& owner) {
+        return std::accumulate(owner.bytes.cbegin(), owner.bytes.cend(), std::uint64_t{0});
+    };
+    std::stable_sort(snapshot.owners.begin(), snapshot.owners.end(),
+                     [&owner_bytes](const OwnerTotals& lhs, const OwnerTotals& rhs) {
+                         return owner_bytes(lhs) > owner_bytes(rhs);
+                     });
+    return snapshot;
+}
+
+std::size_t GpuMemoryTracker::report_leaks(std::ostream& stream) const
+{
+    for (const auto& [key, allocation] : allocations_)
+    {
+        stream << "GPU memory leak: " << category_name(key.first) << " " << key.second << " of " << allocation.owner
+               << " (" << allocation.bytes << " bytes)\n";
+    }
+    return allocations_.size();
+}
+
+std::string_view GpuMemoryTracker::category_name(Category category)
+{
+    switch (category)
+    {
+    case Category::Textures:
+        return "Textures";
+    case Category::Renderbuffers:
+        return "Renderbuffers";
+    case Category::Buffers:
+        return "Buffers";
+    default:
+        return "Unknown";
+    }
+}
+
+GpuMemoryTracker& gpu_memory()
+{
+    thread_local GpuMemoryTracker tracker{};
+    return tracker;
+}
+
+std::size_t bytes_per_texel(GLenum internal_format)
+{
+    switch (internal_format)
+    {
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_R16:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    // Drivers pad three-channel formats to four channels
+    case GL_RGB16F:
+    case GL_RGBA16:
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_RG32UI:
+    case GL_DEPTH32F_STENCIL8:
+        return 8;
+    case GL_RGB32F:
+    case GL_RGBA32F:
+    case GL_RGBA32UI:
+        return 16;
+    default:
+        // RGB8, RGBA8, SRGB8_ALPHA8, R32F, R32UI, R11F_G11F_B10F, RGB10_A2, RG16F and 24/32-bit depth formats
+        return 4;
+    }
+}
+
+std::uint64_t image_bytes(std::uint64_t width, std::uint64_t height, GLenum internal_format, GLsizei mip_levels,
+                          std::uint64_t layers, GLsizei samples)
+{
+    std::uint64_t texels{0};
+    for (GLsizei level = 0; level < std::max(mip_levels, GLsizei{1}); ++level)
+    {
+        texels += width * height;
+        width = std::max<std::uint64_t>(width / 2, 1);
+        height = std::max<std::uint64_t>(height / 2, 1);
+    }
+    return texels * layers * static_cast<std::uint64_t>(std::max(samples, GLsizei{1})) *
+           bytes_per_texel(internal_format);
+}
+
+} // namespace gl
@@ -0,0 +1,133 @@
+#ifndef GPU_MEMORY_HPP
+#define GPU_MEMORY_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gl
+{
+
+/*
+Accounts the video memory of the textures, renderbuffers and buffers created
+by the gl library. The wrappers register the size of their storage when
+they allocate it and unregister it when they delete it. Sizes are computed
+from formats, dimensions, mip levels and samples; drivers add padding and
+metadata on top of them.
+
+Resources are attributed to the owner of the innermost OwnerScope alive
+when they're registered, e.g. "Render graph" or the name of a model. Like
+the state cache, there's a tracker per thread, accounting the resources of
+the context current on the thread.
+*/
+class GpuMemoryTracker
+{
+public:
+    enum class Category
+    {
+        Textures = 0,
+        Renderbuffers,
+        Buffers,
+        Count
+    };
+
+    static constexpr std::size_t number_of_categories{static_cast<std::size_t>(Category::Count)};
+    // Bytes indexed by Category
+    using Totals = std::array<std::uint64_t, number_of_categories>;
+
+    struct OwnerTotals
+    {
+        std::string owner;
+        Totals bytes{};
+        std::size_t resources{0};
+    };
+
+    struct Snapshot
+    {
+        Totals totals{};
+        std::uint64_t total_bytes{0};
+        // Highest total since the tracker was created
+        std::uint64_t peak_bytes{0};
+        std::optional<std::uint64_t> budget_bytes{};
+        // Sorted by decreasing size
+        std::vector<OwnerTotals> owners{};
+    };
+
+    // Attributes the resources registered during its lifetime to the owner
+    class OwnerScope
+    {
+    public:
+        explicit OwnerScope(std::string owner);
+        OwnerScope(const OwnerScope&) = delete;
+        OwnerScope(OwnerScope&&) = delete;
+        OwnerScope& operator=(const OwnerScope&) = delete;
+        OwnerScope& operator=(OwnerScope&&) = delete;
+        ~OwnerScope();
+    };
+
+    // Owner of the resources registered outside of any scope
+    static constexpr std::string_view unassigned_owner{"Unassigned"};
+
+    // Identifiers are only unique within a category; identifier 0 is ignored, e.g. for moved-from wrappers
+    void register_resource(Category category, std::uint32_t id, std::uint64_t bytes);
+    void unregister_resource(Category category, std::uint32_t id);
+
+    void push_owner(std::string owner);
+    void pop_owner();
+
+    /*
+    A warning is printed when a registration makes the total exceed the
+    budget, and again after the total went back under the budget.
+    */
+    void set_budget(std::optional<std::uint64_t> budget_bytes);
+    std::optional<std::uint64_t> budget() const;
+    bool is_over_budget() const;
+
+    std::uint64_t total_bytes() const;
+    Snapshot snapshot() const;
+
+    /*
+    Prints the resources still registered, e.g. on shutdown once every owner
+    should have deleted its resources, and returns their number.
+    */
+    std::size_t report_leaks(std::ostream& stream) const;
+
+    static std::string_view category_name(Category category);
+
+private:
+    struct Allocation
+    {
+        std::uint64_t bytes{0};
+        std::string owner;
+    };
+
+    std::map<std::pair<Category, std::uint32_t>, Allocation> allocations_{};
+    Totals totals_{};
+    std::uint64_t peak_bytes_{0};
+    std::vector<std::string> owners_{};
+    std::optional<std::uint64_t> budget_bytes_{};
+    bool budget_warning_issued_{false};
+};
+
+// Memory tracker of the context current on the calling thread
+GpuMemoryTracker& gpu_memory();
+
+// Bytes of a texel of a sized internal format; unknown formats count as 4 bytes
+std::size_t bytes_per_texel(GLenum internal_format);
+
+// Bytes of the storage of a texture or renderbuffer, with all its mip levels, layers and samples
+std::uint64_t image_bytes(std::uint64_t width, std::uint64_t height, GLenum internal_format, GLsizei mip_levels = 1,
+                          std::uint64_t layers = 1, GLsizei samples = 0);
+
+} // namespace gl
+
+#endif // GPU_MEMORY_HPP
@@ -0,0 +1,284 @@
+#include "gpu_profiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+// Pipeline statistics enumerators (OpenGL 4.6 / ARB_pipeline_statistics_query), missing from 4.5 loaders
+#ifndef GL_PRIMITIVES_SUBMITTED
+#define GL_PRIMITIVES_SUBMITTED 0x82EF
+#endif
+#ifndef GL_VERTEX_SHADER_INVOCATIONS
+#define GL_VERTEX_SHADER_INVOCATIONS 0x82F0
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4
+#endif
+
+namespace gl
+{
+
+namespace
+{
+
+bool has_pipeline_statistics_query()
+{
+    GLint major_version{0};
+    GLint minor_version{0};
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+    if (major_version > 4 || (major_version == 4 && minor_version >= 6))
+    {
+        return true;
+    }
+
+    GLint number_of_extensions{0};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &number_of_extensions);
+    for (GLint extension = 0; extension < number_of_extensions; ++extension)
+    {
+        const auto* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, extension));
+        if (name != nullptr && std::string_view{name} == "GL_ARB_pipeline_statistics_query")
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+GpuProfiler::GpuProfiler(std::size_t history_length) :
+    history_length_{history_length}, pipeline_statistics_supported_{has_pipeline_statistics_query()}
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (auto& frame_queries : frames_)
+    {
+        for (auto& scope_queries : frame_queries.scopes)
+        {
+            glDeleteQueries(QueryCount, scope_queries.ids.data());
+        }
+    }
+}
+
+void GpuProfiler::begin_frame()
+{
+    assert(!recording_);
+    collect_available_frames();
+
+    // The queries of the current slot are about to be reused, so unavailable results are dropped
+    FrameQueries& frame_queries = current_frame();
+    if (frame_queries.pending_frame)
+    {
+        frame_queries.pending_frame.reset();
+        ++dropped_frames_;
+    }
+    frame_queries.used_scopes = 0;
+    recording_ = true;
+}
+
+void GpuProfiler::end_frame()
+{
+    assert(recording_ && !active_scope_);
+    FrameQueries& frame_queries = current_frame();
+    if (frame_queries.used_scopes > 0)
+    {
+        frame_queries.pending_frame = frame_;
+    }
+    recording_ = false;
+    ++frame_;
+}
+
+void GpuProfiler::flush()
+{
+    assert(!recording_);
+    glFinish();
+    collect_available_frames();
+}
+
+void GpuProfiler::collect_available_frames()
+{
+    // Results are collected from the oldest frame; if it isn't ready, newer frames aren't either
+    std::array<FrameQueries*, frames_in_flight> pending_frames{};
+    std::size_t number_of_pending_frames{0};
+    for (auto& frame_queries : frames_)
+    {
+        if (frame_queries.pending_frame)
+        {
+            pending_frames[number_of_pending_frames++] = &frame_queries;
+        }
+    }
+    std::sort(pending_frames.begin(), pending_frames.begin() + number_of_pending_frames,
+              [](const FrameQueries* lhs, const FrameQueries* rhs) {
+                  return lhs->pending_frame.value() < rhs->pending_frame.value();
+              });
+
+    for (std::size_t i = 0; i < number_of_pending_frames; ++i)
+    {
+        if (!collect(*pending_frames[i]))
+        {
+            break;
+        }
+    }
+}
+
+void GpuProfiler::begin(std::string_view name)
+{
+    assert(recording_ && !active_scope_);
+    FrameQueries& frame_queries = current_frame();
+    if (frame_queries.used_scopes == frame_queries.scopes.size())
+    {
+        ScopeQueries& scope_queries = frame_queries.scopes.emplace_back();
+        glCreateQueries(GL_TIMESTAMP, 2, scope_queries.ids.data());
+        if (pipeline_statistics_supported_)
+        {
+            // Some drivers reject pipeline statistics targets in glCreateQueries, so the names are only reserved
+            glGenQueries(3, &scope_queries.ids[VertexShaderInvocations]);
+        }
+    }
+
+    ScopeQueries& scope_queries = frame_queries.scopes[frame_queries.used_scopes];
+    scope_queries.scope_index = scope_index(name);
+    active_scope_ = frame_queries.used_scopes++;
+    scope_queries.cpu_begin = std::chrono::steady_clock::now();
+
+    glQueryCounter(scope_queries.ids[BeginTimestamp], GL_TIMESTAMP);
+    if (pipeline_statistics_supported_)
+    {
+        glBeginQuery(GL_VERTEX_SHADER_INVOCATIONS, scope_queries.ids[VertexShaderInvocations]);
+        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, scope_queries.ids[FragmentShaderInvocations]);
+        glBeginQuery(GL_PRIMITIVES_SUBMITTED, scope_queries.ids[Primitives]);
+    }
+}
+
+void GpuProfiler::end()
+{
+    assert(active_scope_);
+    ScopeQueries& scope_queries = current_frame().scopes[active_scope_.value()];
+    if (pipeline_statistics_supported_)
+    {
+        glEndQuery(GL_VERTEX_SHADER_INVOCATIONS);
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+        glEndQuery(GL_PRIMITIVES_SUBMITTED);
+    }
+    glQueryCounter(scope_queries.ids[EndTimestamp], GL_TIMESTAMP);
+    scope_queries.cpu_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scope_queries.cpu_begin).count();
+    active_scope_.reset();
+}
+
+bool GpuProfiler::pipeline_statistics_supported() const
+{
+    return pipeline_statistics_supported_;
+}
+
+const std::vector<GpuProfiler::ScopeStatistics>& GpuProfiler::scopes() const
+{
+    return scopes_;
+}
+
+std::size_t GpuProfiler::dropped_frames() const
+{
+    return dropped_frames_;
+}
+
+void GpuProfiler::export_csv(std::string_view filename) const
+{
+    std::ofstream file{std::string{filename}};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + std::string{filename} + " for writing");
+    }
+
+    file << "frame,scope,gpu_ms,cpu_ms,vertex_shader_invocations,fragment_shader_invocations,primitives\n";
+    for (const auto& scope : scopes_)
+    {
+        for (const auto& sample : scope.history)
+        {
+            file << sample.frame << ',' << scope.name << ',' << sample.gpu_ms << ',' << sample.cpu_ms << ','
+                 << sample.vertex_shader_invocations << ',' << sample.fragment_shader_invocations << ','
+                 << sample.primitives << '\n';
+        }
+    }
+}
+
+GpuProfiler::FrameQueries& GpuProfiler::current_frame()
+{
+    return frames_[frame_ % frames_in_flight];
+}
+
+std::size_t GpuProfiler::scope_index(std::string_view name)
+{
+    const auto scope = std::find_if(scopes_.cbegin(), scopes_.cend(),
+                                    [name](const ScopeStatistics& statistics) { return statistics.name == name; });
+    if (scope != scopes_.cend())
+    {
+        return static_cast<std::size_t>(scope - scopes_.cbegin());
+    }
+
+    scopes_.emplace_back(ScopeStatistics{.name = std::string{name}});
+    return scopes_.size() - 1;
+}
+
+bool GpuProfiler::collect(FrameQueries& frame_queries)
+{
+    // Queries complete in order, so the last timestamp of the frame tells whether all results are available
+    const ScopeQueries& last_scope = frame_queries.scopes[frame_queries.used_scopes - 1];
+    GLint available{GL_FALSE};
+    glGetQueryObjectiv(last_scope.ids[EndTimestamp], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE)
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < frame_queries.used_scopes; ++i)
+    {
+        const ScopeQueries& scope_queries = frame_queries.scopes[i];
+        std::array<GLuint64, QueryCount> results{};
+        glGetQueryObjectui64v(scope_queries.ids[BeginTimestamp], GL_QUERY_RESULT, &results[BeginTimestamp]);
+        glGetQueryObjectui64v(scope_queries.ids[EndTimestamp], GL_QUERY_RESULT, &results[EndTimestamp]);
+        if (pipeline_statistics_supported_)
+        {
+            for (int query = VertexShaderInvocations; query < QueryCount; ++query)
+            {
+                glGetQueryObjectui64v(scope_queries.ids[query], GL_QUERY_RESULT, &results[query]);
+            }
+        }
+
+        ScopeStatistics& scope = scopes_[scope_queries.scope_index];
+        scope.history.emplace_back(
+            Sample{.frame = frame_queries.pending_frame.value(),
+                   .gpu_ms = static_cast<double>(results[EndTimestamp] - results[BeginTimestamp]) / 1.0e6,
+                   .cpu_ms = scope_queries.cpu_ms,
+                   .vertex_shader_invocations = results[VertexShaderInvocations],
+                   .fragment_shader_invocations = results[FragmentShaderInvocations],
+                   .primitives = results[Primitives]});
+        if (scope.history.size() > history_length_)
+        {
+            scope.history.pop_front();
+        }
+        update_statistics(scope);
+    }
+
+    frame_queries.pending_frame.reset();
+    return true;
+}
+
+void GpuProfiler::update_statistics(ScopeStatistics& scope)
+{
+    std::vector<double> gpu_ms(scope.history.size());
+    std::transform(scope.history.cbegin(), scope.history.cend(), gpu_ms.begin(),
+                   [](const Sample& sample) { return sample.gpu_ms; });
+    scope.average_ms = std::accumulate(gpu_ms.cbegin(), gpu_ms.cend(), 0.0) / static_cast<double>(gpu_ms.size());
+
+    const auto p95 = gpu_ms.begin() + static_cast<std::ptrdiff_t>((gpu_ms.size() - 1) * 95 / 100);
+    std::nth_element(gpu_ms.begin(), p95, gpu_ms.end());
+    scope.p95_ms = *p95;
+}
+
+} // namespace gl
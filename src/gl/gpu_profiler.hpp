@@ -0,0 +1,120 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gl
+{
+
+/*
+Measures the GPU time and pipeline statistics of named scopes (e.g. render
+passes). Each scope issues two GL_TIMESTAMP queries and, if the context supports
+ARB_pipeline_statistics_query (core since OpenGL 4.6), counts the vertex and
+fragment shader invocations and the submitted primitives.
+
+Queries are ring-buffered over frames_in_flight frames and their results are
+only read once available, typically one or two frames late, so the profiler
+never stalls the pipeline; frames whose results aren't available when their
+queries must be reused are dropped.
+*/
+class GpuProfiler
+{
+public:
+    static constexpr std::size_t frames_in_flight{3};
+
+    struct Sample
+    {
+        std::uint64_t frame{0};
+        double gpu_ms{0.0};
+        // Time spent by the CPU submitting the commands of the scope
+        double cpu_ms{0.0};
+        std::uint64_t vertex_shader_invocations{0};
+        std::uint64_t fragment_shader_invocations{0};
+        std::uint64_t primitives{0};
+    };
+
+    struct ScopeStatistics
+    {
+        std::string name;
+        std::deque<Sample> history{};
+        double average_ms{0.0};
+        double p95_ms{0.0};
+    };
+
+    explicit GpuProfiler(std::size_t history_length = 300);
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler(GpuProfiler&&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(GpuProfiler&&) = delete;
+    ~GpuProfiler();
+
+    // Collects the results available from previous frames and starts recording a new frame
+    void begin_frame();
+    void end_frame();
+    // Waits for the GPU and collects the results of every recorded frame, e.g. at the end of a benchmark
+    void flush();
+    // Scopes can't be nested, since a single pipeline statistics query of each type may be active
+    void begin(std::string_view name);
+    void end();
+
+    bool pipeline_statistics_supported() const;
+    const std::vector<ScopeStatistics>& scopes() const;
+    std::size_t dropped_frames() const;
+    // Writes the history of every scope as comma-separated values; throws if the file can't be written
+    void export_csv(std::string_view filename) const;
+
+private:
+    enum Query
+    {
+        BeginTimestamp = 0,
+        EndTimestamp,
+        VertexShaderInvocations,
+        FragmentShaderInvocations,
+        Primitives,
+        QueryCount
+    };
+
+    struct ScopeQueries
+    {
+        std::size_t scope_index{0};
+        std::array<std::uint32_t, QueryCount> ids{};
+        std::chrono::steady_clock::time_point cpu_begin{};
+        double cpu_ms{0.0};
+    };
+
+    struct FrameQueries
+    {
+        std::vector<ScopeQueries> scopes{};
+        std::size_t used_scopes{0};
+        std::optional<std::uint64_t> pending_frame{};
+    };
+
+    std::size_t history_length_;
+    bool pipeline_statistics_supported_{false};
+    std::array<FrameQueries, frames_in_flight> frames_{};
+    std::vector<ScopeStatistics> scopes_{};
+    std::uint64_t frame_{0};
+    std::size_t dropped_frames_{0};
+    std::optional<std::size_t> active_scope_{};
+    bool recording_{false};
+
+    FrameQueries& current_frame();
+    // Collects the frames whose results are available, oldest first
+    void collect_available_frames();
+    std::size_t scope_index(std::string_view name);
+    bool collect(FrameQueries& frame_queries);
+    void update_statistics(ScopeStatistics& scope);
+};
+
+} // namespace gl
+
+#endif // GPU_PROFILER_HPP
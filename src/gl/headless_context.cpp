@@ -0,0 +1,97 @@
+#include "headless_context.hpp"
+
+#include <stdexcept>
+
+#ifdef GL_ENABLE_HEADLESS
+// Avoids including the X11 headers, which aren't needed without native windows
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace gl
+{
+
+#ifdef GL_ENABLE_HEADLESS
+
+HeadlessContext::HeadlessContext(int major_version, int minor_version, bool debug)
+{
+    // The surfaceless platform doesn't need a display server; fall back to the default display otherwise
+    EGLDisplay display{EGL_NO_DISPLAY};
+    const auto get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display != nullptr)
+    {
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY)
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY || eglInitialize(display, nullptr, nullptr) == EGL_FALSE)
+    {
+        throw std::runtime_error("Failure to initialize an EGL display");
+    }
+    display_ = display;
+
+    if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+    {
+        eglTerminate(display);
+        throw std::runtime_error("Failure to bind the OpenGL API to EGL");
+    }
+
+    // No surface is ever created, so the context doesn't need a config
+    const EGLint context_attributes[]{EGL_CONTEXT_MAJOR_VERSION,
+                                      major_version,
+                                      EGL_CONTEXT_MINOR_VERSION,
+                                      minor_version,
+                                      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                      EGL_CONTEXT_OPENGL_DEBUG,
+                                      debug ? EGL_TRUE : EGL_FALSE,
+                                      EGL_NONE};
+    const EGLContext context{eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes)};
+    if (context == EGL_NO_CONTEXT)
+    {
+        eglTerminate(display);
+        throw std::runtime_error("Failure to create a surfaceless OpenGL context");
+    }
+    context_ = context;
+
+    if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE)
+    {
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        throw std::runtime_error("Failure to make the surfaceless OpenGL context current");
+    }
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display_, context_);
+    eglTerminate(display_);
+}
+
+void* HeadlessContext::proc_address(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+HeadlessContext::HeadlessContext(int /*major_version*/, int /*minor_version*/, bool /*debug*/)
+{
+    throw std::runtime_error("Headless rendering requires building the gl library with GL_ENABLE_HEADLESS");
+}
+
+HeadlessContext::~HeadlessContext() = default;
+
+void* HeadlessContext::proc_address(const char* /*name*/)
+{
+    return nullptr;
+}
+
+#endif
+
+} // namespace gl
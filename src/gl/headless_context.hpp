@@ -0,0 +1,37 @@
+#ifndef HEADLESS_CONTEXT_HPP
+#define HEADLESS_CONTEXT_HPP
+
+namespace gl
+{
+
+/*
+OpenGL core context without any window or surface, created through EGL on
+the surfaceless Mesa platform, so that it's available on machines without
+a display server or GPU (e.g. Mesa llvmpipe). Rendering must target
+framebuffer objects, since there is no default framebuffer.
+
+Requires building the gl library with GL_ENABLE_HEADLESS; otherwise the
+constructor always throws.
+*/
+class HeadlessContext
+{
+public:
+    // Creates the context and makes it current; throws if no such context can be created
+    HeadlessContext(int major_version, int minor_version, bool debug = false);
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext(HeadlessContext&&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(HeadlessContext&&) = delete;
+    ~HeadlessContext();
+
+    // Loader of OpenGL functions, compatible with GLAD
+    static void* proc_address(const char* name);
+
+private:
+    void* display_{nullptr};
+    void* context_{nullptr};
+};
+
+} // namespace gl
+
+#endif // HEADLESS_CONTEXT_HPP
@@ -0,0 +1,115 @@
+#include "image.hpp"
+
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "renderbuffer.hpp"
+#include "state.hpp"
+
+namespace gl
+{
+
+Image read_png(std::string_view filename)
+{
+    constexpr int channels{4};
+    Image image;
+    int file_channels{0};
+    stbi_set_flip_vertically_on_load(false);
+    const std::unique_ptr<unsigned char, decltype(&stbi_image_free)> data{
+        stbi_load(std::string{filename}.c_str(), &image.width, &image.height, &file_channels, channels),
+        &stbi_image_free};
+    if (!data)
+    {
+        throw std::runtime_error("Failure to read image " + std::string{filename});
+    }
+
+    image.pixels.assign(data.get(), data.get() + static_cast<std::size_t>(image.width * image.height * channels));
+    return image;
+}
+
+void write_png(std::string_view filename, const Image& image)
+{
+    constexpr int channels{4};
+    if (stbi_write_png(std::string{filename}.c_str(), image.width, image.height, channels, image.pixels.data(),
+                       image.width * channels) == 0)
+    {
+        throw std::runtime_error("Failure to write image " + std::string{filename});
+    }
+}
+
+Image read_framebuffer(std::uint32_t framebuffer, int width, int height)
+{
+    // Multisampled framebuffers can't be read directly, so the color buffer is resolved into a single-sample one
+    const Renderbuffer color{static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), GL_RGBA8};
+    std::uint32_t resolve_framebuffer{0};
+    glCreateFramebuffers(1, &resolve_framebuffer);
+    glNamedFramebufferRenderbuffer(resolve_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color.id());
+    glBlitNamedFramebuffer(framebuffer, resolve_framebuffer, 0, 0, width, height, 0, 0, width, height,
+                           GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    Image image{.width = width, .height = height};
+    const std::size_t row_size{static_cast<std::size_t>(width) * 4};
+    image.pixels.resize(row_size * static_cast<std::size_t>(height));
+    state_cache().bind_framebuffer(resolve_framebuffer);
+    glReadnPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(image.pixels.size()),
+                  image.pixels.data());
+    state_cache().forget_framebuffer(resolve_framebuffer);
+    glDeleteFramebuffers(1, &resolve_framebuffer);
+
+    // OpenGL returns the bottom row first
+    for (std::size_t row = 0; row < static_cast<std::size_t>(height) / 2; ++row)
+    {
+        const auto top = image.pixels.begin() + static_cast<std::ptrdiff_t>(row * row_size);
+        const auto bottom =
+            image.pixels.begin() + static_cast<std::ptrdiff_t>((static_cast<std::size_t>(height) - 1 - row) * row_size);
+        std::swap_ranges(top, top + static_cast<std::ptrdiff_t>(row_size), bottom);
+    }
+    return image;
+}
+
+ImageDifference compare_images(const Image& expected, const Image& actual, int channel_tolerance)
+{
+    if (expected.width != actual.width || expected.height != actual.height ||
+        expected.pixels.size() != actual.pixels.size())
+    {
+        throw std::invalid_argument("Images of different sizes can't be compared");
+    }
+
+    ImageDifference difference;
+    std::size_t total_difference{0};
+    for (std::size_t pixel = 0; pixel < expected.pixels.size(); pixel += 4)
+    {
+        int pixel_difference{0};
+        for (std::size_t channel = pixel; channel < pixel + 4; ++channel)
+        {
+            const int channel_difference{std::abs(expected.pixels[channel] - actual.pixels[channel])};
+            pixel_difference = std::max(pixel_difference, channel_difference);
+            total_difference += static_cast<std::size_t>(channel_difference);
+        }
+        difference.max_channel_difference = std::max(difference.max_channel_difference, pixel_difference);
+        if (pixel_difference > channel_tolerance)
+        {
+            ++difference.differing_pixels;
+        }
+    }
+
+    if (!expected.pixels.empty())
+    {
+        difference.mean_channel_difference =
+            static_cast<double>(total_difference) / static_cast<double>(expected.pixels.size());
+        difference.differing_fraction =
+            static_cast<double>(difference.differing_pixels) / static_cast<double>(expected.pixels.size() / 4);
+    }
+    return difference;
+}
+
+} // namespace gl
@@ -0,0 +1,50 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace gl
+{
+
+// 8-bit RGBA image, stored row by row from the top row
+struct Image
+{
+    int width{0};
+    int height{0};
+    std::vector<std::uint8_t> pixels{};
+};
+
+// Throws if the file can't be read or decoded
+Image read_png(std::string_view filename);
+// Throws if the file can't be written
+void write_png(std::string_view filename, const Image& image);
+
+/*
+Reads the color buffer of a framebuffer, resolving it first if it's
+multisampled. Framebuffer 0 stands for the window's.
+*/
+Image read_framebuffer(std::uint32_t framebuffer, int width, int height);
+
+struct ImageDifference
+{
+    // Largest difference between two channels of corresponding pixels
+    int max_channel_difference{0};
+    double mean_channel_difference{0.0};
+    // Pixels having a channel differing by more than the tolerance
+    std::size_t differing_pixels{0};
+    double differing_fraction{0.0};
+};
+
+/*
+Compares two images of the same size channel by channel; channels differing
+by at most the tolerance (e.g. rasterization or filtering differences
+between drivers) don't count as differing pixels. Throws if the sizes differ.
+*/
+ImageDifference compare_images(const Image& expected, const Image& actual, int channel_tolerance);
+
+} // namespace gl
+
+#endif // IMAGE_HPP
@@ -5,6 +5,9 @@
 #include <numeric>
 #include <tiny_obj_loader.h>
 
+#include "cpu_profiler.hpp"
+#include "debug_output.hpp"
+#include "gpu_memory.hpp"
 #include "io.hpp"
 #include "material.hpp"
 #include "texture.hpp"
@@ -12,9 +15,87 @@
 namespace gl
 {
 
+std::vector<MeshData> convert_shape(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape,
+                                    bool has_materials)
+{
+    std::vector<MeshData> meshes;
+    std::vector<float> vertices_data;
+    bool has_normals{false};
+    bool has_tex_coords{false};
+    int material_index{has_materials && !shape.mesh.material_ids.empty() ? shape.mesh.material_ids.front() : -1};
+
+    // Attributes are detected while reading the faces, so a mesh has every attribute found so far in the shape
+    const auto add_mesh = [&]() {
+        std::vector<int> attributes_sizes{3};
+        if (has_normals)
+        {
+            attributes_sizes.emplace_back(3);
+        }
+        if (has_tex_coords)
+        {
+            attributes_sizes.emplace_back(2);
+        }
+        meshes.emplace_back(MeshData{.vertices_data = std::move(vertices_data),
+                                     .attributes_sizes = std::move(attributes_sizes),
+                                     .material_index = material_index});
+        vertices_data.clear();
+    };
+
+    std::size_t index_offset{0};
+    for (std::size_t face_index = 0; face_index < shape.mesh.num_face_vertices.size(); ++face_index)
+    {
+        // A new mesh starts on the first face with a different material
+        if (has_materials && shape.mesh.material_ids[face_index] != material_index)
+        {
+            if (!vertices_data.empty())
+            {
+                add_mesh();
+            }
+            material_index = shape.mesh.material_ids[face_index];
+        }
+
+        const std::size_t verts_per_face{shape.mesh.num_face_vertices[face_index]};
+        for (std::size_t vertex_index = 0; vertex_index < verts_per_face; ++vertex_index)
+        {
+            const tinyobj::index_t index{shape.mesh.indices[index_offset + vertex_index]};
+
+            for (int i = 0; i < 3; ++i)
+            {
+                vertices_data.emplace_back(attrib.vertices[3 * index.vertex_index + i]);
+            }
+
+            if (index.normal_index >= 0)
+            {
+                has_normals = true;
+                for (int i = 0; i < 3; ++i)
+                {
+                    vertices_data.emplace_back(attrib.normals[3 * index.normal_index + i]);
+                }
+            }
+
+            if (index.texcoord_index >= 0)
+            {
+                has_tex_coords = true;
+                for (int i = 0; i < 2; ++i)
+                {
+                    vertices_data.emplace_back(attrib.texcoords[2 * index.texcoord_index + i]);
+                }
+            }
+        }
+        index_offset += verts_per_face;
+    }
+
+    if (!vertices_data.empty())
+    {
+        add_mesh();
+    }
+    return meshes;
+}
+
 // std::unordered_map<std::string, Mesh> read_triangle_mesh(const std::string& filename, bool verbose)
 std::unordered_map<std::string, Model> read_triangle_mesh(const std::string& filename, bool verbose)
 {
+    GL_PROFILE_SCOPE_DYNAMIC("assets", "read_triangle_mesh " + filename);
     // Cannot concatenate std::string_view, must use std::string
     const static std::string base_materials_path{"assets/materials/"};
     tinyobj::ObjReaderConfig reader_config;
@@ -60,141 +141,35 @@ std::unordered_map<std::string, Model> read_triangle_mesh(const std::string& fil
             std::cout << "Shape " << shape_index << ":\n\tName: " << shape.name << std::endl;
         }
 
-        std::vector<float> vertices_data;
-        bool has_normals{false};
-        bool has_tex_coords{false};
-        std::size_t index_offset{0};
+        // The meshes and textures of a model are accounted to the model's name
+        const GpuMemoryTracker::OwnerScope owner{shape.name};
         Model model;
-
-        std::string previous_material_name{materials.empty() ? "" : materials[shape.mesh.material_ids[0]].name};
-        for (std::size_t face_index = 0; const std::size_t verts_per_face : shape.mesh.num_face_vertices)
+        for (MeshData& mesh_data : convert_shape(attrib, shape, !materials.empty()))
         {
-            for (std::size_t vertex_index = 0; vertex_index < verts_per_face; ++vertex_index)
+            Mesh mesh{std::move(mesh_data.vertices_data), std::move(mesh_data.attributes_sizes)};
+            if (debug_output().is_enabled())
             {
-                const tinyobj::index_t index{shape.mesh.indices[index_offset + vertex_index]};
-
-                for (int i = 0; i < 3; ++i)
-                {
-                    vertices_data.emplace_back(attrib.vertices[3 * index.vertex_index + i]);
-                }
-
-                if (index.normal_index >= 0)
-                {
-                    has_normals = true;
-                    for (int i = 0; i < 3; ++i)
-                    {
-                        vertices_data.emplace_back(attrib.normals[3 * index.normal_index + i]);
-                    }
-                }
-
-                if (index.texcoord_index >= 0)
-                {
-                    has_tex_coords = true;
-                    for (int i = 0; i < 2; ++i)
-                    {
-                        vertices_data.emplace_back(attrib.texcoords[2 * index.texcoord_index + i]);
-                    }
-                }
+                const std::string label{shape.name + "/" + std::to_string(model.number_of_meshes())};
+                debug_output().label(GL_VERTEX_ARRAY, mesh.vertex_array_id(), label);
+                debug_output().label(GL_BUFFER, mesh.vertex_buffer_id(), label);
             }
-
-            std::string new_material_name;
-            if (!materials.empty())
+            Material material;
+            if (mesh_data.material_index >= 0)
             {
-                const auto& current_material = materials[shape.mesh.material_ids[face_index]];
-                new_material_name = current_material.name;
-
-                /* A new mesh is detected when a face with a new material is found,
-                or when we reached the last face of the triangle mesh. If the former
-                case, the last face read from the file belongs to the next mesh,
-                not to the current mesh, and must be saved for usage later.
-                */
-                bool new_mesh{false};
-                bool save_last_face{false};
-                if (previous_material_name != new_material_name)
+                const auto& obj_material = materials[static_cast<std::size_t>(mesh_data.material_index)];
+                if (obj_material.diffuse_texname.empty())
                 {
-                    new_mesh = true;
-                    save_last_face = true;
+                    material.diffuse_color = glm::make_vec3(obj_material.diffuse);
+                    material.alpha = obj_material.dissolve;
                 }
-                else if (face_index == shape.mesh.num_face_vertices.size() - 1)
+                else
                 {
-                    new_mesh = true;
+                    const static std::string textures_path{"assets/textures/"};
+                    material.diffuse_map = create_texture_from_file(textures_path + obj_material.diffuse_texname,
+                                                                    Texture::Attributes{.internal_format = GL_SRGB});
                 }
-
-                if (new_mesh)
-                {
-                    const std::size_t previous_material_index{face_index == 0 ? 0 : face_index - 1};
-                    const auto& previous_material = materials[shape.mesh.material_ids[previous_material_index]];
-                    std::vector<int> attributes_sizes{3};
-                    if (has_normals)
-                    {
-                        attributes_sizes.emplace_back(3);
-                    }
-                    if (has_tex_coords)
-                    {
-                        attributes_sizes.emplace_back(2);
-                    }
-
-                    std::vector<float> last_face;
-                    if (save_last_face)
-                    {
-                        const int num_attributes{
-                            std::accumulate(attributes_sizes.cbegin(), attributes_sizes.cend(), 0)};
-                        const std::size_t num_elements{verts_per_face * num_attributes};
-                        last_face.reserve(num_elements);
-                        last_face.insert(last_face.end(), vertices_data.end() - num_elements, vertices_data.end());
-                        for (std::size_t i = 0; i < num_elements; ++i)
-                        {
-                            vertices_data.pop_back();
-                        }
-                    }
-                    Mesh mesh{std::move(vertices_data), std::move(attributes_sizes)};
-                    vertices_data.clear();
-                    vertices_data = std::move(last_face);
-
-                    Material material;
-                    if (previous_material.diffuse_texname.empty())
-                    {
-                        const glm::vec3 diffuse_color{glm::make_vec3(previous_material.diffuse)};
-                        material.diffuse_color = diffuse_color;
-                        material.alpha = previous_material.dissolve;
-                    }
-                    else
-                    {
-                        const static std::string textures_path{"assets/textures/"};
-                        material.diffuse_map =
-                            create_texture_from_file(textures_path + previous_material.diffuse_texname,
-                                                     Texture::Attributes{.internal_format = GL_SRGB});
-                    }
-                    model.add_mesh_render_data(std::move(mesh), std::move(material));
-                }
-            }
-
-            previous_material_name = new_material_name;
-            index_offset += verts_per_face;
-            ++face_index;
-        }
-
-        /*
-        If there was no material on the OBJ file, there will be no split based on
-        materials. Hence the vertices_data will not be empty and there will be a single
-        mesh.
-        */
-        if (!vertices_data.empty())
-        {
-            assert(materials.empty());
-            std::vector<int> attributes_sizes{3};
-            if (has_normals)
-            {
-                attributes_sizes.emplace_back(3);
             }
-            if (has_tex_coords)
-            {
-                attributes_sizes.emplace_back(2);
-            }
-
-            Mesh mesh{std::move(vertices_data), std::move(attributes_sizes)};
-            vertices_data.clear();
-            model.add_mesh_render_data(std::move(mesh), Material{});
+            model.add_mesh_render_data(std::move(mesh), std::move(material));
         }
 
         if (verbose)
@@ -203,6 +178,7 @@ std::unordered_map<std::string, Model> read_triangle_mesh(const std::string& fil
         }
 
         models.emplace(shape.name, std::move(model));
+        ++shape_index;
     }
 
     return models;
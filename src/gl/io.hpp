@@ -3,13 +3,38 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "mesh.hpp"
 #include "model.hpp"
 
+// Declared by tiny_obj_loader.h, which only the sources building these types include
+namespace tinyobj
+{
+struct attrib_t;
+struct shape_t;
+} // namespace tinyobj
+
 namespace gl
 {
 
+// Interleaved vertex data of a mesh (position, then normal and texture coordinates if any), before its upload
+struct MeshData
+{
+    std::vector<float> vertices_data;
+    std::vector<int> attributes_sizes;
+    // Index of the material of the mesh in the OBJ file, or -1 if the file has no materials
+    int material_index{-1};
+};
+
+/*
+Converts the faces of an OBJ shape to interleaved vertex data, split into a
+mesh for each run of consecutive faces sharing a material. Doesn't use
+OpenGL, so the conversion can run (and be benchmarked) without a context.
+*/
+std::vector<MeshData> convert_shape(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape,
+                                    bool has_materials);
+
 // std::unordered_map<std::string, Mesh> read_triangle_mesh(const std::string& filename, bool verbose = false);
 std::unordered_map<std::string, Model> read_triangle_mesh(const std::string& filename, bool verbose = false);
 
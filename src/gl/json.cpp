@@ -0,0 +1,42 @@
+#include "json.hpp"
+
+#include <array>
+
+namespace gl
+{
+
+void write_json_string(std::ostream& stream, std::string_view string)
+{
+    constexpr std::array<char, 16> hex_digits{'0', '1', '2', '3', '4', '5', '6', '7',
+                                              '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    stream << '"';
+    for (const char character : string)
+    {
+        switch (character)
+        {
+        case '"':
+            stream << "\\\"";
+            break;
+        case '\\':
+            stream << "\\\\";
+            break;
+        case '\n':
+            stream << "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(character) < 0x20)
+            {
+                const auto code = static_cast<unsigned char>(character);
+                stream << "\\u00" << hex_digits[code >> 4] << hex_digits[code & 0xf];
+            }
+            else
+            {
+                stream << character;
+            }
+            break;
+        }
+    }
+    stream << '"';
+}
+
+} // namespace gl
@@ -0,0 +1,15 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <ostream>
+#include <string_view>
+
+namespace gl
+{
+
+// Writes a string as a quoted JSON string, escaping quotes, backslashes and control characters
+void write_json_string(std::ostream& stream, std::string_view string);
+
+} // namespace gl
+
+#endif // JSON_HPP
@@ -0,0 +1,161 @@
+#include "light_visibility.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace gl
+{
+
+namespace
+{
+
+/*
+Planes of the frustum of a view-projection matrix (Gribb and Hartmann),
+with their normals pointing inside the frustum.
+*/
+std::array<glm::vec4, 6> frustum_planes(const glm::mat4& view_projection)
+{
+    const glm::mat4 rows{glm::transpose(view_projection)};
+    return {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+            rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]};
+}
+
+bool sphere_in_frustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius)
+{
+    return std::all_of(planes.cbegin(), planes.cend(), [&center, radius](const glm::vec4& plane) {
+        return glm::dot(glm::vec3{plane}, center) + plane.w >= -radius * glm::length(glm::vec3{plane});
+    });
+}
+
+} // namespace
+
+LightVisibility::ConditionalRender::ConditionalRender(GLuint query)
+{
+    if (query != 0)
+    {
+        // The GPU waits for the result of the query, which was issued earlier in the frame
+        glBeginConditionalRender(query, GL_QUERY_WAIT);
+        active_ = true;
+    }
+}
+
+LightVisibility::ConditionalRender::~ConditionalRender()
+{
+    if (active_)
+    {
+        glEndConditionalRender();
+    }
+}
+
+LightVisibility::LightVisibility(float fade_margin) : fade_margin_{fade_margin}
+{
+}
+
+LightVisibility::~LightVisibility()
+{
+    for (const Query& query : queries_)
+    {
+        glDeleteQueries(1, &query.id);
+    }
+}
+
+void LightVisibility::update(const std::vector<Model*>& light_models, const glm::mat4& view_projection,
+                             bool test_occlusion)
+{
+    while (queries_.size() < light_models.size())
+    {
+        glCreateQueries(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, 1, &queries_.emplace_back().id);
+    }
+    lights_.resize(light_models.size());
+    test_occlusion_ = test_occlusion;
+
+    const std::array<glm::vec4, 6> planes{frustum_planes(view_projection)};
+    for (std::size_t i = 0; i < light_models.size(); ++i)
+    {
+        Light& light = lights_[i];
+        Query& query = queries_[i];
+        query.issued_this_frame = false;
+        if (query.pending)
+        {
+            GLint available{0};
+            glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available != 0)
+            {
+                GLint samples_passed{0};
+                glGetQueryObjectiv(query.id, GL_QUERY_RESULT, &samples_passed);
+                light.occluded = samples_passed == 0;
+                query.pending = false;
+            }
+        }
+        if (!test_occlusion_)
+        {
+            light.occluded = false;
+        }
+
+        const glm::mat4 transform{light_models[i]->transform()};
+        const AABB bounds{light_models[i]->bounds().transformed(transform)};
+        const glm::vec4 clip_center{view_projection * glm::vec4{glm::vec3{transform[3]}, 1.0f}};
+        // Lights behind the camera have no position on the screen, since their w is negative
+        light.in_frustum = !bounds.empty() && clip_center.w > 0.0f &&
+                           sphere_in_frustum(planes, bounds.center(), glm::length(bounds.extents()));
+        light.intensity = 0.0f;
+        if (light.in_frustum)
+        {
+            light.screen_position = (glm::vec2{clip_center} / clip_center.w + 1.0f) * 0.5f;
+            const glm::vec2 outside{glm::max(glm::max(-light.screen_position, light.screen_position - 1.0f), 0.0f)};
+            light.intensity = 1.0f - glm::smoothstep(0.0f, fade_margin_, std::max(outside.x, outside.y));
+        }
+    }
+}
+
+void LightVisibility::begin_query(std::size_t light)
+{
+    Query& query = queries_[light];
+    if (!test_occlusion_ || !lights_[light].in_frustum || query.pending)
+    {
+        return;
+    }
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, query.id);
+    query.pending = true;
+    query.issued_this_frame = true;
+    query_active_ = true;
+}
+
+void LightVisibility::end_query()
+{
+    if (query_active_)
+    {
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        query_active_ = false;
+    }
+}
+
+GLuint LightVisibility::frame_query(std::size_t light) const
+{
+    return queries_[light].issued_this_frame ? queries_[light].id : 0;
+}
+
+const std::vector<LightVisibility::Light>& LightVisibility::lights() const
+{
+    return lights_;
+}
+
+bool LightVisibility::is_visible(std::size_t light) const
+{
+    return lights_[light].intensity > 0.0f && !lights_[light].occluded;
+}
+
+bool LightVisibility::any_visible() const
+{
+    for (std::size_t i = 0; i < lights_.size(); ++i)
+    {
+        if (is_visible(i))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace gl
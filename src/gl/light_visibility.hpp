@@ -0,0 +1,105 @@
+#ifndef LIGHT_VISIBILITY_HPP
+#define LIGHT_VISIBILITY_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "model.hpp"
+
+namespace gl
+{
+
+/*
+Visibility of light sources, which decides whether their god rays are
+rendered. Each light is tested in stages: its bounding sphere against the
+frustum, the position of its center on the screen, past whose border its
+rays fade out over a margin, and an occlusion query counting whether any
+sample of its proxy passed the depth test against the scene
+(GL_ANY_SAMPLES_PASSED_CONSERVATIVE).
+
+Query results are only read once available, typically a frame late, so the
+CPU never waits for them; a query pending for longer isn't reissued until
+its result arrives. Meanwhile, the query issued on the current frame can
+skip GPU work through conditional rendering.
+*/
+class LightVisibility
+{
+public:
+    struct Light
+    {
+        // Position of the center of the light on the screen, in texture coordinates; only valid in the frustum
+        glm::vec2 screen_position{0.0f};
+        bool in_frustum{false};
+        // Result of the last occlusion query read back; lights are considered unoccluded until tested
+        bool occluded{false};
+        // Intensity of the rays of the light, from 0 (hidden) to 1, faded past the border of the screen
+        float intensity{0.0f};
+    };
+
+    // Skips the rendering commands issued during its lifetime if the samples of a query didn't pass
+    class ConditionalRender
+    {
+    public:
+        // Query 0 renders unconditionally
+        explicit ConditionalRender(GLuint query);
+        ConditionalRender(const ConditionalRender&) = delete;
+        ConditionalRender(ConditionalRender&&) = delete;
+        ConditionalRender& operator=(const ConditionalRender&) = delete;
+        ConditionalRender& operator=(ConditionalRender&&) = delete;
+        ~ConditionalRender();
+
+    private:
+        bool active_{false};
+    };
+
+    // fade_margin is the distance past the border of the screen, in texture coordinates, where rays vanish
+    explicit LightVisibility(float fade_margin = 0.1f);
+    LightVisibility(const LightVisibility&) = delete;
+    LightVisibility(LightVisibility&&) = delete;
+    LightVisibility& operator=(const LightVisibility&) = delete;
+    LightVisibility& operator=(LightVisibility&&) = delete;
+    ~LightVisibility();
+
+    /*
+    Tests the lights against the frustum and reads back the available query
+    results; lights are bounded by the meshes of their models. Without
+    occlusion testing, e.g. when the pass issuing the queries doesn't run,
+    lights are considered unoccluded.
+    */
+    void update(const std::vector<Model*>& light_models, const glm::mat4& view_projection, bool test_occlusion);
+
+    /*
+    Wrap the draw of the proxy of a light into its occlusion query, against
+    the depth of the scene; lights outside the frustum aren't queried.
+    */
+    void begin_query(std::size_t light);
+    void end_query();
+
+    // Query issued for the light on the current frame, or 0 if there's none
+    GLuint frame_query(std::size_t light) const;
+    const std::vector<Light>& lights() const;
+    // A light is visible if its rays have an intensity and it wasn't found occluded
+    bool is_visible(std::size_t light) const;
+    bool any_visible() const;
+
+private:
+    struct Query
+    {
+        GLuint id{0};
+        bool pending{false};
+        bool issued_this_frame{false};
+    };
+
+    float fade_margin_;
+    bool test_occlusion_{false};
+    std::vector<Light> lights_{};
+    std::vector<Query> queries_{};
+    bool query_active_{false};
+};
+
+} // namespace gl
+
+#endif // LIGHT_VISIBILITY_HPP
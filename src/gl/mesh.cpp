@@ -2,7 +2,10 @@
 
 #include <glad/glad.h>
 
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
 #include "mesh.hpp"
+#include "state.hpp"
 
 namespace gl
 {
@@ -10,17 +13,20 @@ namespace gl
 Mesh::Mesh(std::vector<float> vertices_data, std::vector<int> attributes_sizes) :
     attributes_sizes_{std::move(attributes_sizes)}, stride_{std::accumulate(attributes_sizes_.cbegin(),
                                                                             attributes_sizes_.cend(), 0)},
-    number_of_vertices_{static_cast<int>(vertices_data.size()) / stride_}
+    number_of_vertices_{static_cast<int>(vertices_data.size()) / stride_}, bounds_{compute_bounds(vertices_data,
+                                                                                                  stride_)}
 {
     glGenVertexArrays(1, &vertex_array_identifier_);
-    glBindVertexArray(vertex_array_identifier_);
+    state_cache().bind_vertex_array(vertex_array_identifier_);
 
     // Create vertex buffer, allocate memory and copy vertices data to the device
-    std::uint32_t vertex_buffer_identifier{0};
-    glGenBuffers(1, &vertex_buffer_identifier);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier);
+    glGenBuffers(1, &vertex_buffer_identifier_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
     glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizei>(vertices_data.size() * sizeof(float)), vertices_data.data(),
                  GL_STATIC_DRAW);
+    frame_stats().add(FrameStats::Counter::BufferBytes, vertices_data.size() * sizeof(float));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, vertex_buffer_identifier_,
+                                   vertices_data.size() * sizeof(float));
 
     // Specify vertex format (default: position and texture coordinates)
     int offset{0};
@@ -35,9 +41,11 @@ Mesh::Mesh(std::vector<float> vertices_data, std::vector<int> attributes_sizes)
 
 Mesh::Mesh(Mesh&& other) noexcept :
     attributes_sizes_{std::move(other.attributes_sizes_)}, stride_{other.stride_},
-    number_of_vertices_{other.number_of_vertices_}, vertex_array_identifier_{other.vertex_array_identifier_}
+    number_of_vertices_{other.number_of_vertices_}, vertex_array_identifier_{other.vertex_array_identifier_},
+    vertex_buffer_identifier_{other.vertex_buffer_identifier_}, bounds_{other.bounds_}
 {
     other.vertex_array_identifier_ = 0;
+    other.vertex_buffer_identifier_ = 0;
 }
 
 Mesh& Mesh::operator=(Mesh&& other) noexcept
@@ -46,23 +54,36 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept
     std::swap(stride_, other.stride_);
     std::swap(number_of_vertices_, other.number_of_vertices_);
     std::swap(vertex_array_identifier_, other.vertex_array_identifier_);
+    std::swap(vertex_buffer_identifier_, other.vertex_buffer_identifier_);
+    std::swap(bounds_, other.bounds_);
     return *this;
 }
 
 Mesh::~Mesh()
 {
+    gpu_memory().unregister_resource(GpuMemoryTracker::Category::Buffers, vertex_buffer_identifier_);
+    glDeleteBuffers(1, &vertex_buffer_identifier_);
+    state_cache().forget_vertex_array(vertex_array_identifier_);
     glDeleteVertexArrays(1, &vertex_array_identifier_);
     vertex_array_identifier_ = 0;
+    vertex_buffer_identifier_ = 0;
 }
 
 void Mesh::bind()
 {
-    glBindVertexArray(vertex_array_identifier_);
+    state_cache().bind_vertex_array(vertex_array_identifier_);
 }
 
 void Mesh::render()
 {
     bind();
+    draw();
+}
+
+void Mesh::draw()
+{
+    frame_stats().add(FrameStats::Counter::DrawCalls);
+    frame_stats().add(FrameStats::Counter::Triangles, static_cast<std::uint64_t>(number_of_vertices_ / 3));
     glDrawArrays(GL_TRIANGLES, 0, number_of_vertices_);
 }
 
@@ -76,15 +97,49 @@ int Mesh::number_of_attributes() const
     return static_cast<int>(attributes_sizes_.size());
 }
 
+const std::vector<int>& Mesh::attributes_sizes() const
+{
+    return attributes_sizes_;
+}
+
+int Mesh::stride() const
+{
+    return stride_;
+}
+
+std::uint32_t Mesh::vertex_array_id() const
+{
+    return vertex_array_identifier_;
+}
+
+std::uint32_t Mesh::vertex_buffer_id() const
+{
+    return vertex_buffer_identifier_;
+}
+
+std::vector<float> Mesh::read_vertices_data() const
+{
+    std::vector<float> vertices_data(static_cast<std::size_t>(number_of_vertices_) * stride_);
+    glGetNamedBufferSubData(vertex_buffer_identifier_, 0, static_cast<GLsizeiptr>(vertices_data.size() * sizeof(float)),
+                            vertices_data.data());
+    return vertices_data;
+}
+
+const AABB& Mesh::bounds() const
+{
+    return bounds_;
+}
+
 PatchMesh::PatchMesh(int vertices_per_patch, std::vector<float> vertices_data) :
     Mesh{std::move(vertices_data)}, vertices_per_patch_{vertices_per_patch}
 {
     glPatchParameteri(GL_PATCH_VERTICES, vertices_per_patch_);
 }
 
-void PatchMesh::render()
+void PatchMesh::draw()
 {
-    bind();
+    // Patches are tessellated on the GPU, so their triangles aren't known
+    frame_stats().add(FrameStats::Counter::DrawCalls);
     glDrawArrays(GL_PATCHES, 0, number_of_vertices());
 }
 
@@ -96,7 +151,7 @@ IndexedMesh::IndexedMesh(std::vector<float> vertices_data, std::vector<std::uint
                                                                                static_cast<int>(indices.size())}
 {
     glCreateVertexArrays(1, &vertex_array_identifier_);
-    glBindVertexArray(vertex_array_identifier_);
+    state_cache().bind_vertex_array(vertex_array_identifier_);
 
     glGenBuffers(1, &vertex_buffer_identifier_);
     glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
@@ -105,6 +160,12 @@ IndexedMesh::IndexedMesh(std::vector<float> vertices_data, std::vector<std::uint
     glGenBuffers(1, &element_buffer_object_id_);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+    frame_stats().add(FrameStats::Counter::BufferBytes,
+                      vertices_data.size() * sizeof(float) + indices.size() * sizeof(std::uint32_t));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, vertex_buffer_identifier_,
+                                   vertices_data.size() * sizeof(float));
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Buffers, element_buffer_object_id_,
+                                   indices.size() * sizeof(std::uint32_t));
 
     int offset{0};
     for (std::size_t index = 0; index < attributes_sizes_.size(); ++index)
@@ -144,19 +205,24 @@ IndexedMesh& IndexedMesh::operator=(IndexedMesh&& mesh) noexcept
 
 IndexedMesh::~IndexedMesh()
 {
+    gpu_memory().unregister_resource(GpuMemoryTracker::Category::Buffers, element_buffer_object_id_);
+    gpu_memory().unregister_resource(GpuMemoryTracker::Category::Buffers, vertex_buffer_identifier_);
     glDeleteBuffers(1, &element_buffer_object_id_);
     glDeleteBuffers(1, &vertex_buffer_identifier_);
+    state_cache().forget_vertex_array(vertex_array_identifier_);
     glDeleteVertexArrays(1, &vertex_array_identifier_);
 }
 
 void IndexedMesh::bind()
 {
-    glBindVertexArray(vertex_array_identifier_);
+    state_cache().bind_vertex_array(vertex_array_identifier_);
 }
 
 void IndexedMesh::render()
 {
     bind();
+    frame_stats().add(FrameStats::Counter::DrawCalls);
+    frame_stats().add(FrameStats::Counter::Triangles, static_cast<std::uint64_t>(number_of_indices_ / 3));
     glDrawElements(GL_TRIANGLES, number_of_indices_, GL_UNSIGNED_INT, 0);
 }
 
@@ -166,12 +232,15 @@ void IndexedMesh::update_mesh(std::vector<float> vertices_data, std::vector<std:
     glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_data.size() * sizeof(float), vertices_data.data());
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
     glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(std::uint32_t), indices.data());
+    frame_stats().add(FrameStats::Counter::BufferBytes,
+                      vertices_data.size() * sizeof(float) + indices.size() * sizeof(std::uint32_t));
 }
 
 void IndexedMesh::update_geometry(std::vector<float> vertices_data)
 {
     glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_identifier_);
     glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_data.size() * sizeof(float), vertices_data.data());
+    frame_stats().add(FrameStats::Counter::BufferBytes, vertices_data.size() * sizeof(float));
 }
 
 int IndexedMesh::number_of_vertices() const
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "bounds.hpp"
+
 namespace gl
 {
 
@@ -19,16 +21,30 @@ public:
     virtual ~Mesh();
 
     void bind();
-    virtual void render();
+    // Binds the vertex array and issues the draw call
+    void render();
+    // Issues the draw call; the vertex array of the mesh must be bound
+    virtual void draw();
 
     int number_of_vertices() const;
     int number_of_attributes() const;
+    const std::vector<int>& attributes_sizes() const;
+    std::uint32_t vertex_array_id() const;
+    // Number of floats per vertex
+    int stride() const;
+    std::uint32_t vertex_buffer_id() const;
+    // Reads the vertices data back from the vertex buffer
+    std::vector<float> read_vertices_data() const;
+    // Object-space bounding box of the vertex positions
+    const AABB& bounds() const;
 
 private:
     std::vector<int> attributes_sizes_{};
     int stride_{0};
     int number_of_vertices_{0};
     std::uint32_t vertex_array_identifier_{0};
+    std::uint32_t vertex_buffer_identifier_{0};
+    AABB bounds_{};
 };
 
 class PatchMesh : public Mesh
@@ -42,7 +58,7 @@ public:
     PatchMesh& operator=(PatchMesh&&) = default;
     ~PatchMesh() override = default;
 
-    void render() override;
+    void draw() override;
 
 private:
     int vertices_per_patch_{0};
@@ -2,11 +2,24 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "model.hpp"
+#include "render_queue.hpp"
 #include "shader.hpp"
 
 namespace gl
 {
 
+namespace
+{
+
+// Depth of the center of the mesh's bounding box used to sort draws; see RenderQueue::make_key
+float view_depth(const Mesh& mesh, const glm::mat4& mvp)
+{
+    const glm::vec4 clip_center{mvp * glm::vec4{mesh.bounds().center(), 1.0f}};
+    return 0.5f * (clip_center.z + clip_center.w);
+}
+
+} // namespace
+
 glm::mat4 Model::transform() const
 {
     glm::mat4 transform_matrix = glm::translate(glm::mat4{1.0f}, translation);
@@ -21,20 +34,29 @@ void Model::render()
 {
     for (auto& mesh_data : render_data_)
     {
-        mesh_data.mesh.render();
+        if (mesh_data.visible)
+        {
+            mesh_data.mesh.render();
+        }
     }
 
     for (auto& mesh_data : semitransparent_render_data_)
     {
-        mesh_data.mesh.render();
+        if (mesh_data.visible)
+        {
+            mesh_data.mesh.render();
+        }
     }
 }
 
-void Model::render_opaque_meshes()
+void Model::render_opaque_meshes(bool skip_hidden)
 {
     for (auto& mesh_data : render_data_)
     {
-        mesh_data.mesh.render();
+        if (mesh_data.visible || !skip_hidden)
+        {
+            mesh_data.mesh.render();
+        }
     }
 }
 
@@ -48,6 +70,10 @@ void Model::render_textured_meshes()
     for (std::size_t i = mesh_with_texture_index; i < render_data_.size(); ++i)
     {
         auto& mesh_data = render_data_[i];
+        if (!mesh_data.visible)
+        {
+            continue;
+        }
         mesh_data.material.diffuse_map.value().bind(0);
         mesh_data.mesh.render();
     }
@@ -63,6 +89,10 @@ void Model::render_colored_meshes(ShaderProgram& shader, const std::string& unif
     for (std::size_t i = 0; i < mesh_with_texture_index; ++i)
     {
         auto& mesh_data = render_data_[i];
+        if (!mesh_data.visible)
+        {
+            continue;
+        }
         shader.set_vec3_uniform(uniform_color_name, mesh_data.material.diffuse_color);
         mesh_data.mesh.render();
     }
@@ -72,12 +102,88 @@ void Model::render_semitransparent_meshes(ShaderProgram& shader, const std::stri
 {
     for (auto& mesh_data : semitransparent_render_data_)
     {
+        if (!mesh_data.visible)
+        {
+            continue;
+        }
         const float alpha{mesh_data.material.alpha};
         shader.set_vec4_uniform(uniform_color_name, glm::vec4{mesh_data.material.diffuse_color, alpha});
         mesh_data.mesh.render();
     }
 }
 
+void Model::enqueue_opaque_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                                  ShaderProgram& textured_shader, ShaderProgram& colored_shader,
+                                  const std::string& uniform_color_name)
+{
+    const glm::mat4 mvp{view_projection * transform()};
+    const std::int32_t color_location{colored_shader.uniform_location(uniform_color_name)};
+    for (auto& mesh_data : render_data_)
+    {
+        if (!mesh_data.visible)
+        {
+            continue;
+        }
+
+        DrawPacket packet{.mesh = &mesh_data.mesh};
+        if (mesh_data.material.diffuse_map.has_value())
+        {
+            packet.program = &textured_shader;
+            packet.texture = &mesh_data.material.diffuse_map.value();
+        }
+        else
+        {
+            packet.program = &colored_shader;
+            packet.color_location = color_location;
+            packet.color = glm::vec4{mesh_data.material.diffuse_color, 1.0f};
+        }
+        packet.key = RenderQueue::make_key(pass, BlendMode::Opaque, *packet.program, packet.texture,
+                                           mesh_data.material.diffuse_color, view_depth(mesh_data.mesh, mvp));
+        queue.push(packet);
+    }
+}
+
+void Model::enqueue_opaque_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                                  ShaderProgram& shader, bool skip_hidden)
+{
+    const glm::mat4 mvp{view_projection * transform()};
+    for (auto& mesh_data : render_data_)
+    {
+        if (mesh_data.visible || !skip_hidden)
+        {
+            DrawPacket packet{.program = &shader, .mesh = &mesh_data.mesh};
+            // Depth-only draws are sorted front to back regardless of their materials
+            packet.key = RenderQueue::make_key(pass, BlendMode::Opaque, shader, nullptr, glm::vec3{0.0f},
+                                               view_depth(mesh_data.mesh, mvp));
+            queue.push(packet);
+        }
+    }
+}
+
+void Model::enqueue_semitransparent_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                                           ShaderProgram& shader, const std::string& uniform_color_name)
+{
+    const glm::mat4 mvp{view_projection * transform()};
+    const std::int32_t color_location{shader.uniform_location(uniform_color_name)};
+    for (auto& mesh_data : semitransparent_render_data_)
+    {
+        if (!mesh_data.visible)
+        {
+            continue;
+        }
+
+        const DrawPacket packet{
+            .key = RenderQueue::make_key(pass, BlendMode::Alpha, shader, nullptr, mesh_data.material.diffuse_color,
+                                         view_depth(mesh_data.mesh, mvp)),
+            .program = &shader,
+            .mesh = &mesh_data.mesh,
+            .color_location = color_location,
+            .color_with_alpha = true,
+            .color = glm::vec4{mesh_data.material.diffuse_color, mesh_data.material.alpha}};
+        queue.push(packet);
+    }
+}
+
 void Model::add_mesh_render_data(Mesh mesh, Material material)
 {
     if (material.alpha == 1.0f) // Fully opaque
@@ -97,6 +203,52 @@ std::size_t Model::number_of_meshes() const
     return render_data_.size() + semitransparent_render_data_.size();
 }
 
+AABB Model::bounds() const
+{
+    AABB model_bounds;
+    for (const auto* render_data : {&render_data_, &semitransparent_render_data_})
+    {
+        for (const auto& mesh_data : *render_data)
+        {
+            model_bounds.expand(mesh_data.mesh.bounds());
+        }
+    }
+    return model_bounds;
+}
+
+std::vector<MeshRenderData>& Model::opaque_render_data()
+{
+    return render_data_;
+}
+
+const std::vector<MeshRenderData>& Model::opaque_render_data() const
+{
+    return render_data_;
+}
+
+std::vector<MeshRenderData>& Model::semitransparent_render_data()
+{
+    return semitransparent_render_data_;
+}
+
+const std::vector<MeshRenderData>& Model::semitransparent_render_data() const
+{
+    return semitransparent_render_data_;
+}
+
+void Model::reset_visibility()
+{
+    for (auto& mesh_data : render_data_)
+    {
+        mesh_data.visible = true;
+    }
+
+    for (auto& mesh_data : semitransparent_render_data_)
+    {
+        mesh_data.visible = true;
+    }
+}
+
 void Model::sort_by_texture()
 {
     std::sort(render_data_.begin(), render_data_.end(), [](const MeshRenderData& lhs, const MeshRenderData& rhs) {
@@ -1,6 +1,7 @@
 #ifndef MODEL_HPP
 #define MODEL_HPP
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <string>
 
@@ -11,13 +12,16 @@
 namespace gl
 {
 
-// Forward declaration
+// Forward declarations
+class RenderQueue;
 class ShaderProgram;
 
 struct MeshRenderData
 {
     Mesh mesh;
     Material material;
+    // Meshes marked as not visible (e.g. by occlusion culling) are skipped when rendering
+    bool visible{true};
 
     MeshRenderData(Mesh mesh, Material material) : mesh{std::move(mesh)}, material{std::move(material)}
     {
@@ -34,13 +38,37 @@ public:
     glm::mat4 transform() const;
     // Render all meshes
     void render();
-    // Render all opaque meshes
-    void render_opaque_meshes();
+    // Render all opaque meshes; shadow casters must set skip_hidden to false,
+    // since meshes hidden from the camera may still cast visible shadows
+    void render_opaque_meshes(bool skip_hidden = true);
     void render_textured_meshes();
     void render_colored_meshes(ShaderProgram& shader, const std::string& uniform_color_name);
     void render_semitransparent_meshes(ShaderProgram& shader, const std::string& uniform_color_name);
+    /*
+    Pushes a draw packet for each visible opaque mesh to the render queue. Meshes
+    with a diffuse map are drawn with the textured shader, while the remaining
+    meshes are drawn with the colored shader, which receives the diffuse color
+    of the mesh through the uniform_color_name vec3 uniform.
+    */
+    void enqueue_opaque_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                               ShaderProgram& textured_shader, ShaderProgram& colored_shader,
+                               const std::string& uniform_color_name);
+    // Pushes a draw packet without textures nor per-draw uniforms for each opaque mesh (e.g. depth-only passes)
+    void enqueue_opaque_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                               ShaderProgram& shader, bool skip_hidden = true);
+    // Pushes a blended draw packet for each visible semitransparent mesh, sorted back to front by the queue
+    void enqueue_semitransparent_meshes(RenderQueue& queue, std::uint8_t pass, const glm::mat4& view_projection,
+                                        ShaderProgram& shader, const std::string& uniform_color_name);
     void add_mesh_render_data(Mesh mesh, Material material);
     std::size_t number_of_meshes() const;
+    // Bounding box of all meshes in model space
+    AABB bounds() const;
+    std::vector<MeshRenderData>& opaque_render_data();
+    const std::vector<MeshRenderData>& opaque_render_data() const;
+    std::vector<MeshRenderData>& semitransparent_render_data();
+    const std::vector<MeshRenderData>& semitransparent_render_data() const;
+    // Marks every mesh as visible
+    void reset_visibility();
 
     /*
     Sorts render data by textured and non-textured meshes.
@@ -0,0 +1,614 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+#include "cpu_profiler.hpp"
+#include "debug_output.hpp"
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
+#include "gpu_profiler.hpp"
+#include "state.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+bool is_depth_format(GLenum internal_format)
+{
+    switch (internal_format)
+    {
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH32F_STENCIL8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::size_t texture_bytes(const TextureDescription& description)
+{
+    // Textures generating their mipmaps allocate the levels down to the smallest dimension, like Texture does
+    GLsizei mip_levels{description.attributes.mip_levels};
+    if (description.attributes.generate_mipmap)
+    {
+        const auto min_dimension = static_cast<float>(std::min(description.width, description.height));
+        mip_levels = static_cast<GLsizei>(std::ceil(std::log2(min_dimension)));
+    }
+    return static_cast<std::size_t>(image_bytes(description.width, description.height,
+                                                description.attributes.internal_format, mip_levels));
+}
+
+} // namespace
+
+RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, std::size_t pass_index) :
+    graph_{graph}, pass_index_{pass_index}
+{
+}
+
+void RenderGraph::PassBuilder::read(ResourceHandle resource)
+{
+    assert(resource < graph_.resources_.size());
+    graph_.passes_[pass_index_].reads.emplace_back(resource);
+}
+
+void RenderGraph::PassBuilder::write(ResourceHandle resource, bool clear)
+{
+    assert(resource < graph_.resources_.size());
+    PassNode& pass = graph_.passes_[pass_index_];
+    pass.writes.emplace_back(Attachment{resource, clear});
+    // A write preserving the previous contents depends on the previous writer
+    if (!clear)
+    {
+        pass.reads.emplace_back(resource);
+    }
+}
+
+RenderGraph::Resources::Resources(RenderGraph& graph) : graph_{graph}
+{
+}
+
+Texture& RenderGraph::Resources::texture(ResourceHandle resource) const
+{
+    return graph_.texture(resource);
+}
+
+RenderGraph::~RenderGraph()
+{
+    release_framebuffers();
+}
+
+void RenderGraph::reset()
+{
+    resources_.clear();
+    passes_.clear();
+    schedule_.clear();
+    culled_passes_.clear();
+    is_compiled_ = false;
+}
+
+RenderGraph::ResourceHandle RenderGraph::create_texture(std::string name, const TextureDescription& description)
+{
+    resources_.emplace_back(ResourceNode{.name = std::move(name), .description = sized_description(description)});
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+TextureDescription RenderGraph::sized_description(const TextureDescription& description) const
+{
+    TextureDescription sized_description{description};
+    if (description.scale)
+    {
+        const auto scaled = [scale = description.scale.value()](std::uint32_t size) {
+            return std::max(static_cast<std::uint32_t>(std::lround(static_cast<float>(size) * scale)), 1u);
+        };
+        sized_description.width = scaled(swapchain_width_);
+        sized_description.height = scaled(swapchain_height_);
+    }
+    return sized_description;
+}
+
+RenderGraph::ResourceHandle RenderGraph::import_texture(std::string name, Texture& texture)
+{
+    resources_.emplace_back(
+        ResourceNode{.name = std::move(name), .description = std::nullopt, .imported_texture = &texture});
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::import_external(std::string name)
+{
+    resources_.emplace_back(ResourceNode{.name = std::move(name), .description = std::nullopt});
+    return static_cast<ResourceHandle>(resources_.size() - 1);
+}
+
+void RenderGraph::forget_texture(const Texture& texture)
+{
+    for (auto framebuffer = framebuffers_.begin(); framebuffer != framebuffers_.end();)
+    {
+        if (std::find(framebuffer->first.cbegin(), framebuffer->first.cend(), texture.id()) !=
+            framebuffer->first.cend())
+        {
+            state_cache().forget_framebuffer(framebuffer->second);
+            glDeleteFramebuffers(1, &framebuffer->second);
+            framebuffer = framebuffers_.erase(framebuffer);
+        }
+        else
+        {
+            ++framebuffer;
+        }
+    }
+}
+
+void RenderGraph::mark_output(ResourceHandle resource)
+{
+    resources_.at(resource).output = true;
+}
+
+void RenderGraph::set_default_framebuffer(std::uint32_t framebuffer)
+{
+    default_framebuffer_ = framebuffer;
+}
+
+void RenderGraph::set_swapchain_size(std::uint32_t width, std::uint32_t height)
+{
+    if (width == swapchain_width_ && height == swapchain_height_)
+    {
+        return;
+    }
+
+    swapchain_width_ = width;
+    swapchain_height_ = height;
+    // Relative targets won't match their previous size, so their textures are released rather than kept around
+    for (auto& pooled_texture : pool_)
+    {
+        if (pooled_texture.description.scale)
+        {
+            pooled_texture.unused_frames = max_unused_frames;
+        }
+    }
+}
+
+void RenderGraph::add_pass(std::string name, const SetupFunction& setup, ExecuteFunction execute)
+{
+    passes_.emplace_back(PassNode{.name = std::move(name), .execute = std::move(execute)});
+    PassBuilder builder{*this, passes_.size() - 1};
+    setup(builder);
+}
+
+void RenderGraph::compile()
+{
+    GL_PROFILE_SCOPE("frame", "Compile render graph");
+    cull_passes();
+    compute_lifetimes();
+    assign_pooled_textures();
+    create_framebuffers();
+    is_compiled_ = true;
+
+    statistics_.declared_passes = passes_.size();
+    statistics_.executed_passes = schedule_.size();
+    statistics_.transient_targets = 0;
+    statistics_.requested_bytes = 0;
+    for (const auto& resource : resources_)
+    {
+        if (resource.description && resource.first_use)
+        {
+            ++statistics_.transient_targets;
+            statistics_.requested_bytes += texture_bytes(resource.description.value());
+        }
+    }
+    statistics_.pooled_textures = pool_.size();
+    statistics_.pooled_bytes = 0;
+    for (const auto& pooled_texture : pool_)
+    {
+        statistics_.pooled_bytes += texture_bytes(pooled_texture.description);
+    }
+}
+
+void RenderGraph::cull_passes()
+{
+    // Producers of the resources read by each pass, i.e. the last pass writing each of them beforehand
+    std::vector<std::vector<std::size_t>> producers(passes_.size());
+    std::vector<std::optional<std::size_t>> last_writer(resources_.size());
+    for (std::size_t pass = 0; pass < passes_.size(); ++pass)
+    {
+        for (const ResourceHandle resource : passes_[pass].reads)
+        {
+            if (last_writer[resource])
+            {
+                producers[pass].emplace_back(last_writer[resource].value());
+            }
+        }
+
+        for (const Attachment& attachment : passes_[pass].writes)
+        {
+            last_writer[attachment.resource] = pass;
+        }
+    }
+
+    // A pass is needed if it's the last writer of an output or the producer of a needed pass
+    std::vector<bool> needed(passes_.size(), false);
+    std::vector<std::size_t> pending;
+    for (std::size_t resource = 0; resource < resources_.size(); ++resource)
+    {
+        if (resources_[resource].output && last_writer[resource])
+        {
+            pending.emplace_back(last_writer[resource].value());
+        }
+    }
+
+    while (!pending.empty())
+    {
+        const std::size_t pass{pending.back()};
+        pending.pop_back();
+        if (needed[pass])
+        {
+            continue;
+        }
+
+        needed[pass] = true;
+        pending.insert(pending.end(), producers[pass].cbegin(), producers[pass].cend());
+    }
+
+    for (std::size_t pass = 0; pass < passes_.size(); ++pass)
+    {
+        if (needed[pass])
+        {
+            schedule_.emplace_back(pass);
+        }
+        else
+        {
+            culled_passes_.emplace_back(passes_[pass].name);
+        }
+    }
+}
+
+void RenderGraph::compute_lifetimes()
+{
+    for (std::size_t order = 0; order < schedule_.size(); ++order)
+    {
+        const PassNode& pass = passes_[schedule_[order]];
+        const auto use = [this, order](ResourceHandle resource) {
+            ResourceNode& node = resources_[resource];
+            if (!node.first_use)
+            {
+                node.first_use = order;
+            }
+            node.last_use = order;
+        };
+
+        std::for_each(pass.reads.cbegin(), pass.reads.cend(), use);
+        for (const Attachment& attachment : pass.writes)
+        {
+            use(attachment.resource);
+        }
+    }
+}
+
+void RenderGraph::assign_pooled_textures()
+{
+    for (auto& pooled_texture : pool_)
+    {
+        pooled_texture.busy_until.reset();
+    }
+
+    // Assigning targets by their first use allows a texture to be reused once its previous target is dead
+    std::vector<ResourceHandle> transient_targets;
+    for (ResourceHandle resource = 0; resource < resources_.size(); ++resource)
+    {
+        if (resources_[resource].description && resources_[resource].first_use)
+        {
+            transient_targets.emplace_back(resource);
+        }
+    }
+    std::sort(transient_targets.begin(), transient_targets.end(), [this](ResourceHandle lhs, ResourceHandle rhs) {
+        return resources_[lhs].first_use.value() < resources_[rhs].first_use.value();
+    });
+
+    bool pool_changed{false};
+    for (const ResourceHandle resource : transient_targets)
+    {
+        ResourceNode& node = resources_[resource];
+        const auto available = std::find_if(pool_.begin(), pool_.end(), [&node](const PooledTexture& pooled_texture) {
+            return pooled_texture.description == node.description.value() &&
+                   (!pooled_texture.busy_until || pooled_texture.busy_until.value() < node.first_use.value());
+        });
+
+        if (available != pool_.end())
+        {
+            node.pooled_texture = static_cast<std::size_t>(available - pool_.begin());
+        }
+        else
+        {
+            const TextureDescription& description = node.description.value();
+            const GpuMemoryTracker::OwnerScope owner{"Render graph"};
+            Texture texture{description.width, description.height, description.attributes};
+            // Pooled textures are named after the first target they hold
+            debug_output().label(GL_TEXTURE, texture.id(), node.name);
+            if (description.attributes.wrap_s == GL_CLAMP_TO_BORDER ||
+                description.attributes.wrap_t == GL_CLAMP_TO_BORDER)
+            {
+                texture.set_border_color(description.border_color);
+            }
+            pool_.emplace_back(PooledTexture{.description = description, .texture = std::move(texture)});
+            node.pooled_texture = pool_.size() - 1;
+            pool_changed = true;
+        }
+
+        PooledTexture& pooled_texture = pool_[node.pooled_texture.value()];
+        pooled_texture.busy_until = node.last_use;
+        pooled_texture.unused_frames = 0;
+    }
+
+    // Release textures unused for a while (e.g. targets of passes culled by the current render mode)
+    for (auto& pooled_texture : pool_)
+    {
+        if (!pooled_texture.busy_until)
+        {
+            ++pooled_texture.unused_frames;
+        }
+    }
+
+    if (std::any_of(pool_.cbegin(), pool_.cend(), [](const PooledTexture& pooled_texture) {
+            return pooled_texture.unused_frames > max_unused_frames;
+        }))
+    {
+        std::vector<std::optional<std::size_t>> new_indices(pool_.size());
+        std::vector<PooledTexture> kept_textures;
+        for (std::size_t index = 0; index < pool_.size(); ++index)
+        {
+            if (pool_[index].unused_frames <= max_unused_frames)
+            {
+                new_indices[index] = kept_textures.size();
+                kept_textures.emplace_back(std::move(pool_[index]));
+            }
+        }
+        pool_ = std::move(kept_textures);
+
+        for (auto& node : resources_)
+        {
+            if (node.pooled_texture)
+            {
+                node.pooled_texture = new_indices[node.pooled_texture.value()];
+            }
+        }
+        pool_changed = true;
+    }
+
+    // Texture names may be reused after the pool changes, so cached framebuffers can't be trusted
+    if (pool_changed)
+    {
+        release_framebuffers();
+    }
+}
+
+void RenderGraph::create_framebuffers()
+{
+    for (std::size_t order = 0; order < schedule_.size(); ++order)
+    {
+        PassNode& pass = passes_[schedule_[order]];
+        pass.framebuffer = default_framebuffer_;
+        pass.discarded_attachments.clear();
+        pass.discarded_textures.clear();
+
+        std::vector<std::uint32_t> attachments;
+        for (const Attachment& attachment : pass.writes)
+        {
+            if (has_texture(attachment.resource))
+            {
+                attachments.emplace_back(texture(attachment.resource).id());
+            }
+        }
+
+        if (!attachments.empty())
+        {
+            auto [framebuffer, inserted] = framebuffers_.try_emplace(attachments, 0);
+            if (inserted)
+            {
+                glCreateFramebuffers(1, &framebuffer->second);
+                debug_output().label(GL_FRAMEBUFFER, framebuffer->second, pass.name);
+                GLenum color_attachment{GL_COLOR_ATTACHMENT0};
+                for (const Attachment& attachment : pass.writes)
+                {
+                    if (!has_texture(attachment.resource))
+                    {
+                        continue;
+                    }
+
+                    const GLenum internal_format{texture(attachment.resource).attributes().internal_format};
+                    const GLenum attachment_point{is_depth_format(internal_format) ? GLenum{GL_DEPTH_ATTACHMENT}
+                                                                                   : color_attachment++};
+                    glNamedFramebufferTexture(framebuffer->second, attachment_point, texture(attachment.resource).id(),
+                                              0);
+                }
+
+                if (color_attachment == GL_COLOR_ATTACHMENT0)
+                {
+                    glNamedFramebufferDrawBuffer(framebuffer->second, GL_NONE);
+                    glNamedFramebufferReadBuffer(framebuffer->second, GL_NONE);
+                }
+                else
+                {
+                    std::vector<GLenum> draw_buffers(color_attachment - GL_COLOR_ATTACHMENT0);
+                    for (std::size_t i = 0; i < draw_buffers.size(); ++i)
+                    {
+                        draw_buffers[i] = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i);
+                    }
+                    glNamedFramebufferDrawBuffers(framebuffer->second, static_cast<GLsizei>(draw_buffers.size()),
+                                                  draw_buffers.data());
+                }
+
+                if (glCheckNamedFramebufferStatus(framebuffer->second, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                {
+                    throw std::runtime_error("Framebuffer of render graph pass \"" + pass.name + "\" incomplete");
+                }
+            }
+            pass.framebuffer = framebuffer->second;
+        }
+
+        // Targets not used by later passes are discarded once the pass is executed; imported textures are kept
+        GLenum color_attachment{GL_COLOR_ATTACHMENT0};
+        for (const Attachment& attachment : pass.writes)
+        {
+            const ResourceNode& node = resources_[attachment.resource];
+            if (!has_texture(attachment.resource))
+            {
+                continue;
+            }
+
+            const GLenum attachment_point{is_depth_format(texture(attachment.resource).attributes().internal_format)
+                                              ? GLenum{GL_DEPTH_ATTACHMENT}
+                                              : color_attachment++};
+            if (node.description && node.last_use == order)
+            {
+                pass.discarded_attachments.emplace_back(attachment_point);
+            }
+        }
+
+        for (const ResourceHandle resource : pass.reads)
+        {
+            const ResourceNode& node = resources_[resource];
+            const bool written_by_pass{std::any_of(pass.writes.cbegin(), pass.writes.cend(),
+                                                   [resource](const Attachment& attachment) {
+                                                       return attachment.resource == resource;
+                                                   })};
+            if (node.description && node.last_use == order && !written_by_pass)
+            {
+                pass.discarded_textures.emplace_back(resource);
+            }
+        }
+    }
+}
+
+void RenderGraph::execute(GpuProfiler* profiler)
+{
+    if (!is_compiled_)
+    {
+        throw std::logic_error("Render graph must be compiled before being executed");
+    }
+
+    static constexpr std::array<float, 4> clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+    static constexpr float clear_depth{1.0f};
+    const Resources resources{*this};
+    for (const std::size_t pass_index : schedule_)
+    {
+        const PassNode& pass = passes_[pass_index];
+        GL_PROFILE_SCOPE_DYNAMIC("passes", pass.name);
+        if (profiler != nullptr)
+        {
+            profiler->begin(pass.name);
+        }
+        frame_stats().begin_pass(pass.name);
+        const DebugOutput::Group debug_group{pass.name};
+
+        frame_stats().add(FrameStats::Counter::FramebufferBinds);
+        state_cache().bind_framebuffer(pass.framebuffer);
+        // Passes start unscissored, since the scissor test also restricts the clears of the attachments
+        state_cache().set_scissor(ScissorState{});
+        if (pass.framebuffer != default_framebuffer_)
+        {
+            GLint color_buffer{0};
+            bool viewport_set{false};
+            for (const Attachment& attachment : pass.writes)
+            {
+                if (!has_texture(attachment.resource))
+                {
+                    continue;
+                }
+
+                const Texture& attached_texture = texture(attachment.resource);
+                if (!viewport_set)
+                {
+                    state_cache().set_viewport(0, 0, static_cast<GLsizei>(attached_texture.width()),
+                                               static_cast<GLsizei>(attached_texture.height()));
+                    viewport_set = true;
+                }
+
+                if (is_depth_format(attached_texture.attributes().internal_format))
+                {
+                    if (attachment.clear)
+                    {
+                        // The clear obeys the depth mask, which the pipeline of an earlier pass may have disabled
+                        state_cache().set_depth(DepthState{});
+                        glClearNamedFramebufferfv(pass.framebuffer, GL_DEPTH, 0, &clear_depth);
+                    }
+                }
+                else
+                {
+                    if (attachment.clear)
+                    {
+                        glClearNamedFramebufferfv(pass.framebuffer, GL_COLOR, color_buffer, clear_color.data());
+                    }
+                    ++color_buffer;
+                }
+            }
+        }
+
+        pass.execute(resources);
+
+        if (!pass.discarded_attachments.empty())
+        {
+            glInvalidateNamedFramebufferData(pass.framebuffer, static_cast<GLsizei>(pass.discarded_attachments.size()),
+                                             pass.discarded_attachments.data());
+        }
+
+        for (const ResourceHandle resource : pass.discarded_textures)
+        {
+            glInvalidateTexImage(texture(resource).id(), 0);
+        }
+
+        frame_stats().end_pass();
+        if (profiler != nullptr)
+        {
+            profiler->end();
+        }
+    }
+}
+
+const RenderGraph::Statistics& RenderGraph::statistics() const
+{
+    return statistics_;
+}
+
+const std::vector<std::string>& RenderGraph::culled_passes() const
+{
+    return culled_passes_;
+}
+
+void RenderGraph::release_framebuffers()
+{
+    for (auto& [attachments, framebuffer] : framebuffers_)
+    {
+        state_cache().forget_framebuffer(framebuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    framebuffers_.clear();
+}
+
+Texture& RenderGraph::texture(ResourceHandle resource)
+{
+    const ResourceNode& node = resources_.at(resource);
+    if (node.imported_texture != nullptr)
+    {
+        return *node.imported_texture;
+    }
+    if (!node.pooled_texture)
+    {
+        throw std::invalid_argument("Resource \"" + node.name + "\" isn't a transient target used by the frame");
+    }
+    return pool_[node.pooled_texture.value()].texture;
+}
+
+bool RenderGraph::has_texture(ResourceHandle resource) const
+{
+    const ResourceNode& node = resources_[resource];
+    return node.description || node.imported_texture != nullptr;
+}
+
+} // namespace gl
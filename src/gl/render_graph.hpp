@@ -0,0 +1,221 @@
+#ifndef RENDER_GRAPH_HPP
+#define RENDER_GRAPH_HPP
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "texture.hpp"
+
+namespace gl
+{
+
+// Forward declaration
+class GpuProfiler;
+
+// Description of a transient render target; targets with equal descriptions may share memory
+struct TextureDescription
+{
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    Texture::Attributes attributes{};
+    std::array<float, 4> border_color{0.0f, 0.0f, 0.0f, 0.0f};
+    // Size relative to the swapchain size of the graph, e.g. 0.5 for half resolution; overrides width and height
+    std::optional<float> scale{};
+
+    bool operator==(const TextureDescription&) const = default;
+};
+
+/*
+Frame render graph: passes declare the resources they read and write, and
+the graph derives from these declarations which passes must be executed.
+Resources are either transient render targets, allocated by the graph from
+a pool persistent across frames, textures imported from their owner (e.g.
+histories kept across frames), or external resources (e.g. the default
+framebuffer or buffers written by compute shaders), which only express
+dependencies between passes.
+
+The graph is rebuilt every frame: reset, declare resources and passes,
+compile and execute. Passes are executed in declaration order, which
+defines the order of the writes to each resource; passes that don't
+contribute to an output resource are culled. Transient targets whose
+lifetimes don't overlap share the same texture when their descriptions
+are equal, and attachments are invalidated after their last use so that
+the driver can discard their contents instead of storing them.
+
+Targets may be sized relative to the swapchain, i.e. the window. When the
+swapchain is resized, their pooled textures are released by the next
+compilation and the targets are reallocated at the new size.
+*/
+class RenderGraph
+{
+public:
+    using ResourceHandle = std::uint32_t;
+
+    // Declares the resources accessed by a pass
+    class PassBuilder
+    {
+    public:
+        void read(ResourceHandle resource);
+        /*
+        Transient targets and imported textures written by a pass are attached
+        to its framebuffer and cleared if requested; external resources must be
+        cleared by the pass.
+        Writes that don't clear preserve the previous contents, so they also
+        count as reads.
+        */
+        void write(ResourceHandle resource, bool clear = true);
+
+    private:
+        friend class RenderGraph;
+
+        PassBuilder(RenderGraph& graph, std::size_t pass_index);
+
+        RenderGraph& graph_;
+        std::size_t pass_index_;
+    };
+
+    // Transient targets and imported textures available to the passes during execution
+    class Resources
+    {
+    public:
+        Texture& texture(ResourceHandle resource) const;
+
+    private:
+        friend class RenderGraph;
+
+        explicit Resources(RenderGraph& graph);
+
+        RenderGraph& graph_;
+    };
+
+    struct Statistics
+    {
+        std::size_t declared_passes{0};
+        std::size_t executed_passes{0};
+        std::size_t transient_targets{0};
+        std::size_t pooled_textures{0};
+        // Memory required by the transient targets of the frame without aliasing
+        std::size_t requested_bytes{0};
+        // Memory allocated by the pool of transient targets
+        std::size_t pooled_bytes{0};
+    };
+
+    using SetupFunction = std::function<void(PassBuilder&)>;
+    using ExecuteFunction = std::function<void(const Resources&)>;
+
+    // Number of frames an unused pooled texture is kept before being released
+    static constexpr std::uint32_t max_unused_frames{120};
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph(RenderGraph&&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+    RenderGraph& operator=(RenderGraph&&) = delete;
+    ~RenderGraph();
+
+    // Removes the passes and resources of the previous frame, keeping the pool of transient targets
+    void reset();
+    ResourceHandle create_texture(std::string name, const TextureDescription& description);
+    // Description with the size of its targets, which follows the swapchain if it's relative
+    TextureDescription sized_description(const TextureDescription& description) const;
+    /*
+    Imports a texture owned outside of the graph, which must outlive the
+    frame. Unlike transient targets, its contents are never discarded.
+    */
+    ResourceHandle import_texture(std::string name, Texture& texture);
+    ResourceHandle import_external(std::string name);
+    // Releases the cached framebuffers attaching an imported texture, which must be called before deleting it
+    void forget_texture(const Texture& texture);
+    // Passes contributing to an output resource are never culled
+    void mark_output(ResourceHandle resource);
+    // Framebuffer bound by the passes without transient targets (the window's by default)
+    void set_default_framebuffer(std::uint32_t framebuffer);
+    // Size of the framebuffer of the window, to which relative targets are scaled
+    void set_swapchain_size(std::uint32_t width, std::uint32_t height);
+    void add_pass(std::string name, const SetupFunction& setup, ExecuteFunction execute);
+
+    /*
+    Culls the passes not contributing to an output, computes the lifetimes
+    of the transient targets and assigns them textures from the pool.
+    */
+    void compile();
+    /*
+    Executes the passes; each pass is measured as a scope of the profiler, if
+    given. Passes start with the scissor test disabled and may enable it in
+    their execute function; passes clearing a depth attachment start with
+    the default depth state, whose writes are enabled.
+    */
+    void execute(GpuProfiler* profiler = nullptr);
+
+    const Statistics& statistics() const;
+    // Names of the passes culled by the last compilation
+    const std::vector<std::string>& culled_passes() const;
+
+private:
+    struct Attachment
+    {
+        ResourceHandle resource;
+        bool clear;
+    };
+
+    struct ResourceNode
+    {
+        std::string name;
+        std::optional<TextureDescription> description;
+        bool output{false};
+        std::optional<std::size_t> first_use{};
+        std::optional<std::size_t> last_use{};
+        std::optional<std::size_t> pooled_texture{};
+        Texture* imported_texture{nullptr};
+    };
+
+    struct PassNode
+    {
+        std::string name;
+        std::vector<ResourceHandle> reads{};
+        std::vector<Attachment> writes{};
+        ExecuteFunction execute;
+        std::uint32_t framebuffer{0};
+        std::vector<GLenum> discarded_attachments{};
+        std::vector<ResourceHandle> discarded_textures{};
+    };
+
+    struct PooledTexture
+    {
+        TextureDescription description;
+        Texture texture;
+        std::optional<std::size_t> busy_until{};
+        std::uint32_t unused_frames{0};
+    };
+
+    std::vector<ResourceNode> resources_{};
+    std::vector<PassNode> passes_{};
+    std::vector<std::size_t> schedule_{};
+    std::vector<std::string> culled_passes_{};
+    std::vector<PooledTexture> pool_{};
+    // Framebuffers are cached by the names of their attachments
+    std::map<std::vector<std::uint32_t>, std::uint32_t> framebuffers_{};
+    Statistics statistics_{};
+    std::uint32_t default_framebuffer_{0};
+    std::uint32_t swapchain_width_{0};
+    std::uint32_t swapchain_height_{0};
+    bool is_compiled_{false};
+
+    void cull_passes();
+    void compute_lifetimes();
+    void assign_pooled_textures();
+    void create_framebuffers();
+    void release_framebuffers();
+    Texture& texture(ResourceHandle resource);
+    // Transient targets and imported textures, as opposed to external resources
+    bool has_texture(ResourceHandle resource) const;
+};
+
+} // namespace gl
+
+#endif // RENDER_GRAPH_HPP
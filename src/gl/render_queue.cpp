@@ -0,0 +1,236 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <optional>
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "cpu_profiler.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "state.hpp"
+#include "texture.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+constexpr int pass_shift{60};
+constexpr int blend_shift{58};
+
+/*
+The bit pattern of a non-negative float increases monotonically with its value,
+so the most significant bits (excluding the sign) are a logarithmically distributed
+depth bucket: precision is higher near the camera, where it's most useful.
+*/
+std::uint64_t depth_bucket(float view_depth, int bits)
+{
+    const auto depth_bits = std::bit_cast<std::uint32_t>(std::max(view_depth, 0.0f));
+    return depth_bits >> (31 - bits);
+}
+
+// Quantizes the material color to RGB565, so that draws sharing a color are adjacent
+std::uint64_t material_bits(const glm::vec3& color)
+{
+    const glm::vec3 clamped_color{glm::clamp(color, 0.0f, 1.0f)};
+    const auto red = static_cast<std::uint64_t>(clamped_color.x * 31.0f + 0.5f);
+    const auto green = static_cast<std::uint64_t>(clamped_color.y * 63.0f + 0.5f);
+    const auto blue = static_cast<std::uint64_t>(clamped_color.z * 31.0f + 0.5f);
+    return (red << 11) | (green << 5) | blue;
+}
+
+} // namespace
+
+std::uint64_t RenderQueue::make_key(std::uint8_t pass, BlendMode blend, const ShaderProgram& program,
+                                    const Texture* texture, const glm::vec3& material_color, float view_depth)
+{
+    assert(pass < max_passes);
+    // Object names are only used to group draws, so collisions of the truncated names are harmless
+    const std::uint64_t program_bits{program.id() & 0x3FFu};
+    const std::uint64_t texture_bits{(texture != nullptr) ? texture->id() & 0xFFFFu : 0u};
+    std::uint64_t key{(static_cast<std::uint64_t>(pass) << pass_shift) |
+                      (static_cast<std::uint64_t>(blend) << blend_shift)};
+
+    if (blend == BlendMode::Opaque)
+    {
+        key |= (program_bits << 48) | (texture_bits << 32) | (material_bits(material_color) << 16) |
+               depth_bucket(view_depth, 16);
+    }
+    else
+    {
+        const std::uint64_t inverted_depth{0xFFFFFFu - depth_bucket(view_depth, 24)};
+        key |= (inverted_depth << 34) | (program_bits << 24) | (material_bits(material_color) << 8) |
+               (texture_bits & 0xFFu);
+    }
+
+    return key;
+}
+
+void RenderQueue::clear()
+{
+    packets_.clear();
+    sorted_.clear();
+    is_sorted_ = true;
+}
+
+void RenderQueue::push(const DrawPacket& packet)
+{
+    assert(packet.program != nullptr && packet.mesh != nullptr);
+    packets_.emplace_back(packet);
+    is_sorted_ = false;
+}
+
+void RenderQueue::sort()
+{
+    GL_PROFILE_SCOPE("frame", "Sort render queue");
+    const std::size_t count{packets_.size()};
+    sorted_.resize(count);
+    scratch_.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        sorted_[i] = SortEntry{packets_[i].key, static_cast<std::uint32_t>(i)};
+    }
+
+    // LSD radix sort with 8-bit digits; digits shared by every key (e.g. the pass bits of an unused pass) are skipped
+    for (int shift = 0; shift < 64 && count > 1; shift += 8)
+    {
+        std::array<std::size_t, 256> offsets{};
+        for (const auto& entry : sorted_)
+        {
+            ++offsets[(entry.key >> shift) & 0xFFu];
+        }
+
+        if (offsets[(sorted_.front().key >> shift) & 0xFFu] == count)
+        {
+            continue;
+        }
+
+        std::size_t prefix_sum{0};
+        for (auto& offset : offsets)
+        {
+            const std::size_t digit_count{offset};
+            offset = prefix_sum;
+            prefix_sum += digit_count;
+        }
+
+        for (const auto& entry : sorted_)
+        {
+            scratch_[offsets[(entry.key >> shift) & 0xFFu]++] = entry;
+        }
+        std::swap(sorted_, scratch_);
+    }
+
+    is_sorted_ = true;
+}
+
+void RenderQueue::submit(std::uint8_t pass)
+{
+    assert(is_sorted_ && pass < max_passes);
+    PassStatistics& statistics = statistics_[pass];
+    statistics = PassStatistics{};
+
+    const auto pass_of = [](const SortEntry& entry) { return static_cast<std::uint8_t>(entry.key >> pass_shift); };
+    const auto first = std::partition_point(sorted_.cbegin(), sorted_.cend(),
+                                            [&pass_of, pass](const SortEntry& entry) { return pass_of(entry) < pass; });
+
+    // The state is unknown at the beginning of the pass, so the first packet always sets it
+    const ShaderProgram* current_program{nullptr};
+    const Texture* current_texture{nullptr};
+    std::uint32_t current_vertex_array{0};
+    std::optional<BlendMode> current_blend{};
+    std::optional<glm::vec4> current_color{};
+
+    for (auto entry = first; entry != sorted_.cend() && pass_of(*entry) == pass; ++entry)
+    {
+        DrawPacket& packet = packets_[entry->packet_index];
+
+        const auto blend = static_cast<BlendMode>((packet.key >> blend_shift) & 0x3u);
+        if (current_blend != blend)
+        {
+            if (blend == BlendMode::Opaque)
+            {
+                state_cache().set_blend(BlendState{});
+            }
+            else
+            {
+                state_cache().set_blend(BlendState{.enabled = true,
+                                                   .source_factor = GL_SRC_ALPHA,
+                                                   .destination_factor = GL_ONE_MINUS_SRC_ALPHA});
+            }
+            current_blend = blend;
+            ++statistics.blend_changes;
+        }
+
+        if (packet.program != current_program)
+        {
+            packet.program->use();
+            current_program = packet.program;
+            current_color.reset();
+            ++statistics.program_binds;
+        }
+        else
+        {
+            ++statistics.redundant_binds_skipped;
+        }
+
+        if (packet.texture != nullptr)
+        {
+            if (packet.texture != current_texture)
+            {
+                packet.texture->bind(0);
+                current_texture = packet.texture;
+                ++statistics.texture_binds;
+            }
+            else
+            {
+                ++statistics.redundant_binds_skipped;
+            }
+        }
+
+        if (packet.mesh->vertex_array_id() != current_vertex_array)
+        {
+            packet.mesh->bind();
+            current_vertex_array = packet.mesh->vertex_array_id();
+            ++statistics.vertex_array_binds;
+        }
+        else
+        {
+            ++statistics.redundant_binds_skipped;
+        }
+
+        if (packet.color_location != -1 && current_color != packet.color)
+        {
+            if (packet.color_with_alpha)
+            {
+                glProgramUniform4fv(packet.program->id(), packet.color_location, 1, glm::value_ptr(packet.color));
+            }
+            else
+            {
+                glProgramUniform3fv(packet.program->id(), packet.color_location, 1, glm::value_ptr(packet.color));
+            }
+            current_color = packet.color;
+            ++statistics.uniform_updates;
+        }
+
+        packet.mesh->draw();
+        ++statistics.draws;
+    }
+}
+
+std::size_t RenderQueue::size() const
+{
+    return packets_.size();
+}
+
+const PassStatistics& RenderQueue::statistics(std::uint8_t pass) const
+{
+    assert(pass < max_passes);
+    return statistics_[pass];
+}
+
+} // namespace gl
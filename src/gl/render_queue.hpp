@@ -0,0 +1,115 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace gl
+{
+
+// Forward declarations
+class Mesh;
+class ShaderProgram;
+class Texture;
+
+enum class BlendMode : std::uint8_t
+{
+    Opaque = 0,
+    // Standard alpha blending (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+    Alpha
+};
+
+/*
+A single draw call and the state it requires. The program must be fully
+set up (i.e. all uniforms shared by the pass) before the pass is submitted;
+only the per-draw color uniform is set by the queue.
+*/
+struct DrawPacket
+{
+    std::uint64_t key{0};
+    ShaderProgram* program{nullptr};
+    Mesh* mesh{nullptr};
+    // Optional diffuse map bound to texture unit 0
+    Texture* texture{nullptr};
+    // Optional per-draw color; vec3 uniforms ignore the alpha component
+    std::int32_t color_location{-1};
+    bool color_with_alpha{false};
+    glm::vec4 color{1.0f};
+};
+
+// Number of state changes and draws issued by a pass on the last submission
+struct PassStatistics
+{
+    std::size_t draws{0};
+    std::size_t program_binds{0};
+    std::size_t texture_binds{0};
+    std::size_t vertex_array_binds{0};
+    std::size_t blend_changes{0};
+    std::size_t uniform_updates{0};
+    // Binds skipped because the state was already set by the previous packet
+    std::size_t redundant_binds_skipped{0};
+};
+
+/*
+Render queue: passes push draw packets with a 64-bit sort key, the packets
+are sorted once per frame with a LSD radix sort and each pass is submitted
+in key order, skipping redundant program, texture, vertex array and blend
+state changes. Layout of the sort key (most significant bits first):
+
+    Opaque: pass (4) | blend (2) | program (10) | texture (16) | material (16) | depth (16)
+    Blended: pass (4) | blend (2) | inverted depth (24) | program (10) | material (16) | texture (8)
+
+Opaque packets are grouped by state and then sorted front to back; blended
+packets are sorted back to front, which is required for correct blending.
+*/
+class RenderQueue
+{
+public:
+    static constexpr std::size_t max_passes{16};
+
+    RenderQueue() = default;
+    RenderQueue(const RenderQueue&) = delete;
+    RenderQueue(RenderQueue&&) = default;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+    RenderQueue& operator=(RenderQueue&&) = default;
+    ~RenderQueue() = default;
+
+    /*
+    Builds the sort key of a draw. view_depth is any non-negative value that
+    increases with the distance of the draw to the camera, e.g. computed from
+    the center of its bounding box in clip space as (z + w) / 2, which works
+    for both perspective and orthographic projections.
+    */
+    static std::uint64_t make_key(std::uint8_t pass, BlendMode blend, const ShaderProgram& program,
+                                  const Texture* texture, const glm::vec3& material_color, float view_depth);
+
+    // Removes all packets, keeping the allocated memory for the next frame
+    void clear();
+    void push(const DrawPacket& packet);
+    void sort();
+    // Issues the draws of the pass in key order; sort must be called after the last push
+    void submit(std::uint8_t pass);
+
+    std::size_t size() const;
+    const PassStatistics& statistics(std::uint8_t pass) const;
+
+private:
+    struct SortEntry
+    {
+        std::uint64_t key;
+        std::uint32_t packet_index;
+    };
+
+    std::vector<DrawPacket> packets_{};
+    std::vector<SortEntry> sorted_{};
+    std::vector<SortEntry> scratch_{};
+    std::array<PassStatistics, max_passes> statistics_{};
+    bool is_sorted_{true};
+};
+
+} // namespace gl
+
+#endif // RENDER_QUEUE_HPP
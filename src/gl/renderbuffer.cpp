@@ -2,14 +2,25 @@
 
 #include <algorithm>
 
+#include "gpu_memory.hpp"
+
 namespace gl
 {
 
-Renderbuffer::Renderbuffer(std::uint32_t width, std::uint32_t height, GLenum internal_format) :
+Renderbuffer::Renderbuffer(std::uint32_t width, std::uint32_t height, GLenum internal_format, GLsizei samples) :
     width_{width}, height_{height}
 {
     glCreateRenderbuffers(1, &id_);
-    glNamedRenderbufferStorage(id_, internal_format, width_, height_);
+    if (samples > 0)
+    {
+        glNamedRenderbufferStorageMultisample(id_, samples, internal_format, width_, height_);
+    }
+    else
+    {
+        glNamedRenderbufferStorage(id_, internal_format, width_, height_);
+    }
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Renderbuffers, id_,
+                                   image_bytes(width_, height_, internal_format, 1, 1, samples));
 }
 
 Renderbuffer::Renderbuffer(Renderbuffer&& other) noexcept : width_{other.width_}, height_{other.height_}, id_{other.id_}
@@ -27,6 +38,7 @@ Renderbuffer& Renderbuffer::operator=(Renderbuffer&& other) noexcept
 
 Renderbuffer::~Renderbuffer()
 {
+    gpu_memory().unregister_resource(GpuMemoryTracker::Category::Renderbuffers, id_);
     glDeleteRenderbuffers(1, &id_);
 }
 
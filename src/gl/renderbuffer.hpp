@@ -11,7 +11,8 @@ namespace gl
 class Renderbuffer
 {
 public:
-    Renderbuffer(std::uint32_t width, std::uint32_t height, GLenum internal_format);
+    // Multisampled storage is allocated if samples is greater than 0
+    Renderbuffer(std::uint32_t width, std::uint32_t height, GLenum internal_format, GLsizei samples = 0);
     Renderbuffer(const Renderbuffer&) = delete;
     Renderbuffer(Renderbuffer&& other) noexcept;
     Renderbuffer& operator=(const Renderbuffer&) = delete;
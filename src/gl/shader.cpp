@@ -14,6 +14,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "cpu_profiler.hpp"
+#include "debug_output.hpp"
+#include "frame_stats.hpp"
+#include "state.hpp"
+
 namespace gl
 {
 
@@ -78,14 +83,21 @@ ShaderProgram::ShaderProgram(std::initializer_list<ShaderInfo> initializer) : pr
     std::vector<Shader> shaders;
     shaders.reserve(initializer.size());
 
+    std::string label;
     for (const ShaderInfo& shader_info : initializer)
     {
         shaders.emplace_back(load_shader_from_file(shader_info));
         glAttachShader(program_id_, shaders.back().identifier());
+        label += (label.empty() ? "" : ", ") + std::string{shader_info.filepath};
     }
+    debug_output().label(GL_PROGRAM, program_id_, label);
 
-    glLinkProgram(program_id_);
-    check_shader_program_link_status(program_id_, initializer);
+    {
+        // Checking the status waits for the link, which drivers may otherwise defer
+        GL_PROFILE_SCOPE("shaders", "Link shader program");
+        glLinkProgram(program_id_);
+        check_shader_program_link_status(program_id_, initializer);
+    }
 
     for (const auto& shader : shaders)
     {
@@ -97,6 +109,7 @@ ShaderProgram::ShaderProgram(std::initializer_list<ShaderInfo> initializer) : pr
 
 Shader load_shader_from_file(const ShaderInfo& shader_info)
 {
+    GL_PROFILE_SCOPE_DYNAMIC("shaders", shader_info.filepath);
     std::ifstream shader_file{shader_info.filepath.data()};
     if (!shader_file.is_open())
     {
@@ -107,7 +120,9 @@ Shader load_shader_from_file(const ShaderInfo& shader_info)
 
     std::stringstream source_code_stream;
     source_code_stream << shader_file.rdbuf();
-    return Shader{process_shader_preprocessor_directives(source_code_stream.str(), shader_info), shader_info.type};
+    Shader shader{process_shader_preprocessor_directives(source_code_stream.str(), shader_info), shader_info.type};
+    debug_output().label(GL_SHADER, shader.identifier(), shader_info.filepath);
+    return shader;
 }
 
 std::string process_shader_preprocessor_directives(std::string shader_source, const ShaderInfo& shader_info)
@@ -209,78 +224,109 @@ ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept
 
 ShaderProgram::~ShaderProgram()
 {
+    state_cache().forget_program(program_id_);
     glDeleteProgram(program_id_);
 }
 
 void ShaderProgram::use()
 {
-    glUseProgram(program_id_);
+    frame_stats().add(FrameStats::Counter::ProgramBinds);
+    state_cache().use_program(program_id_);
+}
+
+std::uint32_t ShaderProgram::id() const
+{
+    return program_id_;
+}
+
+std::int32_t ShaderProgram::uniform_location(const std::string& uniform_name) const
+{
+    const auto location = uniform_locations.find(uniform_name);
+    return (location != uniform_locations.cend()) ? static_cast<std::int32_t>(location->second) : -1;
 }
 
 void ShaderProgram::set_bool_uniform(const std::string& uniform_name, bool value)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform1i(program_id_, uniform_locations[uniform_name], static_cast<int>(value));
 }
 
 void ShaderProgram::set_int_uniform(const std::string& uniform_name, int value)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform1i(program_id_, uniform_locations[uniform_name], value);
 }
 
 void ShaderProgram::set_int_array_uniform(const std::string& uniform_name, const int* value, std::size_t count)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform1iv(program_id_, uniform_locations[uniform_name], count, value);
 }
 
 void ShaderProgram::set_float_uniform(const std::string& uniform_name, float value)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform1f(program_id_, uniform_locations[uniform_name], value);
 }
 
 void ShaderProgram::set_float_array_uniform(const std::string& uniform_name, const float* value, std::size_t count)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform1fv(program_id_, uniform_locations[uniform_name], count, value);
 }
 
 void ShaderProgram::set_vec2_uniform(const std::string& uniform_name, float x, float y)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform2f(program_id_, uniform_locations[uniform_name], x, y);
 }
 
 void ShaderProgram::set_vec2_uniform(const std::string& uniform_name, const glm::vec2& vector)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform2fv(program_id_, uniform_locations[uniform_name], 1, glm::value_ptr(vector));
 }
 
 void ShaderProgram::set_vec2_array_uniform(const std::string& uniform_name, const std::vector<glm::vec2>& vec2_array)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform2fv(program_id_, uniform_locations[uniform_name], static_cast<std::uint32_t>(vec2_array.size()),
                         glm::value_ptr(vec2_array.front()));
 }
 
+void ShaderProgram::set_uvec2_uniform(const std::string& uniform_name, const glm::uvec2& vector)
+{
+    assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
+    glProgramUniform2uiv(program_id_, uniform_locations[uniform_name], 1, glm::value_ptr(vector));
+}
+
 void ShaderProgram::set_vec3_uniform(const std::string& uniform_name, float x, float y, float z)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform3f(program_id_, uniform_locations[uniform_name], x, y, z);
 }
 
 void ShaderProgram::set_vec3_uniform(const std::string& uniform_name, const glm::vec3& vector)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform3fv(program_id_, uniform_locations[uniform_name], 1, glm::value_ptr(vector));
 }
 
 void ShaderProgram::set_vec3_array_uniform(const std::string& uniform_name, const std::vector<glm::vec3>& vec3_array)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform3fv(program_id_, uniform_locations[uniform_name], static_cast<std::uint32_t>(vec3_array.size()),
                         glm::value_ptr(vec3_array.front()));
 }
@@ -288,12 +334,14 @@ void ShaderProgram::set_vec3_array_uniform(const std::string& uniform_name, cons
 void ShaderProgram::set_vec4_uniform(const std::string& uniform_name, const glm::vec4& vector)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform4fv(program_id_, uniform_locations[uniform_name], 1, glm::value_ptr(vector));
 }
 
 void ShaderProgram::set_vec4_array_uniform(const std::string& uniform_name, const std::vector<glm::vec4>& vec4_array)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniform4fv(program_id_, uniform_locations[uniform_name], static_cast<std::uint32_t>(vec4_array.size()),
                         glm::value_ptr(vec4_array.front()));
 }
@@ -301,6 +349,7 @@ void ShaderProgram::set_vec4_array_uniform(const std::string& uniform_name, cons
 void ShaderProgram::set_mat4_uniform(const std::string& uniform_name, const glm::mat4& matrix)
 {
     assert(uniform_locations.contains(uniform_name));
+    frame_stats().add(FrameStats::Counter::UniformUploads);
     glProgramUniformMatrix4fv(program_id_, uniform_locations[uniform_name], 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
@@ -53,6 +53,9 @@ struct ShaderInfo
 class ShaderProgram
 {
 public:
+    // Locations of the active uniforms by name, looked up by every set_*_uniform call
+    using UniformLocations = std::unordered_map<std::string, std::uint32_t>;
+
     ShaderProgram() = default;
     explicit ShaderProgram(std::initializer_list<ShaderInfo> initializer);
     ShaderProgram(const ShaderProgram&) = delete;
@@ -62,6 +65,9 @@ public:
     ~ShaderProgram();
 
     void use();
+    std::uint32_t id() const;
+    // Location of an active uniform, or -1 if the program has no such uniform
+    std::int32_t uniform_location(const std::string& uniform_name) const;
     void set_bool_uniform(const std::string& uniform_name, bool value);
     void set_int_uniform(const std::string& uniform_name, int value);
     void set_int_array_uniform(const std::string& uniform_name, const int* value, std::size_t count);
@@ -70,6 +76,7 @@ public:
     void set_vec2_uniform(const std::string& uniform_name, float x, float y);
     void set_vec2_uniform(const std::string& uniform_name, const glm::vec2& vector);
     void set_vec2_array_uniform(const std::string& uniform_name, const std::vector<glm::vec2>& vec2_array);
+    void set_uvec2_uniform(const std::string& uniform_name, const glm::uvec2& vector);
     void set_vec3_uniform(const std::string& uniform_name, float x, float y, float z);
     void set_vec3_uniform(const std::string& uniform_name, const glm::vec3& vector);
     void set_vec3_array_uniform(const std::string& uniform_name, const std::vector<glm::vec3>& vec3_array);
@@ -79,7 +86,7 @@ public:
 
 private:
     std::uint32_t program_id_{0};
-    std::unordered_map<std::string, std::uint32_t> uniform_locations{};
+    UniformLocations uniform_locations{};
 
     void retrieve_uniforms();
 };
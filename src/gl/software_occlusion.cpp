@@ -0,0 +1,530 @@
+#include "software_occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+#include "cpu_profiler.hpp"
+
+namespace gl
+{
+
+namespace
+{
+
+constexpr std::size_t triangles_per_chunk{1024};
+
+/*
+Lanes abstract the instructions used to process a row of pixels, so
+the rasterization loop is written once for every instruction set.
+*/
+struct ScalarLanes
+{
+    using Float = float;
+    using Mask = bool;
+    static constexpr int width{1};
+
+    static Float broadcast(float value)
+    {
+        return value;
+    }
+    // Offset of each lane relative to the first pixel of the group
+    static Float lane_offsets()
+    {
+        return 0.0f;
+    }
+    static Float add(Float lhs, Float rhs)
+    {
+        return lhs + rhs;
+    }
+    static Float multiply(Float lhs, Float rhs)
+    {
+        return lhs * rhs;
+    }
+    static Float minimum(Float lhs, Float rhs)
+    {
+        return std::min(lhs, rhs);
+    }
+    static Mask greater_equal(Float lhs, Float rhs)
+    {
+        return lhs >= rhs;
+    }
+    static Mask less(Float lhs, Float rhs)
+    {
+        return lhs < rhs;
+    }
+    static Mask both(Mask lhs, Mask rhs)
+    {
+        return lhs && rhs;
+    }
+    static Float load(const float* address)
+    {
+        return *address;
+    }
+    static void store(float* address, Float value)
+    {
+        *address = value;
+    }
+    // Lanes of if_true where mask is set, lanes of if_false otherwise
+    static Float select(Mask mask, Float if_true, Float if_false)
+    {
+        return mask ? if_true : if_false;
+    }
+};
+
+#if defined(__AVX2__)
+struct Avx2Lanes
+{
+    using Float = __m256;
+    using Mask = __m256;
+    static constexpr int width{8};
+
+    static Float broadcast(float value)
+    {
+        return _mm256_set1_ps(value);
+    }
+    static Float lane_offsets()
+    {
+        return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    }
+    static Float add(Float lhs, Float rhs)
+    {
+        return _mm256_add_ps(lhs, rhs);
+    }
+    static Float multiply(Float lhs, Float rhs)
+    {
+        return _mm256_mul_ps(lhs, rhs);
+    }
+    static Float minimum(Float lhs, Float rhs)
+    {
+        return _mm256_min_ps(lhs, rhs);
+    }
+    static Mask greater_equal(Float lhs, Float rhs)
+    {
+        return _mm256_cmp_ps(lhs, rhs, _CMP_GE_OQ);
+    }
+    static Mask less(Float lhs, Float rhs)
+    {
+        return _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ);
+    }
+    static Mask both(Mask lhs, Mask rhs)
+    {
+        return _mm256_and_ps(lhs, rhs);
+    }
+    static Float load(const float* address)
+    {
+        return _mm256_loadu_ps(address);
+    }
+    static void store(float* address, Float value)
+    {
+        _mm256_storeu_ps(address, value);
+    }
+    static Float select(Mask mask, Float if_true, Float if_false)
+    {
+        return _mm256_blendv_ps(if_false, if_true, mask);
+    }
+};
+using NativeLanes = Avx2Lanes;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+struct SseLanes
+{
+    using Float = __m128;
+    using Mask = __m128;
+    static constexpr int width{4};
+
+    static Float broadcast(float value)
+    {
+        return _mm_set1_ps(value);
+    }
+    static Float lane_offsets()
+    {
+        return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    }
+    static Float add(Float lhs, Float rhs)
+    {
+        return _mm_add_ps(lhs, rhs);
+    }
+    static Float multiply(Float lhs, Float rhs)
+    {
+        return _mm_mul_ps(lhs, rhs);
+    }
+    static Float minimum(Float lhs, Float rhs)
+    {
+        return _mm_min_ps(lhs, rhs);
+    }
+    static Mask greater_equal(Float lhs, Float rhs)
+    {
+        return _mm_cmpge_ps(lhs, rhs);
+    }
+    static Mask less(Float lhs, Float rhs)
+    {
+        return _mm_cmplt_ps(lhs, rhs);
+    }
+    static Mask both(Mask lhs, Mask rhs)
+    {
+        return _mm_and_ps(lhs, rhs);
+    }
+    static Float load(const float* address)
+    {
+        return _mm_loadu_ps(address);
+    }
+    static void store(float* address, Float value)
+    {
+        _mm_storeu_ps(address, value);
+    }
+    static Float select(Mask mask, Float if_true, Float if_false)
+    {
+        // SSE2 has no blend instruction
+        return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+    }
+};
+using NativeLanes = SseLanes;
+#else
+using NativeLanes = ScalarLanes;
+#endif
+
+static_assert(SoftwareOcclusionCuller::tile_size % NativeLanes::width == 0,
+              "Tile rows must be a multiple of the SIMD width");
+
+/*
+Rasterizes the rows of a triangle inside the rectangle [x_begin, x_end] x [y_begin, y_end],
+keeping the closest depth on each pixel. x_begin must be aligned to the SIMD width relative
+to the start of the tile, so a group of lanes never crosses the tile boundary.
+*/
+template <typename Lanes>
+void rasterize_rows(const std::array<glm::vec3, 3>& edges, const glm::vec3& depth_plane, int x_begin, int x_end,
+                    int y_begin, int y_end, float* depth_buffer, std::uint32_t row_pitch)
+{
+    using Float = typename Lanes::Float;
+    const Float zero{Lanes::broadcast(0.0f)};
+    const Float x_limit{Lanes::broadcast(static_cast<float>(x_end) + 1.0f)};
+    const Float group_step{Lanes::broadcast(static_cast<float>(Lanes::width))};
+    const Float edge_x0{Lanes::broadcast(edges[0].x)};
+    const Float edge_x1{Lanes::broadcast(edges[1].x)};
+    const Float edge_x2{Lanes::broadcast(edges[2].x)};
+    const Float depth_x{Lanes::broadcast(depth_plane.x)};
+
+    for (int y = y_begin; y <= y_end; ++y)
+    {
+        const float pixel_center_y{static_cast<float>(y) + 0.5f};
+        const Float row_edge0{Lanes::broadcast(edges[0].y * pixel_center_y + edges[0].z)};
+        const Float row_edge1{Lanes::broadcast(edges[1].y * pixel_center_y + edges[1].z)};
+        const Float row_edge2{Lanes::broadcast(edges[2].y * pixel_center_y + edges[2].z)};
+        const Float row_depth{Lanes::broadcast(depth_plane.y * pixel_center_y + depth_plane.z)};
+
+        // Pixel indices and pixel centers of each lane
+        Float pixel_x{Lanes::add(Lanes::broadcast(static_cast<float>(x_begin)), Lanes::lane_offsets())};
+        float* row{depth_buffer + static_cast<std::size_t>(y) * row_pitch};
+        for (int x = x_begin; x <= x_end; x += Lanes::width)
+        {
+            const Float pixel_center_x{Lanes::add(pixel_x, Lanes::broadcast(0.5f))};
+            auto inside = Lanes::less(pixel_x, x_limit);
+            inside = Lanes::both(
+                inside, Lanes::greater_equal(Lanes::add(Lanes::multiply(edge_x0, pixel_center_x), row_edge0), zero));
+            inside = Lanes::both(
+                inside, Lanes::greater_equal(Lanes::add(Lanes::multiply(edge_x1, pixel_center_x), row_edge1), zero));
+            inside = Lanes::both(
+                inside, Lanes::greater_equal(Lanes::add(Lanes::multiply(edge_x2, pixel_center_x), row_edge2), zero));
+
+            const Float depth{Lanes::add(Lanes::multiply(depth_x, pixel_center_x), row_depth)};
+            const Float stored_depth{Lanes::load(row + x)};
+            Lanes::store(row + x, Lanes::select(inside, Lanes::minimum(stored_depth, depth), stored_depth));
+            pixel_x = Lanes::add(pixel_x, group_step);
+        }
+    }
+}
+
+} // namespace
+
+SoftwareOcclusionCuller::SoftwareOcclusionCuller(std::uint32_t width, std::uint32_t height,
+                                                 std::size_t number_of_threads) :
+    width_{width},
+    height_{height}, tiles_x_{(width + tile_size - 1) / tile_size}, tiles_y_{(height + tile_size - 1) / tile_size},
+    depth_buffer_(static_cast<std::size_t>(tiles_x_) * tile_size * height_, 1.0f),
+    tile_max_depth_(static_cast<std::size_t>(tiles_x_) * tiles_y_, 1.0f), thread_pool_{number_of_threads}
+{
+}
+
+void SoftwareOcclusionCuller::resize(std::uint32_t width, std::uint32_t height)
+{
+    if (width == width_ && height == height_)
+    {
+        return;
+    }
+
+    width_ = width;
+    height_ = height;
+    tiles_x_ = (width + tile_size - 1) / tile_size;
+    tiles_y_ = (height + tile_size - 1) / tile_size;
+    depth_buffer_.assign(static_cast<std::size_t>(tiles_x_) * tile_size * height_, 1.0f);
+    tile_max_depth_.assign(static_cast<std::size_t>(tiles_x_) * tiles_y_, 1.0f);
+    for (auto& bins : chunk_bins_)
+    {
+        bins.assign(tile_max_depth_.size(), {});
+    }
+}
+
+void SoftwareOcclusionCuller::set_occluders(std::vector<glm::vec3> triangles)
+{
+    occluder_triangles_ = std::move(triangles);
+    const std::size_t number_of_chunks{(number_of_occluder_triangles() + triangles_per_chunk - 1) /
+                                       triangles_per_chunk};
+    chunk_triangles_.assign(number_of_chunks, {});
+    chunk_bins_.assign(number_of_chunks, std::vector<std::vector<std::uint32_t>>(tile_max_depth_.size()));
+}
+
+std::size_t SoftwareOcclusionCuller::number_of_occluder_triangles() const
+{
+    return occluder_triangles_.size() / 3;
+}
+
+void SoftwareOcclusionCuller::render_occluders(const glm::mat4& mvp)
+{
+    GL_PROFILE_SCOPE("culling", "Render software occluders");
+    thread_pool_.parallel_for(chunk_triangles_.size(), [this, &mvp](std::size_t chunk) { setup_chunk(chunk, mvp); });
+    thread_pool_.parallel_for(tile_max_depth_.size(), [this](std::size_t tile) { rasterize_tile(tile); });
+}
+
+void SoftwareOcclusionCuller::setup_chunk(std::size_t chunk, const glm::mat4& mvp)
+{
+    GL_PROFILE_SCOPE("culling", "Bin occluders");
+    auto& triangles = chunk_triangles_[chunk];
+    auto& bins = chunk_bins_[chunk];
+    triangles.clear();
+    for (auto& bin : bins)
+    {
+        bin.clear();
+    }
+
+    const std::size_t first_triangle{chunk * triangles_per_chunk};
+    const std::size_t last_triangle{std::min(first_triangle + triangles_per_chunk, number_of_occluder_triangles())};
+    const glm::vec2 viewport{static_cast<float>(width_), static_cast<float>(height_)};
+    for (std::size_t triangle = first_triangle; triangle < last_triangle; ++triangle)
+    {
+        std::array<glm::vec3, 3> vertices{};
+        bool clipped{false};
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const glm::vec4 clip{mvp * glm::vec4{occluder_triangles_[3 * triangle + i], 1.0f}};
+            // Triangles crossing the near plane are dropped: missing occluders only make culling less aggressive
+            if (clip.z < -clip.w)
+            {
+                clipped = true;
+                break;
+            }
+            const glm::vec3 ndc{glm::vec3{clip} / clip.w};
+            vertices[i] = glm::vec3{(glm::vec2{ndc} * 0.5f + 0.5f) * viewport, ndc.z * 0.5f + 0.5f};
+        }
+
+        if (clipped)
+        {
+            continue;
+        }
+
+        const glm::vec3 edge1{vertices[1] - vertices[0]};
+        const glm::vec3 edge2{vertices[2] - vertices[0]};
+        const float double_area{edge1.x * edge2.y - edge2.x * edge1.y};
+        if (std::abs(double_area) < 1e-6f)
+        {
+            continue;
+        }
+
+        const glm::ivec4 pixel_bounds{
+            std::max(static_cast<int>(std::floor(std::min({vertices[0].x, vertices[1].x, vertices[2].x}))), 0),
+            std::max(static_cast<int>(std::floor(std::min({vertices[0].y, vertices[1].y, vertices[2].y}))), 0),
+            std::min(static_cast<int>(std::floor(std::max({vertices[0].x, vertices[1].x, vertices[2].x}))),
+                     static_cast<int>(width_) - 1),
+            std::min(static_cast<int>(std::floor(std::max({vertices[0].y, vertices[1].y, vertices[2].y}))),
+                     static_cast<int>(height_) - 1)};
+        if (pixel_bounds.x > pixel_bounds.z || pixel_bounds.y > pixel_bounds.w)
+        {
+            continue;
+        }
+
+        TriangleSetup setup{};
+        const float orientation{double_area > 0.0f ? 1.0f : -1.0f};
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const glm::vec3& start{vertices[i]};
+            const glm::vec3& end{vertices[(i + 1) % 3]};
+            setup.edges[i] = glm::vec3{orientation * (start.y - end.y), orientation * (end.x - start.x),
+                                       orientation * (start.x * end.y - start.y * end.x)};
+        }
+
+        // Depth plane z = a * x + b * y + c, biased to the farthest depth inside each pixel
+        const float depth_a{(edge1.z * edge2.y - edge2.z * edge1.y) / double_area};
+        const float depth_b{(edge2.z * edge1.x - edge1.z * edge2.x) / double_area};
+        setup.depth_plane = glm::vec3{depth_a, depth_b,
+                                      vertices[0].z - depth_a * vertices[0].x - depth_b * vertices[0].y +
+                                          0.5f * (std::abs(depth_a) + std::abs(depth_b))};
+        setup.pixel_bounds = pixel_bounds;
+
+        const auto index = static_cast<std::uint32_t>(triangles.size());
+        triangles.emplace_back(setup);
+        for (int tile_y = pixel_bounds.y / static_cast<int>(tile_size);
+             tile_y <= pixel_bounds.w / static_cast<int>(tile_size); ++tile_y)
+        {
+            for (int tile_x = pixel_bounds.x / static_cast<int>(tile_size);
+                 tile_x <= pixel_bounds.z / static_cast<int>(tile_size); ++tile_x)
+            {
+                bins[static_cast<std::size_t>(tile_y) * tiles_x_ + tile_x].emplace_back(index);
+            }
+        }
+    }
+}
+
+void SoftwareOcclusionCuller::rasterize_tile(std::size_t tile)
+{
+    GL_PROFILE_SCOPE("culling", "Rasterize tile");
+    const int tile_x0{static_cast<int>((tile % tiles_x_) * tile_size)};
+    const int tile_y0{static_cast<int>((tile / tiles_x_) * tile_size)};
+    const int tile_x1{std::min(tile_x0 + static_cast<int>(tile_size), static_cast<int>(width_)) - 1};
+    const int tile_y1{std::min(tile_y0 + static_cast<int>(tile_size), static_cast<int>(height_)) - 1};
+    const std::uint32_t pitch{row_pitch()};
+
+    for (int y = tile_y0; y <= tile_y1; ++y)
+    {
+        std::fill_n(depth_buffer_.begin() + static_cast<std::ptrdiff_t>(y) * pitch + tile_x0, tile_x1 - tile_x0 + 1,
+                    1.0f);
+    }
+
+    for (std::size_t chunk = 0; chunk < chunk_triangles_.size(); ++chunk)
+    {
+        for (const std::uint32_t index : chunk_bins_[chunk][tile])
+        {
+            const TriangleSetup& setup{chunk_triangles_[chunk][index]};
+            const int x_begin{std::max(setup.pixel_bounds.x, tile_x0)};
+            const int aligned_x_begin{tile_x0 + ((x_begin - tile_x0) & ~(NativeLanes::width - 1))};
+            rasterize_rows<NativeLanes>(setup.edges, setup.depth_plane, aligned_x_begin,
+                                        std::min(setup.pixel_bounds.z, tile_x1),
+                                        std::max(setup.pixel_bounds.y, tile_y0),
+                                        std::min(setup.pixel_bounds.w, tile_y1), depth_buffer_.data(), pitch);
+        }
+    }
+
+    float max_depth{0.0f};
+    for (int y = tile_y0; y <= tile_y1; ++y)
+    {
+        const auto row = depth_buffer_.cbegin() + static_cast<std::ptrdiff_t>(y) * pitch;
+        max_depth = std::max(max_depth, *std::max_element(row + tile_x0, row + tile_x1 + 1));
+    }
+    tile_max_depth_[tile] = max_depth;
+}
+
+bool SoftwareOcclusionCuller::is_visible(const AABB& bounds, const glm::mat4& mvp) const
+{
+    if (bounds.empty())
+    {
+        return false;
+    }
+
+    glm::vec3 ndc_min{std::numeric_limits<float>::max()};
+    glm::vec3 ndc_max{std::numeric_limits<float>::lowest()};
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec4 position{(corner & 1) ? bounds.max_corner.x : bounds.min_corner.x,
+                                 (corner & 2) ? bounds.max_corner.y : bounds.min_corner.y,
+                                 (corner & 4) ? bounds.max_corner.z : bounds.min_corner.z, 1.0f};
+        const glm::vec4 clip{mvp * position};
+        if (clip.z < -clip.w)
+        {
+            return true;
+        }
+        const glm::vec3 ndc{glm::vec3{clip} / clip.w};
+        ndc_min = glm::min(ndc_min, ndc);
+        ndc_max = glm::max(ndc_max, ndc);
+    }
+
+    // View frustum test
+    if (ndc_min.x > 1.0f || ndc_min.y > 1.0f || ndc_min.z > 1.0f || ndc_max.x < -1.0f || ndc_max.y < -1.0f)
+    {
+        return false;
+    }
+
+    // Every pixel touched by the screen space rectangle of the box must be behind an occluder
+    const int x_begin{std::max(static_cast<int>(std::floor((ndc_min.x * 0.5f + 0.5f) * width_)), 0)};
+    const int y_begin{std::max(static_cast<int>(std::floor((ndc_min.y * 0.5f + 0.5f) * height_)), 0)};
+    const int x_end{
+        std::min(static_cast<int>(std::floor((ndc_max.x * 0.5f + 0.5f) * width_)), static_cast<int>(width_) - 1)};
+    const int y_end{
+        std::min(static_cast<int>(std::floor((ndc_max.y * 0.5f + 0.5f) * height_)), static_cast<int>(height_) - 1)};
+    const float closest_depth{ndc_min.z * 0.5f + 0.5f};
+    const std::uint32_t pitch{row_pitch()};
+
+    for (int tile_y = y_begin / static_cast<int>(tile_size); tile_y <= y_end / static_cast<int>(tile_size); ++tile_y)
+    {
+        for (int tile_x = x_begin / static_cast<int>(tile_size); tile_x <= x_end / static_cast<int>(tile_size);
+             ++tile_x)
+        {
+            // Fast path: the farthest occluder of the tile is in front of the box
+            if (tile_max_depth_[static_cast<std::size_t>(tile_y) * tiles_x_ + tile_x] < closest_depth)
+            {
+                continue;
+            }
+
+            const int tile_x_begin{std::max(x_begin, tile_x * static_cast<int>(tile_size))};
+            const int tile_x_end{std::min(x_end, (tile_x + 1) * static_cast<int>(tile_size) - 1)};
+            const int tile_y_begin{std::max(y_begin, tile_y * static_cast<int>(tile_size))};
+            const int tile_y_end{std::min(y_end, (tile_y + 1) * static_cast<int>(tile_size) - 1)};
+            for (int y = tile_y_begin; y <= tile_y_end; ++y)
+            {
+                const float* row{depth_buffer_.data() + static_cast<std::size_t>(y) * pitch};
+                for (int x = tile_x_begin; x <= tile_x_end; ++x)
+                {
+                    if (row[x] >= closest_depth)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+std::uint32_t SoftwareOcclusionCuller::width() const
+{
+    return width_;
+}
+
+std::uint32_t SoftwareOcclusionCuller::height() const
+{
+    return height_;
+}
+
+const std::vector<float>& SoftwareOcclusionCuller::depth_buffer() const
+{
+    return depth_buffer_;
+}
+
+std::uint32_t SoftwareOcclusionCuller::row_pitch() const
+{
+    return tiles_x_ * tile_size;
+}
+
+std::size_t SoftwareOcclusionCuller::number_of_threads() const
+{
+    return thread_pool_.number_of_threads();
+}
+
+std::string_view SoftwareOcclusionCuller::instruction_set()
+{
+    if constexpr (NativeLanes::width == 8)
+    {
+        return "AVX2";
+    }
+    else if constexpr (NativeLanes::width == 4)
+    {
+        return "SSE2";
+    }
+    else
+    {
+        return "Scalar";
+    }
+}
+
+} // namespace gl
@@ -0,0 +1,99 @@
+#ifndef SOFTWARE_OCCLUSION_HPP
+#define SOFTWARE_OCCLUSION_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.hpp"
+#include "thread_pool.hpp"
+
+namespace gl
+{
+
+/*
+CPU occlusion culling: a small set of occluder triangles is rasterized
+into a low resolution depth buffer, which is then used to test the
+bounding boxes of the meshes before submitting them to the GPU.
+
+The depth buffer is split into tiles rasterized in parallel, and each
+row of a tile is processed with AVX2 or SSE instructions when available
+(scalar code otherwise). A pixel is covered by an occluder when its center
+is inside the triangle, so edges shared by adjacent triangles leave no
+cracks, and it stores the farthest depth of the triangle inside the pixel.
+
+This class doesn't use OpenGL, so it can run (and be benchmarked)
+without a context.
+*/
+class SoftwareOcclusionCuller
+{
+public:
+    static constexpr std::uint32_t tile_size{32};
+
+    SoftwareOcclusionCuller(std::uint32_t width, std::uint32_t height,
+                            std::size_t number_of_threads = std::thread::hardware_concurrency());
+    SoftwareOcclusionCuller(const SoftwareOcclusionCuller&) = delete;
+    SoftwareOcclusionCuller(SoftwareOcclusionCuller&&) = delete;
+    SoftwareOcclusionCuller& operator=(const SoftwareOcclusionCuller&) = delete;
+    SoftwareOcclusionCuller& operator=(SoftwareOcclusionCuller&&) = delete;
+    ~SoftwareOcclusionCuller() = default;
+
+    // Reallocates the depth buffer and the tile bins; the occluders are kept
+    void resize(std::uint32_t width, std::uint32_t height);
+
+    // Occluder geometry as a triangle list (three positions per triangle) in object space
+    void set_occluders(std::vector<glm::vec3> triangles);
+    std::size_t number_of_occluder_triangles() const;
+
+    // Clears the depth buffer and rasterizes the occluders transformed by the mvp matrix
+    void render_occluders(const glm::mat4& mvp);
+
+    /*
+    Tests an object space bounding box transformed by the mvp matrix against the depth
+    buffer. Returns false if the box is outside the view frustum or completely behind
+    the occluders. Boxes crossing the near plane are always visible.
+    */
+    bool is_visible(const AABB& bounds, const glm::mat4& mvp) const;
+
+    std::uint32_t width() const;
+    std::uint32_t height() const;
+    // Depth buffer in [0, 1] stored by rows, with row_pitch() floats per row
+    const std::vector<float>& depth_buffer() const;
+    std::uint32_t row_pitch() const;
+    std::size_t number_of_threads() const;
+
+    // Name of the instruction set used by the rasterizer
+    static std::string_view instruction_set();
+
+private:
+    // Edge functions and depth plane of a triangle in pixel coordinates
+    struct TriangleSetup
+    {
+        std::array<glm::vec3, 3> edges;
+        glm::vec3 depth_plane;
+        glm::ivec4 pixel_bounds;
+    };
+
+    std::uint32_t width_;
+    std::uint32_t height_;
+    std::uint32_t tiles_x_;
+    std::uint32_t tiles_y_;
+    std::vector<glm::vec3> occluder_triangles_;
+    std::vector<float> depth_buffer_;
+    std::vector<float> tile_max_depth_;
+    // Triangles are set up in chunks; each chunk is binned into the tiles it overlaps
+    std::vector<std::vector<TriangleSetup>> chunk_triangles_;
+    std::vector<std::vector<std::vector<std::uint32_t>>> chunk_bins_;
+    ThreadPool thread_pool_;
+
+    void setup_chunk(std::size_t chunk, const glm::mat4& mvp);
+    void rasterize_tile(std::size_t tile);
+};
+
+} // namespace gl
+
+#endif // SOFTWARE_OCCLUSION_HPP
@@ -0,0 +1,320 @@
+#include "state.hpp"
+
+#include <cassert>
+
+#include "shader.hpp"
+
+namespace gl
+{
+
+template <typename T>
+bool StateCache::update(std::optional<T>& cached, const T& value, Category category)
+{
+    Counters& category_counters = counters_[static_cast<std::size_t>(category)];
+    if (cached == value)
+    {
+        ++category_counters.avoided;
+        return false;
+    }
+
+    cached = value;
+    ++category_counters.issued;
+    return true;
+}
+
+void StateCache::use_program(std::uint32_t program)
+{
+    if (update(program_, program, Category::Program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void StateCache::bind_vertex_array(std::uint32_t vertex_array)
+{
+    if (update(vertex_array_, vertex_array, Category::VertexArray))
+    {
+        glBindVertexArray(vertex_array);
+    }
+}
+
+void StateCache::bind_texture_unit(std::uint32_t unit, std::uint32_t texture)
+{
+    // Units beyond the tracked range are always bound
+    if (unit >= max_texture_units)
+    {
+        ++counters_[static_cast<std::size_t>(Category::Texture)].issued;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+
+    if (update(textures_[unit], texture, Category::Texture))
+    {
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void StateCache::bind_framebuffer(std::uint32_t framebuffer)
+{
+    if (update(framebuffer_, framebuffer, Category::Framebuffer))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+}
+
+void StateCache::set_viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (update(viewport_, std::array<GLint, 4>{x, y, width, height}, Category::Viewport))
+    {
+        glViewport(x, y, width, height);
+    }
+}
+
+void StateCache::set_scissor(const ScissorState& scissor)
+{
+    const std::optional<ScissorState> previous{scissor_};
+    if (!update(scissor_, scissor, Category::Scissor))
+    {
+        return;
+    }
+
+    if (!previous || previous->enabled != scissor.enabled)
+    {
+        if (scissor.enabled)
+        {
+            glEnable(GL_SCISSOR_TEST);
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+
+    if (scissor.enabled && (!previous || previous->rectangle != scissor.rectangle))
+    {
+        glScissor(scissor.rectangle[0], scissor.rectangle[1], scissor.rectangle[2], scissor.rectangle[3]);
+    }
+}
+
+void StateCache::set_raster(const RasterState& raster)
+{
+    const std::optional<RasterState> previous{raster_};
+    if (!update(raster_, raster, Category::Raster))
+    {
+        return;
+    }
+
+    if (!previous || previous->cull_face != raster.cull_face)
+    {
+        if (raster.cull_face)
+        {
+            glEnable(GL_CULL_FACE);
+        }
+        else
+        {
+            glDisable(GL_CULL_FACE);
+        }
+    }
+
+    if (!previous || previous->cull_mode != raster.cull_mode)
+    {
+        glCullFace(raster.cull_mode);
+    }
+}
+
+void StateCache::set_depth(const DepthState& depth)
+{
+    const std::optional<DepthState> previous{depth_};
+    if (!update(depth_, depth, Category::Depth))
+    {
+        return;
+    }
+
+    if (!previous || previous->test != depth.test)
+    {
+        if (depth.test)
+        {
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+
+    if (!previous || previous->write != depth.write)
+    {
+        glDepthMask(depth.write ? GL_TRUE : GL_FALSE);
+    }
+
+    if (!previous || previous->function != depth.function)
+    {
+        glDepthFunc(depth.function);
+    }
+}
+
+void StateCache::set_blend(const BlendState& blend)
+{
+    const std::optional<BlendState> previous{blend_};
+    if (!update(blend_, blend, Category::Blend))
+    {
+        return;
+    }
+
+    if (!previous || previous->enabled != blend.enabled)
+    {
+        if (blend.enabled)
+        {
+            glEnable(GL_BLEND);
+        }
+        else
+        {
+            glDisable(GL_BLEND);
+        }
+    }
+
+    if (!previous || previous->source_factor != blend.source_factor ||
+        previous->destination_factor != blend.destination_factor)
+    {
+        glBlendFunc(blend.source_factor, blend.destination_factor);
+    }
+}
+
+void StateCache::forget_program(std::uint32_t program)
+{
+    if (program_ == program)
+    {
+        program_.reset();
+    }
+}
+
+void StateCache::forget_vertex_array(std::uint32_t vertex_array)
+{
+    if (vertex_array_ == vertex_array)
+    {
+        vertex_array_.reset();
+    }
+}
+
+void StateCache::forget_texture(std::uint32_t texture)
+{
+    for (auto& unit : textures_)
+    {
+        if (unit == texture)
+        {
+            unit.reset();
+        }
+    }
+}
+
+void StateCache::forget_framebuffer(std::uint32_t framebuffer)
+{
+    if (framebuffer_ == framebuffer)
+    {
+        framebuffer_.reset();
+    }
+}
+
+void StateCache::invalidate()
+{
+    program_.reset();
+    vertex_array_.reset();
+    textures_.fill(std::nullopt);
+    framebuffer_.reset();
+    viewport_.reset();
+    scissor_.reset();
+    raster_.reset();
+    depth_.reset();
+    blend_.reset();
+}
+
+const StateCache::Counters& StateCache::counters(Category category) const
+{
+    assert(category != Category::Count);
+    return counters_[static_cast<std::size_t>(category)];
+}
+
+StateCache::Counters StateCache::total_counters() const
+{
+    Counters total{};
+    for (const auto& category_counters : counters_)
+    {
+        total.issued += category_counters.issued;
+        total.avoided += category_counters.avoided;
+    }
+    return total;
+}
+
+void StateCache::reset_counters()
+{
+    counters_.fill(Counters{});
+}
+
+std::string_view StateCache::category_name(Category category)
+{
+    switch (category)
+    {
+    case Category::Program:
+        return "Program";
+    case Category::VertexArray:
+        return "Vertex array";
+    case Category::Texture:
+        return "Texture";
+    case Category::Framebuffer:
+        return "Framebuffer";
+    case Category::Viewport:
+        return "Viewport";
+    case Category::Scissor:
+        return "Scissor";
+    case Category::Blend:
+        return "Blend";
+    case Category::Depth:
+        return "Depth";
+    case Category::Raster:
+        return "Raster";
+    default:
+        return "Unknown";
+    }
+}
+
+StateCache& state_cache()
+{
+    thread_local StateCache cache{};
+    return cache;
+}
+
+PipelineState::PipelineState(ShaderProgram& program, RasterState raster, DepthState depth, BlendState blend) :
+    program_{&program}, raster_{raster}, depth_{depth}, blend_{blend}
+{
+}
+
+void PipelineState::bind() const
+{
+    program_->use();
+    StateCache& cache = state_cache();
+    cache.set_raster(raster_);
+    cache.set_depth(depth_);
+    cache.set_blend(blend_);
+}
+
+ShaderProgram& PipelineState::program() const
+{
+    return *program_;
+}
+
+const RasterState& PipelineState::raster() const
+{
+    return raster_;
+}
+
+const DepthState& PipelineState::depth() const
+{
+    return depth_;
+}
+
+const BlendState& PipelineState::blend() const
+{
+    return blend_;
+}
+
+} // namespace gl
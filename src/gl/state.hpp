@@ -0,0 +1,159 @@
+#ifndef STATE_HPP
+#define STATE_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <glad/glad.h>
+
+namespace gl
+{
+
+// Forward declaration
+class ShaderProgram;
+
+struct RasterState
+{
+    bool cull_face{true};
+    GLenum cull_mode{GL_BACK};
+
+    bool operator==(const RasterState&) const = default;
+};
+
+struct DepthState
+{
+    bool test{true};
+    bool write{true};
+    GLenum function{GL_LESS};
+
+    bool operator==(const DepthState&) const = default;
+};
+
+struct BlendState
+{
+    bool enabled{false};
+    GLenum source_factor{GL_ONE};
+    GLenum destination_factor{GL_ZERO};
+
+    bool operator==(const BlendState&) const = default;
+};
+
+struct ScissorState
+{
+    bool enabled{false};
+    // x, y, width and height in window coordinates
+    std::array<GLint, 4> rectangle{};
+
+    bool operator==(const ScissorState&) const = default;
+};
+
+/*
+Shadows the OpenGL state bound by the gl library (program, vertex array,
+texture units, framebuffer, viewport, scissor, blend, depth and cull state) and
+drops calls that wouldn't change it. State that hasn't been set through
+the cache is unknown, so the first call always reaches the driver.
+
+There's a single cache per thread, since a thread has at most one current
+context; code changing the GL state directly must call invalidate().
+*/
+class StateCache
+{
+public:
+    enum class Category
+    {
+        Program = 0,
+        VertexArray,
+        Texture,
+        Framebuffer,
+        Viewport,
+        Scissor,
+        Blend,
+        Depth,
+        Raster,
+        Count
+    };
+
+    struct Counters
+    {
+        std::size_t issued{0};
+        std::size_t avoided{0};
+    };
+
+    static constexpr std::size_t max_texture_units{32};
+
+    void use_program(std::uint32_t program);
+    void bind_vertex_array(std::uint32_t vertex_array);
+    void bind_texture_unit(std::uint32_t unit, std::uint32_t texture);
+    void bind_framebuffer(std::uint32_t framebuffer);
+    void set_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void set_scissor(const ScissorState& scissor);
+    void set_raster(const RasterState& raster);
+    void set_depth(const DepthState& depth);
+    void set_blend(const BlendState& blend);
+
+    /*
+    Objects must be forgotten when deleted: OpenGL may reuse their names,
+    so a new object could otherwise be considered already bound.
+    */
+    void forget_program(std::uint32_t program);
+    void forget_vertex_array(std::uint32_t vertex_array);
+    void forget_texture(std::uint32_t texture);
+    void forget_framebuffer(std::uint32_t framebuffer);
+
+    // Marks the whole state as unknown (e.g. after third-party code changed it)
+    void invalidate();
+
+    const Counters& counters(Category category) const;
+    Counters total_counters() const;
+    void reset_counters();
+    static std::string_view category_name(Category category);
+
+private:
+    std::optional<std::uint32_t> program_{};
+    std::optional<std::uint32_t> vertex_array_{};
+    std::array<std::optional<std::uint32_t>, max_texture_units> textures_{};
+    std::optional<std::uint32_t> framebuffer_{};
+    std::optional<std::array<GLint, 4>> viewport_{};
+    std::optional<ScissorState> scissor_{};
+    std::optional<RasterState> raster_{};
+    std::optional<DepthState> depth_{};
+    std::optional<BlendState> blend_{};
+    std::array<Counters, static_cast<std::size_t>(Category::Count)> counters_{};
+
+    // Returns true if the call must be issued, updating the cached value and the counters
+    template <typename T>
+    bool update(std::optional<T>& cached, const T& value, Category category);
+};
+
+// State cache of the context current on the calling thread
+StateCache& state_cache();
+
+/*
+Immutable pipeline state: a program with its raster, depth and blend state,
+which a pass binds with a single call. Redundant state changes between
+pipelines are dropped by the state cache.
+*/
+class PipelineState
+{
+public:
+    explicit PipelineState(ShaderProgram& program, RasterState raster = {}, DepthState depth = {},
+                           BlendState blend = {});
+
+    void bind() const;
+    ShaderProgram& program() const;
+    const RasterState& raster() const;
+    const DepthState& depth() const;
+    const BlendState& blend() const;
+
+private:
+    ShaderProgram* program_;
+    RasterState raster_;
+    DepthState depth_;
+    BlendState blend_;
+};
+
+} // namespace gl
+
+#endif // STATE_HPP
@@ -8,6 +8,12 @@
 #include <exception>
 #include <glm/glm.hpp>
 
+#include "cpu_profiler.hpp"
+#include "debug_output.hpp"
+#include "frame_stats.hpp"
+#include "gpu_memory.hpp"
+#include "state.hpp"
+
 namespace gl
 {
 
@@ -27,15 +33,21 @@ void Texture::initialize()
         attributes_.mip_levels = static_cast<GLsizei>(glm::ceil(glm::log2(min_dimension)));
     }
 
+    std::uint64_t layers{1};
     if (attributes_.target == GL_TEXTURE_2D_ARRAY)
     {
         glTextureStorage3D(id_, attributes_.mip_levels, attributes_.internal_format, width_, height_,
                            attributes_.layers.value());
+        layers = static_cast<std::uint64_t>(attributes_.layers.value());
     }
     else
     {
         glTextureStorage2D(id_, attributes_.mip_levels, attributes_.internal_format, width_, height_);
+        layers = attributes_.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
     }
+    gpu_memory().register_resource(GpuMemoryTracker::Category::Textures, id_,
+                                   image_bytes(width_, height_, attributes_.internal_format, attributes_.mip_levels,
+                                               layers));
 }
 
 void Texture::set_texture_parameters()
@@ -46,6 +58,10 @@ void Texture::set_texture_parameters()
     glTextureParameteri(id_, GL_TEXTURE_WRAP_R, attributes_.wrap_r);
     glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, attributes_.min_filter);
     glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, attributes_.mag_filter);
+    if (attributes_.swizzle)
+    {
+        glTextureParameteriv(id_, GL_TEXTURE_SWIZZLE_RGBA, attributes_.swizzle->data());
+    }
 }
 
 Texture::Texture(std::uint32_t width, std::uint32_t height) : width_{width}, height_{height}
@@ -70,17 +86,21 @@ Texture& Texture::operator=(Texture&& other) noexcept
 
 Texture::~Texture()
 {
+    state_cache().forget_texture(id_);
+    gpu_memory().unregister_resource(GpuMemoryTracker::Category::Textures, id_);
     glDeleteTextures(1, &id_);
 }
 
 void Texture::bind(std::uint32_t unit)
 {
-    glBindTextureUnit(unit, id_);
+    frame_stats().add(FrameStats::Counter::TextureBinds);
+    state_cache().bind_texture_unit(unit, id_);
 }
 
-void Texture::bind_image(std::uint32_t unit, GLenum access)
+void Texture::bind_image(std::uint32_t unit, GLenum access, GLint level)
 {
-    glBindImageTexture(unit, id_, 0, GL_FALSE, 0, access, attributes_.internal_format);
+    frame_stats().add(FrameStats::Counter::TextureBinds);
+    glBindImageTexture(unit, id_, level, GL_FALSE, 0, access, attributes_.internal_format);
 }
 
 std::uint32_t Texture::id() const
@@ -98,6 +118,16 @@ std::uint32_t Texture::height() const
     return height_;
 }
 
+GLsizei Texture::mip_levels() const
+{
+    return attributes_.mip_levels;
+}
+
+const Texture::Attributes& Texture::attributes() const
+{
+    return attributes_;
+}
+
 void Texture::set_border_color(const std::array<float, 4> border_color)
 {
     if (attributes_.wrap_s != GL_CLAMP_TO_BORDER || attributes_.wrap_t != GL_CLAMP_TO_BORDER)
@@ -110,6 +140,7 @@ void Texture::set_border_color(const std::array<float, 4> border_color)
 
 void Texture::copy_image(std::string_view filename, bool flip_on_load)
 {
+    GL_PROFILE_SCOPE_DYNAMIC("assets", filename);
     int width{0};
     int height{0};
     int number_of_channels{0};
@@ -125,6 +156,7 @@ void Texture::copy_image(std::string_view filename, bool flip_on_load)
         attributes_.pixel_data_format = GL_RED;
     }
 
+    debug_output().label(GL_TEXTURE, id_, filename);
     copy_image(data, width, height);
     stbi_image_free(data);
 
@@ -145,6 +177,10 @@ void Texture::generate_mipmap()
 void Texture::load_cubemap(const std::vector<std::string_view>& filenames, bool flip_on_load)
 {
     assert(attributes_.target == GL_TEXTURE_CUBE_MAP);
+    if (!filenames.empty())
+    {
+        debug_output().label(GL_TEXTURE, id_, filenames.front());
+    }
     stbi_set_flip_vertically_on_load(flip_on_load);
     for (std::size_t face = 0; face < filenames.size(); ++face)
     {
@@ -184,6 +220,10 @@ void Texture::load_array_texture(const std::vector<std::string_view>& filenames,
         throw std::invalid_argument("Number of images is incompatible with the number of layers of the array texture");
     }
 
+    if (!filenames.empty())
+    {
+        debug_output().label(GL_TEXTURE, id_, filenames.front());
+    }
     stbi_set_flip_vertically_on_load(flip_on_load);
     for (std::size_t layer = 0; layer < filenames.size(); ++layer)
     {
@@ -216,6 +256,7 @@ void Texture::load_array_texture(const std::vector<std::string_view>& filenames,
 
 Texture create_texture_from_file(std::string_view filename, Texture::Attributes attributes, bool flip_on_load)
 {
+    GL_PROFILE_SCOPE_DYNAMIC("assets", filename);
     int width{0};
     int height{0};
     int number_of_channels{0};
@@ -231,6 +272,7 @@ Texture create_texture_from_file(std::string_view filename, Texture::Attributes
         attributes.pixel_data_format = GL_RED;
     }
     Texture texture{static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), attributes};
+    debug_output().label(GL_TEXTURE, texture.id(), filename);
     texture.copy_image(data, width, height);
     stbi_image_free(data);
 
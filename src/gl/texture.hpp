@@ -31,6 +31,10 @@ public:
         bool generate_mipmap{false};
         GLsizei mip_levels{1};
         std::optional<GLsizei> layers{};
+        // Channels returned by sampling, e.g. the red channel of a single-channel mask in RGB; identity if empty
+        std::optional<std::array<GLint, 4>> swizzle{};
+
+        bool operator==(const Attributes&) const = default;
     };
 
     Texture(std::uint32_t width, std::uint32_t height, Attributes attributes);
@@ -49,11 +53,15 @@ public:
     void load_cubemap(const std::vector<std::string_view>& filenames, bool flip_on_load = true);
     void load_array_texture(const std::vector<std::string_view>& filenames, bool flip_on_load = true);
     void bind(std::uint32_t unit);
-    void bind_image(std::uint32_t unit, GLenum access = GL_READ_WRITE);
+    void bind_image(std::uint32_t unit, GLenum access = GL_READ_WRITE, GLint level = 0);
     std::uint32_t id() const;
     std::uint32_t width() const;
     std::uint32_t height() const;
+    GLsizei mip_levels() const;
+    const Attributes& attributes() const;
     void set_border_color(const std::array<float, 4> border_color);
+    // Fills the mip chain from the base level, e.g. after rendering into it; only if generate_mipmap is set
+    void generate_mipmap();
 
 private:
     std::uint32_t width_;
@@ -63,7 +71,6 @@ private:
 
     void initialize();
     void set_texture_parameters();
-    void generate_mipmap();
 };
 
 Texture create_texture_from_file(std::string_view filename, Texture::Attributes attributes = {},
@@ -0,0 +1,111 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+#include "cpu_profiler.hpp"
+
+namespace gl
+{
+
+ThreadPool::ThreadPool(std::size_t number_of_threads)
+{
+    const std::size_t number_of_workers{std::max<std::size_t>(number_of_threads, 1) - 1};
+    workers_.reserve(number_of_workers);
+    for (std::size_t i = 0; i < number_of_workers; ++i)
+    {
+        workers_.emplace_back([this]() {
+            GL_PROFILE_THREAD_NAME("Worker");
+            worker_loop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)>& task)
+{
+    if (workers_.empty() || count <= 1)
+    {
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            task(index);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        task_ = &task;
+        task_count_ = count;
+        next_index_.store(0);
+        finished_workers_ = 0;
+        ++generation_;
+    }
+    work_available_.notify_all();
+
+    run_tasks(task, count);
+
+    // Every worker must acknowledge the generation, so no worker can
+    // observe the task of this call after it returns
+    std::unique_lock lock{mutex_};
+    work_done_.wait(lock, [this]() { return finished_workers_ == workers_.size(); });
+    task_ = nullptr;
+}
+
+std::size_t ThreadPool::number_of_threads() const
+{
+    return workers_.size() + 1;
+}
+
+void ThreadPool::worker_loop()
+{
+    std::uint64_t seen_generation{0};
+    while (true)
+    {
+        const std::function<void(std::size_t)>* task{nullptr};
+        std::size_t count{0};
+        {
+            std::unique_lock lock{mutex_};
+            work_available_.wait(lock,
+                                 [this, seen_generation]() { return stopping_ || generation_ != seen_generation; });
+            if (stopping_)
+            {
+                return;
+            }
+
+            seen_generation = generation_;
+            task = task_;
+            count = task_count_;
+        }
+
+        run_tasks(*task, count);
+
+        {
+            std::lock_guard lock{mutex_};
+            ++finished_workers_;
+        }
+        work_done_.notify_one();
+    }
+}
+
+void ThreadPool::run_tasks(const std::function<void(std::size_t)>& task, std::size_t count)
+{
+    for (std::size_t index = next_index_.fetch_add(1); index < count; index = next_index_.fetch_add(1))
+    {
+        task(index);
+    }
+}
+
+} // namespace gl
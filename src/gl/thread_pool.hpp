@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gl
+{
+
+/*
+Small pool of persistent worker threads used to split CPU work
+(e.g. the tiles of the software occlusion rasterizer) without
+paying the cost of creating threads every frame.
+*/
+class ThreadPool
+{
+public:
+    // The calling thread also runs tasks, so number_of_threads - 1 workers are created
+    explicit ThreadPool(std::size_t number_of_threads = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    ~ThreadPool();
+
+    /*
+    Calls task(index) for every index in [0, count), distributing the
+    indices between the calling thread and the workers. Blocks until
+    all calls return. Tasks must not throw.
+    */
+    void parallel_for(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    // Number of threads running tasks, including the calling thread
+    std::size_t number_of_threads() const;
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+    const std::function<void(std::size_t)>* task_{nullptr};
+    std::size_t task_count_{0};
+    std::atomic<std::size_t> next_index_{0};
+    std::size_t finished_workers_{0};
+    std::uint64_t generation_{0};
+    bool stopping_{false};
+
+    void worker_loop();
+    void run_tasks(const std::function<void(std::size_t)>& task, std::size_t count);
+};
+
+} // namespace gl
+
+#endif // THREAD_POOL_HPP
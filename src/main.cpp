@@ -1,19 +1,212 @@
+#include <cstdint>
+#include <cstdlib>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
+#include "gl/gpu_memory.hpp"
 #include "main_application.hpp"
 
-int main()
+namespace
 {
+
+struct Options
+{
+    bool benchmark{false};
+    int width{1024};
+    int height{768};
+    gl::ContextSettings context_settings{};
+    MainApplication::BenchmarkSettings benchmark_settings{};
+    // The benchmark report is printed to the standard output if no file is given
+    std::string output_filename{};
+    std::string track_filename{};
+    // Video memory above which a warning is printed, in MiB
+    std::optional<int> memory_budget{};
+    MainApplication::BlurMethod blur_method{MainApplication::BlurMethod::SinglePass};
+};
+
+constexpr std::string_view usage{
+    "Usage: main [--width W] [--height H] [--samples S] [--memory-budget MIB] [--debug]\n"
+    "            [--blur single|multi-pass|compute|epipolar|temporal]\n"
+    "            [--benchmark [--frames N | --track FILE] [--warmup N] [--output FILE]]\n"
+    "  --benchmark  Render the scripted camera path offscreen, without a window, and print frame times as JSON\n"
+    "  --track      Follow a camera track recorded from the GUI instead of the scripted camera path\n"
+    "  --memory-budget  Warn when the textures, renderbuffers and buffers exceed MIB mebibytes\n"
+    "  --debug      Enable the driver's debug output, label GL objects and log performance warnings\n"
+    "  --blur       Implementation of the radial blur, e.g. to benchmark them against each other\n"};
+
+int parse_integer(std::string_view option, std::string_view value, int minimum)
+{
+    std::size_t parsed_characters{0};
+    int integer{0};
+    try
+    {
+        integer = std::stoi(std::string{value}, &parsed_characters);
+    }
+    catch (const std::exception&)
+    {
+        parsed_characters = 0;
+    }
+
+    if (parsed_characters != value.size() || integer < minimum)
+    {
+        throw std::invalid_argument("Invalid value " + std::string{value} + " for option " + std::string{option});
+    }
+    return integer;
+}
+
+Options parse_options(const std::vector<std::string_view>& arguments)
+{
+    Options options;
+    for (std::size_t i = 0; i < arguments.size(); ++i)
+    {
+        const std::string_view option{arguments[i]};
+        if (option == "--benchmark")
+        {
+            options.benchmark = true;
+            continue;
+        }
+        if (option == "--debug")
+        {
+            options.context_settings.debug = true;
+            continue;
+        }
+
+        if (i + 1 == arguments.size())
+        {
+            throw std::invalid_argument("Unknown option or missing value: " + std::string{option});
+        }
+        const std::string_view value{arguments[++i]};
+        if (option == "--frames")
+        {
+            options.benchmark_settings.frames = static_cast<std::size_t>(parse_integer(option, value, 1));
+        }
+        else if (option == "--warmup")
+        {
+            options.benchmark_settings.warmup_frames = static_cast<std::size_t>(parse_integer(option, value, 0));
+        }
+        else if (option == "--width")
+        {
+            options.width = parse_integer(option, value, 1);
+        }
+        else if (option == "--height")
+        {
+            options.height = parse_integer(option, value, 1);
+        }
+        else if (option == "--samples")
+        {
+            options.context_settings.samples = parse_integer(option, value, 0);
+        }
+        else if (option == "--track")
+        {
+            options.track_filename = value;
+        }
+        else if (option == "--memory-budget")
+        {
+            options.memory_budget = parse_integer(option, value, 1);
+        }
+        else if (option == "--blur")
+        {
+            if (value == "single")
+            {
+                options.blur_method = MainApplication::BlurMethod::SinglePass;
+            }
+            else if (value == "multi-pass")
+            {
+                options.blur_method = MainApplication::BlurMethod::MultiPass;
+            }
+            else if (value == "compute")
+            {
+                options.blur_method = MainApplication::BlurMethod::Compute;
+            }
+            else if (value == "epipolar")
+            {
+                options.blur_method = MainApplication::BlurMethod::Epipolar;
+            }
+            else if (value == "temporal")
+            {
+                options.blur_method = MainApplication::BlurMethod::Temporal;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid value " + std::string{value} + " for option " +
+                                            std::string{option});
+            }
+        }
+        else if (option == "--output")
+        {
+            options.output_filename = value;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option: " + std::string{option});
+        }
+    }
+
+    // Benchmarks run without a window, so that they also run on machines without a display
+    options.context_settings.headless = options.benchmark;
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try
+    {
+        options = parse_options(std::vector<std::string_view>(argv + 1, argv + argc));
+    }
+    catch (const std::invalid_argument& exception)
+    {
+        std::cerr << exception.what() << '\n' << usage;
+        return EXIT_FAILURE;
+    }
+
+    if (options.memory_budget)
+    {
+        gl::gpu_memory().set_budget(static_cast<std::uint64_t>(options.memory_budget.value()) * 1024 * 1024);
+    }
+
     try
     {
-        MainApplication application{1024, 768, "Screen Space Godrays"};
-        application.run();
+        MainApplication application{options.width, options.height, "Screen Space Godrays", options.context_settings};
+        application.set_blur_method(options.blur_method);
+        if (!options.benchmark)
+        {
+            application.run();
+            return EXIT_SUCCESS;
+        }
+
+        if (!options.track_filename.empty())
+        {
+            options.benchmark_settings.camera_track = gl::CameraTrack::load(options.track_filename);
+        }
+        const gl::BenchmarkReport report{application.run_benchmark(options.benchmark_settings)};
+        if (options.output_filename.empty())
+        {
+            gl::write_json(std::cout, report);
+        }
+        else
+        {
+            std::ofstream file{options.output_filename};
+            if (!file)
+            {
+                throw std::runtime_error("Failure to open file " + options.output_filename + " for writing");
+            }
+            gl::write_json(file, report);
+        }
     }
     catch (const std::exception& exception)
     {
         std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
     }
 
-    return 0;
-}
\ No newline at end of file
+    return EXIT_SUCCESS;
+}
@@ -6,101 +6,452 @@
 #include <glad/glad.h>
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <iostream>
+#include <map>
 #include <optional>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "gl/cpu_profiler.hpp"
+#include "gl/debug_output.hpp"
+#include "gl/frame_stats.hpp"
+#include "gl/gpu_memory.hpp"
 #include "gl/io.hpp"
 #include "gl/texture.hpp"
 #include "main_application.hpp"
 
-MainApplication::MainApplication(int window_width, int window_height, std::string_view title) :
-    gl::Application(window_width, window_height, title)
+namespace
+{
+
+// Pixels of the side of the tiles of the compute blur; must match TILE_SIZE of compute_blur.glsl
+constexpr std::uint32_t compute_blur_tile_size{16};
+
+/*
+Epipolar lines of the epipolar blur, spread along the border of the screen,
+and samples per line. Each line is scanned for epipolar_decay_rates decay
+rates, those of rays 1, 1/2, 1/4... times as long as the line.
+*/
+constexpr std::uint32_t epipolar_lines{1024};
+constexpr std::uint32_t epipolar_samples{256};
+constexpr std::uint32_t epipolar_decay_rates{4};
+
+/*
+Displacement of the first light on the screen, in texture coordinates, due
+to its own motion rather than the camera's, above which the history of the
+temporal blur is dropped.
+*/
+constexpr float temporal_light_motion_threshold{0.002f};
+
+// Contribution of the blur to a pixel under which it's left out of the blur region: a step of an 8-bit channel
+constexpr float blur_region_threshold{1.0f / 255.0f};
+// Pixels added around the blur region, covering the bilinear footprint of the blur targets
+constexpr int blur_region_margin{2};
+
+/*
+Upper bound of the contribution of Mitchell's blur of a light source to a
+pixel at a distance from the center of the source, both in pixels, for a
+source of intensity at most 1 on a black occlusion map. The taps of the ray
+of the pixel only reach the source after (1 - radius / distance) of the
+ray's num_samples taps over density times the distance, then cross it over
+at most its diameter.
+*/
+float blur_contribution_bound(float distance, float radius, int num_samples, float density, float decay,
+                              float weight)
+{
+    const float samples{static_cast<float>(num_samples)};
+    const float ray_length{density * distance};
+    if (distance <= radius)
+    {
+        return weight * samples;
+    }
+    if (num_samples <= 0 || ray_length < distance - radius)
+    {
+        return 0.0f;
+    }
+
+    const float taps_per_pixel{samples / ray_length};
+    const float first_tap{std::max(taps_per_pixel * (distance - radius), 1.0f)};
+    const float taps_on_source{std::min(samples, taps_per_pixel * 2.0f * radius + 1.0f)};
+    // Sum of the decays of the taps on the source, bounded by the geometric series
+    const float decay_sum{decay < 1.0f ? std::min(taps_on_source, 1.0f / (1.0f - decay)) : taps_on_source};
+    return weight * std::pow(decay, first_tap - 1.0f) * decay_sum;
+}
+
+// Viewport covering a whole texture
+std::array<int, 4> texture_viewport(const gl::Texture& texture)
+{
+    return {0, 0, static_cast<int>(texture.width()), static_cast<int>(texture.height())};
+}
+
+// Van der Corput sequence in base 2, i.e. the bits of the index mirrored around the binary point
+float van_der_corput(std::uint32_t index)
+{
+    float value{0.0f};
+    for (float bit = 0.5f; index != 0; index >>= 1, bit *= 0.5f)
+    {
+        if ((index & 1) != 0)
+        {
+            value += bit;
+        }
+    }
+    return value;
+}
+
+/*
+Average taps per pixel of the adaptive single-pass blur towards a light,
+estimated on a grid of pixels; mirrors radial_blur of the post-process
+fragment shader.
+*/
+float average_adaptive_taps(const glm::vec2& light_position, const glm::vec2& occlusion_map_size, float density,
+                            int num_samples, int min_samples, float texels_per_sample)
+{
+    constexpr int grid_size{32};
+    int taps{0};
+    for (int y = 0; y < grid_size; ++y)
+    {
+        for (int x = 0; x < grid_size; ++x)
+        {
+            const glm::vec2 position{(static_cast<float>(x) + 0.5f) / static_cast<float>(grid_size),
+                                     (static_cast<float>(y) + 0.5f) / static_cast<float>(grid_size)};
+            const float ray_length{glm::length((position - light_position) * density * occlusion_map_size)};
+            taps += std::clamp(static_cast<int>(std::ceil(ray_length / texels_per_sample)),
+                               std::min(min_samples, num_samples), num_samples);
+        }
+    }
+    return static_cast<float>(taps) / static_cast<float>(grid_size * grid_size);
+}
+
+/*
+Step fractions of the passes of the multi-pass blur. A pass moves its k-th
+tap to 1 - k * step_fraction of the distance to the light, so the passes
+compose multiplicatively and the farthest tap of their composite lies at the
+product of the farthest factors of the passes. The steps grow by a factor of
+taps from pass to pass and are scaled by bisection so that this product is
+1 - density, the farthest tap of the single-pass blur; the composite can't
+reach beyond the light, where the factors would turn negative.
+*/
+std::vector<double> multi_pass_step_fractions(int passes, int taps, float density)
+{
+    const double farthest_tap{std::clamp(1.0 - static_cast<double>(density), 0.0, 1.0)};
+    const auto farthest_factor = [passes, taps](double first_step) {
+        double factor{1.0};
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            factor *= 1.0 - (taps - 1) * first_step * std::pow(static_cast<double>(taps), pass);
+        }
+        return factor;
+    };
+    // The factor decreases from 1 to 0, where the last tap of the last pass reaches the light
+    double low{0.0};
+    double high{1.0 / ((taps - 1) * std::pow(static_cast<double>(taps), passes - 1))};
+    for (int iteration = 0; iteration < 64; ++iteration)
+    {
+        const double middle{0.5 * (low + high)};
+        if (farthest_factor(middle) > farthest_tap)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    std::vector<double> step_fractions;
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        step_fractions.push_back(0.5 * (low + high) * std::pow(static_cast<double>(taps), pass));
+    }
+    return step_fractions;
+}
+
+/*
+Selects the largest triangles of the opaque meshes of a model as occluders
+for the software occlusion culling. Large triangles are mostly found on walls,
+pillars and floors, which hide most of the cathedral from any viewpoint.
+*/
+std::vector<glm::vec3> select_occluder_triangles(const gl::Model& model, std::size_t max_triangles)
+{
+    std::vector<std::pair<float, std::array<glm::vec3, 3>>> triangles;
+    for (const auto& mesh_data : model.opaque_render_data())
+    {
+        const std::vector<float> vertices_data{mesh_data.mesh.read_vertices_data()};
+        const auto stride = static_cast<std::size_t>(mesh_data.mesh.stride());
+        for (std::size_t offset = 0; offset + 3 * stride <= vertices_data.size(); offset += 3 * stride)
+        {
+            std::array<glm::vec3, 3> triangle{};
+            for (std::size_t vertex = 0; vertex < 3; ++vertex)
+            {
+                const std::size_t position{offset + vertex * stride};
+                triangle[vertex] =
+                    glm::vec3{vertices_data[position], vertices_data[position + 1], vertices_data[position + 2]};
+            }
+            const float area{glm::length(glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]))};
+            triangles.emplace_back(area, triangle);
+        }
+    }
+
+    const std::size_t number_of_occluders{std::min(max_triangles, triangles.size())};
+    std::partial_sort(triangles.begin(), triangles.begin() + static_cast<std::ptrdiff_t>(number_of_occluders),
+                      triangles.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    std::vector<glm::vec3> occluders;
+    occluders.reserve(3 * number_of_occluders);
+    for (std::size_t i = 0; i < number_of_occluders; ++i)
+    {
+        occluders.insert(occluders.end(), triangles[i].second.cbegin(), triangles[i].second.cend());
+    }
+
+    return occluders;
+}
+
+// Pose of the camera on the benchmark path
+struct CameraKeyframe
+{
+    glm::vec3 position;
+    glm::vec2 pitch_yaw;
+};
+
+// Walk along the nave of the cathedral towards the light shafts of the arched window
+const std::array<CameraKeyframe, 4> benchmark_camera_path{{{glm::vec3{-12.0f, 2.0f, 0.0f}, glm::vec2{5.0f, 90.0f}},
+                                                           {glm::vec3{-5.73f, 1.91f, 2.15f}, glm::vec2{3.0f, 84.5f}},
+                                                           {glm::vec3{2.0f, 3.0f, 0.5f}, glm::vec2{12.0f, 95.0f}},
+                                                           {glm::vec3{9.0f, 4.0f, -1.0f}, glm::vec2{20.0f, 70.0f}}}};
+
+// Places the camera at the normalized position t of the benchmark path, interpolating its keyframes linearly
+void follow_benchmark_camera_path(gl::FPSCamera& camera, float t)
+{
+    const float position{std::clamp(t, 0.0f, 1.0f) * static_cast<float>(benchmark_camera_path.size() - 1)};
+    const std::size_t keyframe{std::min(static_cast<std::size_t>(position), benchmark_camera_path.size() - 2)};
+    const float weight{position - static_cast<float>(keyframe)};
+    const CameraKeyframe& from = benchmark_camera_path[keyframe];
+    const CameraKeyframe& to = benchmark_camera_path[keyframe + 1];
+    camera.set_position(glm::mix(from.position, to.position, weight));
+    camera.set_pitch_yaw(glm::mix(from.pitch_yaw, to.pitch_yaw, weight));
+}
+
+// Index of the component named by a parameter such as "light.direction.y", if the name has the given prefix
+std::optional<glm::length_t> vector_component(std::string_view name, std::string_view prefix)
+{
+    if (name.size() != prefix.size() + 1 || !name.starts_with(prefix) || name.back() < 'x' || name.back() > 'z')
+    {
+        return std::nullopt;
+    }
+    return static_cast<glm::length_t>(name.back() - 'x');
+}
+
+} // namespace
+
+MainApplication::MainApplication(int window_width, int window_height, std::string_view title,
+                                 gl::ContextSettings context_settings) :
+    gl::Application(window_width, window_height, title, context_settings)
 {
     camera().set_position(glm::vec3{-5.73f, 1.91f, 2.15f});
     camera().set_pitch_yaw(glm::vec2{3.0f, 84.5});
 
     // Create shaders
-    texture_blinn_phong_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
-        {"assets/shaders/phong/vertex.glsl", gl::Shader::Type::Vertex},
-        {"assets/shaders/phong/fragment.glsl", gl::Shader::Type::Fragment, {"DIFFUSE_MAP"}}});
-
-    color_blinn_phong_shader_ = std::make_unique<gl::ShaderProgram>(
-        std::initializer_list<gl::ShaderInfo>{{"assets/shaders/phong/vertex.glsl", gl::Shader::Type::Vertex},
-                                              {"assets/shaders/phong/fragment.glsl", gl::Shader::Type::Fragment}});
-
-    color_shader_ = std::make_unique<gl::ShaderProgram>(
-        std::initializer_list<gl::ShaderInfo>{{"assets/shaders/basic/vertex.glsl", gl::Shader::Type::Vertex},
-                                              {"assets/shaders/basic/fragment.glsl", gl::Shader::Type::Fragment}});
-
-    post_process_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
-        {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
-        {"assets/shaders/post_process/fragment.glsl", gl::Shader::Type::Fragment, {"NUM_LIGHTS 1"}}});
-
-    shadow_map_shader_ = std::make_unique<gl::ShaderProgram>(
-        std::initializer_list<gl::ShaderInfo>{{"assets/shaders/shadow_map/vertex.glsl", gl::Shader::Type::Vertex},
-                                              {"assets/shaders/shadow_map/fragment.glsl", gl::Shader::Type::Fragment}});
-    // Create framebuffer objects
-    const std::uint32_t half_width{static_cast<std::uint32_t>(window_width / 2)};
-    const std::uint32_t half_height{static_cast<std::uint32_t>(window_height / 2)};
-    occlusion_fbo_ = std::make_unique<gl::Framebuffer>(half_width, half_height,
-                                                       gl::Renderbuffer{half_width, half_height, GL_DEPTH_COMPONENT32},
-                                                       gl::Texture{half_width, half_height});
-
-    gl::Texture shadow_depth_map{1024, 1024,
-                                 gl::Texture::Attributes{.wrap_s = GL_CLAMP_TO_BORDER,
-                                                         .wrap_t = GL_CLAMP_TO_BORDER,
-                                                         .min_filter = GL_NEAREST,
-                                                         .mag_filter = GL_NEAREST,
-                                                         .internal_format = GL_DEPTH_COMPONENT32F,
-                                                         .pixel_data_format = GL_DEPTH_COMPONENT,
-                                                         .pixel_data_type = GL_FLOAT}};
-    shadow_map_fbo_ = std::make_unique<gl::Framebuffer>(1024, 1024, std::move(shadow_depth_map), std::nullopt);
-    shadow_map_fbo_->set_depth_border({1.0f, 1.0f, 1.0f, 1.0f});
-
-    // clang-format off
-    full_screen_quad_ = std::make_unique<gl::IndexedMesh>(
-        std::vector<float>{
-             1.0f,  1.0f, 0.0f, 1.0f, 1.0f, // Top-Right
-            -1.0f,  1.0f, 0.0,  0.0f, 1.0f, // Top-Left
-            -1.0f, -1.0f, 0.0,  0.0f, 0.0f, // Bottom-Left
-             1.0f, -1.0f, 0.0,  1.0f, 0.0f  // Bottom-Right 
-        },
-        std::vector<std::uint32_t>{0, 1, 3, 3, 1, 2},
-        std::vector<int>{3, 2});
-    // clang-format on
+    {
+        GL_PROFILE_PHASE("Compile shaders");
+        texture_blinn_phong_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/phong/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/phong/fragment.glsl", gl::Shader::Type::Fragment, {"DIFFUSE_MAP"}}});
+
+        color_blinn_phong_shader_ = std::make_unique<gl::ShaderProgram>(
+            std::initializer_list<gl::ShaderInfo>{{"assets/shaders/phong/vertex.glsl", gl::Shader::Type::Vertex},
+                                                  {"assets/shaders/phong/fragment.glsl", gl::Shader::Type::Fragment}});
+
+        gpu_color_blinn_phong_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/phong/vertex.glsl", gl::Shader::Type::Vertex, {"GPU_DRIVEN"}},
+            {"assets/shaders/phong/fragment.glsl", gl::Shader::Type::Fragment, {"GPU_DRIVEN"}}});
+
+        color_shader_ = std::make_unique<gl::ShaderProgram>(
+            std::initializer_list<gl::ShaderInfo>{{"assets/shaders/basic/vertex.glsl", gl::Shader::Type::Vertex},
+                                                  {"assets/shaders/basic/fragment.glsl", gl::Shader::Type::Fragment}});
+
+        const std::string num_lights_define{"NUM_LIGHTS " + std::to_string(number_of_lights)};
+        post_process_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/post_process/fragment.glsl", gl::Shader::Type::Fragment, {num_lights_define}}});
+
+        radial_blur_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/post_process/fragment.glsl",
+             gl::Shader::Type::Fragment,
+             {num_lights_define, "BLUR_TARGET"}}});
+
+        compute_blur_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/compute_blur.glsl", gl::Shader::Type::Compute}});
+
+        multi_pass_blur_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/post_process/multi_pass_blur.glsl", gl::Shader::Type::Fragment}});
+
+        const std::vector<std::string> epipolar_defines{"SAMPLES_PER_LINE " + std::to_string(epipolar_samples),
+                                                        "DECAY_RATES " + std::to_string(epipolar_decay_rates)};
+        epipolar_scan_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/epipolar_scan.glsl", gl::Shader::Type::Compute, epipolar_defines}});
+        epipolar_gather_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/post_process/epipolar_gather.glsl", gl::Shader::Type::Fragment, epipolar_defines}});
+
+        temporal_resolve_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/post_process/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/post_process/temporal_resolve.glsl", gl::Shader::Type::Fragment}});
+
+        shadow_map_shader_ = std::make_unique<gl::ShaderProgram>(std::initializer_list<gl::ShaderInfo>{
+            {"assets/shaders/shadow_map/vertex.glsl", gl::Shader::Type::Vertex},
+            {"assets/shaders/shadow_map/fragment.glsl", gl::Shader::Type::Fragment}});
+    }
+
+    // Create pipeline states; the post-process blend function selects what is displayed by each render mode
+    const auto post_process_pipeline = [this](GLenum source_factor, GLenum destination_factor) {
+        return gl::PipelineState{*post_process_shader_, gl::RasterState{}, gl::DepthState{},
+                                 gl::BlendState{.enabled = true,
+                                                .source_factor = source_factor,
+                                                .destination_factor = destination_factor}};
+    };
+    pipelines_ = std::make_unique<Pipelines>(Pipelines{
+        .color = gl::PipelineState{*color_shader_},
+        .shadow_map = gl::PipelineState{*shadow_map_shader_},
+        .texture_blinn_phong = gl::PipelineState{*texture_blinn_phong_shader_},
+        .gpu_color_blinn_phong = gl::PipelineState{*gpu_color_blinn_phong_shader_},
+        .post_process = {post_process_pipeline(GL_ZERO, GL_ONE), post_process_pipeline(GL_ONE, GL_ZERO),
+                         post_process_pipeline(GL_ONE, GL_ZERO), post_process_pipeline(GL_SRC_ALPHA, GL_ONE)},
+        .radial_blur = gl::PipelineState{*radial_blur_shader_, gl::RasterState{},
+                                         gl::DepthState{.test = false, .write = false}},
+        .multi_pass_blur = gl::PipelineState{*multi_pass_blur_shader_, gl::RasterState{},
+                                             gl::DepthState{.test = false, .write = false}},
+        .epipolar_gather = gl::PipelineState{*epipolar_gather_shader_, gl::RasterState{},
+                                             gl::DepthState{.test = false, .write = false}},
+        .temporal_resolve = gl::PipelineState{*temporal_resolve_shader_, gl::RasterState{},
+                                              gl::DepthState{.test = false, .write = false}}});
+
+    /*
+    Describe the transient render targets, which are allocated by the render
+    graph. Targets sized relative to the window are reallocated when it's
+    resized or when their scale changes.
+    */
+    occlusion_map_description_ = gl::TextureDescription{.scale = occlusion_scale_};
+    set_blur_sampling(blur_sampling_);
+    for (std::size_t i = 0; i < number_of_lights; ++i)
+    {
+        set_light_color(i, glm::vec3{1.0f});
+    }
+    // Targets of the blur, sized by set_blur_resolution; half floats avoid banding between the passes
+    blur_description_ = gl::TextureDescription{.attributes = gl::Texture::Attributes{.wrap_s = GL_CLAMP_TO_EDGE,
+                                                                                     .wrap_t = GL_CLAMP_TO_EDGE,
+                                                                                     .internal_format = GL_RGBA16F,
+                                                                                     .pixel_data_type = GL_FLOAT}};
+    set_blur_resolution(blur_resolution_);
+    for (std::uint32_t i = 0; i < temporal_blur_.jitter_sequence.size(); ++i)
+    {
+        temporal_blur_.jitter_sequence[i] = van_der_corput(i);
+    }
+    // The depth of the occlusion pre-pass is sampled to build the Hi-Z pyramid and to upsample the blur
+    occlusion_depth_description_ =
+        gl::TextureDescription{.attributes = gl::Texture::Attributes{.wrap_s = GL_CLAMP_TO_EDGE,
+                                                                     .wrap_t = GL_CLAMP_TO_EDGE,
+                                                                     .min_filter = GL_NEAREST,
+                                                                     .mag_filter = GL_NEAREST,
+                                                                     .pixel_data_format = GL_DEPTH_COMPONENT},
+                               .scale = occlusion_scale_};
+    set_compact_occlusion_depth(compact_occlusion_depth_);
+    // Allocated on the first build at the size of the occlusion depth it's built from
+    hi_z_pyramid_ = std::make_unique<gl::HiZPyramid>();
+    gpu_profiler_ = std::make_unique<gl::GpuProfiler>();
+    render_graph_.set_default_framebuffer(default_framebuffer());
+
+    shadow_map_description_ =
+        gl::TextureDescription{.width = static_cast<std::uint32_t>(shadow_map_parameters_.size),
+                               .height = static_cast<std::uint32_t>(shadow_map_parameters_.size),
+                               .attributes = gl::Texture::Attributes{.wrap_s = GL_CLAMP_TO_BORDER,
+                                                                     .wrap_t = GL_CLAMP_TO_BORDER,
+                                                                     .min_filter = GL_NEAREST,
+                                                                     .mag_filter = GL_NEAREST,
+                                                                     .internal_format = GL_DEPTH_COMPONENT32F,
+                                                                     .pixel_data_format = GL_DEPTH_COMPONENT,
+                                                                     .pixel_data_type = GL_FLOAT},
+                               .border_color = {1.0f, 1.0f, 1.0f, 1.0f}};
+
+    {
+        const gl::GpuMemoryTracker::OwnerScope owner{"Full-screen quad"};
+        // clang-format off
+        full_screen_quad_ = std::make_unique<gl::IndexedMesh>(
+            std::vector<float>{
+                 1.0f,  1.0f, 0.0f, 1.0f, 1.0f, // Top-Right
+                -1.0f,  1.0f, 0.0,  0.0f, 1.0f, // Top-Left
+                -1.0f, -1.0f, 0.0,  0.0f, 0.0f, // Bottom-Left
+                 1.0f, -1.0f, 0.0,  1.0f, 0.0f  // Bottom-Right 
+            },
+            std::vector<std::uint32_t>{0, 1, 3, 3, 1, 2},
+            std::vector<int>{3, 2});
+        // clang-format on
+    }
 
     // Read and initialize models
-    models_ = gl::read_triangle_mesh("uv_sphere.obj");
-    models_.merge(gl::read_triangle_mesh("arclight.obj"));
-    models_.merge(gl::read_triangle_mesh("sibenik.obj"));
-    models_.at("sibenik").sort_by_texture();
+    {
+        GL_PROFILE_PHASE("Load models");
+        models_ = gl::read_triangle_mesh("uv_sphere.obj");
+        models_.merge(gl::read_triangle_mesh("arclight.obj"));
+        models_.merge(gl::read_triangle_mesh("sibenik.obj"));
+        models_.at("sibenik").sort_by_texture();
+    }
+    {
+        GL_PROFILE_PHASE("Create GPU-driven buffers");
+        const gl::GpuMemoryTracker::OwnerScope owner{"GPU-driven culling"};
+        gpu_driven_sibenik_ = std::make_unique<gl::GpuDrivenModel>(models_.at("sibenik"));
+    }
+    {
+        GL_PROFILE_PHASE("Select occluders");
+        // The software depth buffer only needs a coarse resolution; it's resized along with the window
+        software_occlusion_culler_ = std::make_unique<gl::SoftwareOcclusionCuller>(
+            std::max(static_cast<std::uint32_t>(window_width / 4), 1u),
+            std::max(static_cast<std::uint32_t>(window_height / 4), 1u));
+        software_occlusion_culler_->set_occluders(select_occluder_triangles(models_.at("sibenik"), 8192));
+    }
     light_.direction = glm::vec3{17.143f, 6.857f, 4.225f};
     models_.at("UVSphere").translation = light_.direction;
     models_.at("arclight").scale = glm::vec3{1.6f, 2.0f, 1.5f};
     models_.at("arclight").translation = glm::vec3{18.5f, 10.0f, 6.0f};
 
     // Set light uniforms
-    texture_blinn_phong_shader_->set_vec3_uniform("light.direction", light_.direction);
-    texture_blinn_phong_shader_->set_vec3_uniform("light.ambient", light_.ambient);
-    texture_blinn_phong_shader_->set_vec3_uniform("light.diffuse", light_.diffuse);
-    texture_blinn_phong_shader_->set_vec3_uniform("light.specular", light_.specular);
-    texture_blinn_phong_shader_->set_float_uniform("bias", shadow_map_parameters_.bias);
-    color_blinn_phong_shader_->set_vec3_uniform("light.direction", light_.direction);
-    color_blinn_phong_shader_->set_vec3_uniform("light.ambient", light_.ambient);
-    color_blinn_phong_shader_->set_vec3_uniform("light.diffuse", light_.diffuse);
-    color_blinn_phong_shader_->set_vec3_uniform("light.specular", light_.specular);
-    color_blinn_phong_shader_->set_float_uniform("bias", shadow_map_parameters_.bias);
+    for (auto* shader : blinn_phong_shaders())
+    {
+        shader->set_vec3_uniform("light.direction", light_.direction);
+        shader->set_vec3_uniform("light.ambient", light_.ambient);
+        shader->set_vec3_uniform("light.diffuse", light_.diffuse);
+        shader->set_vec3_uniform("light.specular", light_.specular);
+        shader->set_float_uniform("bias", shadow_map_parameters_.bias);
+    }
 
     post_process_shader_->set_bool_uniform("apply_radial_blur", apply_radial_blur_);
-    post_process_shader_->set_int_uniform("coefficients.num_samples", coefficients.num_samples);
-    post_process_shader_->set_float_uniform("coefficients.density", coefficients.density);
+    for (auto* shader : single_pass_blur_shaders())
+    {
+        shader->set_int_uniform("cone_taps", cone_taps_);
+        shader->set_bool_uniform("adaptive_sampling", adaptive_sampling_.enabled);
+        shader->set_int_uniform("min_samples", adaptive_sampling_.min_samples);
+        shader->set_float_uniform("texels_per_sample", adaptive_sampling_.texels_per_sample);
+        shader->set_bool_uniform("jitter_samples", adaptive_sampling_.jitter);
+    }
+    // The exposure is applied by the composite only
     post_process_shader_->set_float_uniform("coefficients.exposure", coefficients.exposure);
-    post_process_shader_->set_float_uniform("coefficients.decay", coefficients.decay);
-    post_process_shader_->set_float_uniform("coefficients.weight", coefficients.weight);
+    for (auto* shader : radial_blur_shaders())
+    {
+        shader->set_int_uniform("coefficients.num_samples", coefficients.num_samples);
+        shader->set_float_uniform("coefficients.density", coefficients.density);
+        shader->set_float_uniform("coefficients.decay", coefficients.decay);
+        shader->set_float_uniform("coefficients.weight", coefficients.weight);
+    }
 
     shadow_map_parameters_.set_projection();
 }
@@ -113,6 +464,62 @@ void MainApplication::render()
     auto& arclight = models_.at("arclight");
     auto& uv_sphere = models_.at("UVSphere");
 
+    if (software_occlusion_culling_)
+    {
+        apply_software_occlusion_culling(sibenik, view_projection * sibenik.transform());
+    }
+    else
+    {
+        sibenik.reset_visibility();
+    }
+
+    const glm::mat4 light_view{
+        glm::lookAt(uv_sphere.translation, shadow_map_parameters_.target, glm::vec3{0.0f, 1.0f, 0.0f})};
+    const glm::mat4 light_space_transform{shadow_map_parameters_.light_projection * light_view};
+
+    // The draws of the cathedral on every pass are sorted once per frame to minimize state changes
+    {
+        GL_PROFILE_SCOPE("frame", "Build render queue");
+        render_queue_.clear();
+        if (!gpu_driven_culling_)
+        {
+            sibenik.enqueue_opaque_meshes(render_queue_, gl::to_underlying(RenderPass::Occlusion), view_projection,
+                                          *color_shader_);
+            sibenik.enqueue_opaque_meshes(render_queue_, gl::to_underlying(RenderPass::Shadow), light_space_transform,
+                                          *shadow_map_shader_, false);
+            sibenik.enqueue_opaque_meshes(render_queue_, gl::to_underlying(RenderPass::Scene), view_projection,
+                                          *texture_blinn_phong_shader_, *color_blinn_phong_shader_, "diffuse_color");
+        }
+        sibenik.enqueue_semitransparent_meshes(render_queue_, gl::to_underlying(RenderPass::Transparent),
+                                               view_projection, *color_shader_, "color");
+        render_queue_.sort();
+    }
+
+    /*
+    The frame is described as a render graph: passes declare the targets they
+    read and write, so that passes whose results aren't displayed by the
+    current render mode are culled and the transient targets are allocated
+    by the graph.
+    */
+    render_graph_.set_swapchain_size(static_cast<std::uint32_t>(width_), static_cast<std::uint32_t>(height_));
+    render_graph_.reset();
+    const auto occlusion_map = render_graph_.create_texture("Occlusion map", occlusion_map_description_);
+    const auto occlusion_depth = render_graph_.create_texture("Occlusion depth", occlusion_depth_description_);
+    const auto shadow_map = render_graph_.create_texture("Shadow map", shadow_map_description_);
+    const auto backbuffer = render_graph_.import_external("Backbuffer");
+    // Visibility of the GPU-driven draws, computed by the occlusion pre-pass and reused by the scene pass
+    const auto gpu_visibility = render_graph_.import_external("GPU-driven visibility");
+    render_graph_.mark_output(backbuffer);
+
+    const bool scene_displayed{render_mode_ == RenderMode::DefaultSceneOnly ||
+                               render_mode_ == RenderMode::CompleteRender};
+    std::vector<gl::Model*> light_models{&arclight};
+    // The colors and the shaders of the lights are sized for the lights of the scene
+    assert(light_models.size() == number_of_lights);
+    // Occlusion queries are issued by the scene pass, so lights are only tested for occlusion in the complete render
+    light_visibility_.update(light_models, view_projection, render_mode_ == RenderMode::CompleteRender);
+    const glm::mat4 sibenik_mvp{view_projection * sibenik.transform()};
+
     /*
     Occlusion Pre-Pass Method:
     Render the scene geometry as black and light source with the
@@ -120,215 +527,1745 @@ void MainApplication::render()
     stores the occlusion map, which will be used in the
     post-processing phase to gneerate the god rays.
     */
-    occlusion_fbo_->bind();
-    color_shader_->use();
-    color_shader_->set_vec4_uniform("color", glm::vec4{0.0f, 0.0f, 0.0f, 1.0f});
-    color_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
-    sibenik.render_opaque_meshes();
-    color_shader_->set_vec4_uniform("color", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
-    std::vector<gl::Model*> light_models{&arclight};
-    for (auto& light : light_models)
-    {
-        color_shader_->set_mat4_uniform("mvp", view_projection * light->transform());
-        light->render();
-    }
-    occlusion_fbo_->unbind();
-    reset_viewport();
-
-    // Clear window with specified color
-    glClearColor(0.05f, 0.0f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    render_graph_.add_pass(
+        "Occlusion",
+        [&](gl::RenderGraph::PassBuilder& builder) {
+            builder.write(occlusion_map);
+            builder.write(occlusion_depth);
+            if (gpu_driven_culling_)
+            {
+                builder.write(gpu_visibility);
+            }
+        },
+        [&](const gl::RenderGraph::Resources& resources) {
+            // The Hi-Z pyramid of the GPU-driven culling needs the depth of the whole screen
+            if (!gpu_driven_culling_)
+            {
+                gl::state_cache().set_scissor(blur_scissor(texture_viewport(resources.texture(occlusion_map))));
+            }
+            color_shader_->set_vec4_uniform("color", glm::vec4{0.0f, 0.0f, 0.0f, 1.0f});
+            color_shader_->set_mat4_uniform("mvp", sibenik_mvp);
+            if (gpu_driven_culling_)
+            {
+                /*
+                Two-phase occlusion culling: draw the meshes visible on the previous frame,
+                build the Hi-Z pyramid from the resulting depth and then draw the meshes
+                disoccluded on this frame, which fail the test of the early phase.
+                */
+                gpu_driven_sibenik_->cull_early(sibenik_mvp);
+                pipelines_->color.bind();
+                gpu_driven_sibenik_->render(gl::DrawSet::Early);
+                hi_z_pyramid_->build(resources.texture(occlusion_depth));
+                gpu_driven_sibenik_->cull_late(sibenik_mvp, *hi_z_pyramid_);
+                pipelines_->color.bind();
+                gpu_driven_sibenik_->render(gl::DrawSet::Late);
+            }
+            else
+            {
+                render_queue_.submit(gl::to_underlying(RenderPass::Occlusion));
+            }
+            pipelines_->color.bind();
+            // A mask only records where the lights are; the composite applies their color
+            for (std::size_t i = 0; i < light_models.size(); ++i)
+            {
+                color_shader_->set_vec4_uniform("color", occlusion_format_ == OcclusionFormat::Mask
+                                                             ? glm::vec4{1.0f}
+                                                             : glm::vec4{light_colors_[i], 1.0f});
+                color_shader_->set_mat4_uniform("mvp", view_projection * light_models[i]->transform());
+                light_models[i]->render();
+            }
+            // The mip chain sampled by the cone-traced blur, if the occlusion map has one
+            resources.texture(occlusion_map).generate_mipmap();
+        });
 
     // Second Render Pass: render scene as usual
     // Shadow map render pass
-    const glm::mat4 light_view{
-        glm::lookAt(uv_sphere.translation, shadow_map_parameters_.target, glm::vec3{0.0f, 1.0f, 0.0f})};
-    const glm::mat4 light_space_transform{shadow_map_parameters_.light_projection * light_view};
-    shadow_map_fbo_->bind();
-    shadow_map_shader_->use();
-    shadow_map_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
-    shadow_map_shader_->set_mat4_uniform("model", sibenik.transform());
-    sibenik.render_opaque_meshes();
-    shadow_map_fbo_->unbind();
-    reset_viewport();
-
-    // First render opaque objects
-    texture_blinn_phong_shader_->use();
-    // TODO: refactor "view_pos", "mvp", "model" and "light_space_transform" as UBOs to avoid sending the same data to
-    // the GPU
-    texture_blinn_phong_shader_->set_vec3_uniform("view_pos", camera().position());
-    texture_blinn_phong_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
-    texture_blinn_phong_shader_->set_mat4_uniform("model", sibenik.transform());
-    texture_blinn_phong_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
-    shadow_map_fbo_->bind_depth_texture(1);
-    sibenik.render_textured_meshes();
-    color_blinn_phong_shader_->use();
-    color_blinn_phong_shader_->set_vec3_uniform("view_pos", camera().position());
-    color_blinn_phong_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
-    color_blinn_phong_shader_->set_mat4_uniform("model", sibenik.transform());
-    color_blinn_phong_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
-    sibenik.render_colored_meshes(*color_blinn_phong_shader_, "diffuse_color");
-    color_shader_->use();
-    color_shader_->set_vec4_uniform("color", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
-    for (auto& light : light_models)
-    {
-        color_shader_->set_mat4_uniform("mvp", view_projection * light->transform());
-        light->render();
-    }
-    // Render (semi)transparent objects after opaque objects
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    color_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
-    sibenik.render_semitransparent_meshes(*color_shader_, "color");
+    render_graph_.add_pass(
+        "Shadow map", [&](gl::RenderGraph::PassBuilder& builder) { builder.write(shadow_map); },
+        [&](const gl::RenderGraph::Resources& /*resources*/) {
+            shadow_map_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
+            shadow_map_shader_->set_mat4_uniform("model", sibenik.transform());
+            if (gpu_driven_culling_)
+            {
+                gpu_driven_sibenik_->cull_frustum(light_space_transform * sibenik.transform());
+                pipelines_->shadow_map.bind();
+                gpu_driven_sibenik_->render(gl::DrawSet::Frustum);
+            }
+            else
+            {
+                render_queue_.submit(gl::to_underlying(RenderPass::Shadow));
+            }
+        });
+
+    render_graph_.add_pass(
+        "Scene",
+        [&](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(shadow_map);
+            if (gpu_driven_culling_)
+            {
+                builder.read(gpu_visibility);
+            }
+            builder.write(backbuffer);
+        },
+        [&](const gl::RenderGraph::Resources& resources) {
+            reset_viewport();
+            // Clear window with specified color
+            glClearColor(0.05f, 0.0f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // First render opaque objects
+            pipelines_->texture_blinn_phong.bind();
+            // TODO: refactor "view_pos", "mvp", "model" and "light_space_transform" as UBOs to avoid sending the same
+            // data to the GPU
+            texture_blinn_phong_shader_->set_vec3_uniform("view_pos", camera().position());
+            texture_blinn_phong_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
+            texture_blinn_phong_shader_->set_mat4_uniform("model", sibenik.transform());
+            texture_blinn_phong_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
+            resources.texture(shadow_map).bind(1);
+            if (gpu_driven_culling_)
+            {
+                // Reuse the visibility computed during the occlusion pre-pass, which has the same view
+                gpu_driven_sibenik_->render_textured(gl::DrawSet::Visible);
+                pipelines_->gpu_color_blinn_phong.bind();
+                gpu_color_blinn_phong_shader_->set_vec3_uniform("view_pos", camera().position());
+                gpu_color_blinn_phong_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
+                gpu_color_blinn_phong_shader_->set_mat4_uniform("model", sibenik.transform());
+                gpu_color_blinn_phong_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
+                gpu_driven_sibenik_->render_colored(gl::DrawSet::Visible);
+            }
+            else
+            {
+                color_blinn_phong_shader_->set_vec3_uniform("view_pos", camera().position());
+                color_blinn_phong_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
+                color_blinn_phong_shader_->set_mat4_uniform("model", sibenik.transform());
+                color_blinn_phong_shader_->set_mat4_uniform("light_space_transform", light_space_transform);
+                render_queue_.submit(gl::to_underlying(RenderPass::Scene));
+            }
+            pipelines_->color.bind();
+            color_shader_->set_vec4_uniform("color", glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
+            // The models of the lights are their proxies, tested against the depth of the scene
+            for (std::size_t i = 0; i < light_models.size(); ++i)
+            {
+                color_shader_->set_mat4_uniform("mvp", view_projection * light_models[i]->transform());
+                light_visibility_.begin_query(i);
+                light_models[i]->render();
+                light_visibility_.end_query();
+            }
+        });
+
+    // Render (semi)transparent objects after opaque objects; the queue enables blending
+    render_graph_.add_pass(
+        "Transparent", [&](gl::RenderGraph::PassBuilder& builder) { builder.write(backbuffer, false); },
+        [&](const gl::RenderGraph::Resources& /*resources*/) {
+            color_shader_->set_mat4_uniform("mvp", view_projection * sibenik.transform());
+            render_queue_.submit(gl::to_underlying(RenderPass::Transparent));
+        });
 
     /*
     Post-Processing God Rays Render Pass:
     without clearing the default framebuffer, bind the occlusion map
     and apply a radial blur to it. Finally, a blending function is
     applied between the default render (renderer on the second pass)
-    and the radial blur.
+    and the radial blur. The default scene is displayed as is, without
+    the post-processing pass.
     */
-
     switch (render_mode_)
     {
-    case RenderMode::DefaultSceneOnly:
-        glBlendFunc(GL_ZERO, GL_ONE);
-        break;
     case RenderMode::OcclusionMapOnly:
-        glBlendFunc(GL_ONE, GL_ZERO);
         apply_radial_blur_ = false;
         break;
     case RenderMode::RadialBlurOnly:
-        glBlendFunc(GL_ONE, GL_ZERO);
+    case RenderMode::CompleteRender:
         apply_radial_blur_ = true;
         break;
-    case RenderMode::CompleteRender:
     default:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        apply_radial_blur_ = true;
         break;
     }
 
-    post_process_shader_->use();
-    post_process_shader_->set_bool_uniform("apply_radial_blur", apply_radial_blur_);
-    occlusion_fbo_->bind_color(0);
-
-    // Each light source is initially centered at origin; the model matrix is responsible
-    // for updating it's position in the world space.
+    /*
+    Lights are given to the blur by their position on the screen, in texture
+    coordinates, and the intensity of their rays in the w component, which is
+    0 for the lights hidden according to the visibility tests. The blurs of a
+    single light follow the first visible light.
+    */
     std::vector<glm::vec4> light_positions;
-    for (auto& light : light_models)
+    std::optional<std::size_t> primary_light;
+    std::size_t visible_lights{0};
+    for (std::size_t i = 0; i < light_models.size(); ++i)
+    {
+        const gl::LightVisibility::Light& light = light_visibility_.lights()[i];
+        const bool visible{light_visibility_.is_visible(i)};
+        light_positions.emplace_back(light.screen_position, 0.0f, visible ? light.intensity : 0.0f);
+        if (visible)
+        {
+            primary_light = primary_light.value_or(i);
+            ++visible_lights;
+        }
+    }
+    const glm::vec4 primary_light_position{light_positions[primary_light.value_or(0)]};
+    // The query of the only visible light skips the blur on the GPU if the light was occluded on this very frame
+    blur_condition_light_ = visible_lights == 1 ? primary_light : std::nullopt;
+    // Without any visible light, the complete render skips the god rays altogether
+    const bool god_rays_rendered{render_mode_ != RenderMode::CompleteRender || visible_lights > 0};
+
+    // The occlusion and blur passes only render the region when the blur is displayed
+    const bool blur_displayed{
+        apply_radial_blur_ && god_rays_rendered &&
+        (render_mode_ == RenderMode::RadialBlurOnly || render_mode_ == RenderMode::CompleteRender)};
+    blur_region_ = scissor_blur_region_ && blur_displayed
+                       ? compute_blur_region(light_models, light_positions, view_projection)
+                       : std::nullopt;
+
+    /*
+    The blur is rendered into its own target unless the single-pass blur runs
+    at full resolution. The multi-pass, compute and epipolar blurs converge
+    towards a single point, so they blur towards the first visible light,
+    whose intensity scales the gain of their blurred map. The blurred map of
+    the multi-pass blur lacks the brightness of the occlusion map, which the
+    composite adds back.
+    */
+    const bool use_blur_target{render_mode_ != RenderMode::DefaultSceneOnly && apply_radial_blur_ &&
+                               god_rays_rendered &&
+                               (blur_method_ != BlurMethod::SinglePass || blur_resolution_ != BlurResolution::Full)};
+    float blurred_map_gain{1.0f};
+    float occlusion_map_weight{0.0f};
+    std::optional<gl::RenderGraph::ResourceHandle> blurred_map;
+    if (use_blur_target)
+    {
+        switch (blur_method_)
+        {
+        case BlurMethod::MultiPass:
+            blurred_map = add_multi_pass_blur(occlusion_map, glm::vec2{primary_light_position}, blurred_map_gain);
+            blurred_map_gain *= primary_light_position.w;
+            occlusion_map_weight = 1.0f;
+            break;
+        case BlurMethod::Compute:
+            blurred_map = add_compute_blur(occlusion_map, glm::vec2{primary_light_position});
+            blurred_map_gain = primary_light_position.w;
+            break;
+        case BlurMethod::Epipolar:
+            blurred_map = add_epipolar_blur(occlusion_map, glm::vec2{primary_light_position});
+            blurred_map_gain = primary_light_position.w;
+            break;
+        case BlurMethod::Temporal:
+            blurred_map = add_temporal_blur(
+                occlusion_map, occlusion_depth, light_positions, view_projection, primary_light_position,
+                glm::vec3{light_models[primary_light.value_or(0)]->transform() * glm::vec4{0.0f, 0.0f, 0.0f, 1.0f}});
+            break;
+        default:
+            blurred_map = add_radial_blur(occlusion_map, light_positions, coefficients.num_samples, 0.0f);
+            break;
+        }
+    }
+    // The history is stale once the temporal blur skipped a frame
+    if (!use_blur_target || blur_method_ != BlurMethod::Temporal)
+    {
+        temporal_blur_.history_valid = false;
+    }
+    const bool depth_aware_upsample{blurred_map && depth_aware_upsample_ &&
+                                    blur_resolution_ != BlurResolution::Full};
+
+    if (render_mode_ != RenderMode::DefaultSceneOnly && god_rays_rendered)
+    {
+        render_graph_.add_pass(
+            "Post-process",
+            [&](gl::RenderGraph::PassBuilder& builder) {
+                builder.read(occlusion_map);
+                if (blurred_map)
+                {
+                    builder.read(blurred_map.value());
+                }
+                if (depth_aware_upsample)
+                {
+                    builder.read(occlusion_depth);
+                }
+                // Render modes displaying only the post-process overwrite the default framebuffer
+                builder.write(backbuffer, !scene_displayed);
+            },
+            [&](const gl::RenderGraph::Resources& resources) {
+                reset_viewport();
+                if (!scene_displayed)
+                {
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
+                // Outside of the blur region, the composite would only add black to the scene
+                if (render_mode_ == RenderMode::CompleteRender)
+                {
+                    gl::state_cache().set_scissor(blur_scissor(current_viewport_));
+                }
+                pipelines_->post_process[gl::to_underlying(render_mode_)].bind();
+                post_process_shader_->set_bool_uniform("apply_radial_blur", apply_radial_blur_);
+                post_process_shader_->set_bool_uniform("use_blurred_map", blurred_map.has_value());
+                resources.texture(occlusion_map).bind(0);
+                if (blurred_map)
+                {
+                    resources.texture(blurred_map.value()).bind(1);
+                    post_process_shader_->set_float_uniform("blurred_map_gain", blurred_map_gain);
+                    post_process_shader_->set_float_uniform("occlusion_map_weight", occlusion_map_weight);
+                }
+                post_process_shader_->set_bool_uniform("depth_aware_upsample", depth_aware_upsample);
+                if (depth_aware_upsample)
+                {
+                    resources.texture(occlusion_depth).bind(2);
+                    const glm::mat4& projection{camera().projection()};
+                    post_process_shader_->set_vec2_uniform("depth_linearization",
+                                                           glm::vec2{projection[3][2], projection[2][2]});
+                }
+                post_process_shader_->set_vec4_array_uniform("screen_space_light_positions[0]", light_positions);
+                const gl::LightVisibility::ConditionalRender condition{blur_condition()};
+                full_screen_quad_->render();
+            });
+    }
+
+    // Render GUI; the shadow map is displayed only when the scene, which depends on it, is rendered
+    if (!is_headless())
     {
-        const glm::vec4 clip_light_position{view_projection * light->transform() * glm::vec4{0.0f, 0.0f, 0.0f, 1.0f}};
-        const glm::vec4 ndc_light_position{clip_light_position / clip_light_position.w};
-        const glm::vec4 screen_space_light_position{(ndc_light_position + 1.0f) * 0.5f};
-        light_positions.emplace_back(screen_space_light_position);
+        render_graph_.add_pass(
+            "GUI",
+            [&](gl::RenderGraph::PassBuilder& builder) {
+                if (scene_displayed)
+                {
+                    builder.read(shadow_map);
+                }
+                builder.write(backbuffer, false);
+            },
+            [&](const gl::RenderGraph::Resources& resources) {
+                displayed_shadow_map_id_ = scene_displayed ? resources.texture(shadow_map).id() : 0;
+                render_imgui_editor();
+            });
     }
-    post_process_shader_->set_vec4_array_uniform("screen_space_light_positions[0]", light_positions);
-    full_screen_quad_->render();
-    glDisable(GL_BLEND);
 
-    // Render GUI
-    render_imgui_editor();
+    render_graph_.compile();
+    gpu_profiler_->begin_frame();
+    render_graph_.execute(gpu_profiler_.get());
+    gpu_profiler_->end_frame();
 }
 
-void MainApplication::ShadowMapParameters::set_projection()
+void MainApplication::set_blur_resolution(BlurResolution blur_resolution)
 {
-    light_projection =
-        glm::ortho(-frustum_dimension, frustum_dimension, -frustum_dimension, frustum_dimension, near_plane, far_plane);
+    blur_resolution_ = blur_resolution;
+    blur_description_.scale = 1.0f / static_cast<float>(gl::to_underlying(blur_resolution_));
 }
 
-void MainApplication::render_imgui_editor()
+float MainApplication::average_blur_taps() const
 {
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    const glm::vec2 occlusion_map_size{glm::vec2{static_cast<float>(width_), static_cast<float>(height_)} *
+                                       occlusion_scale_};
+    float taps{0.0f};
+    for (std::size_t i = 0; i < light_visibility_.lights().size(); ++i)
+    {
+        if (light_visibility_.is_visible(i))
+        {
+            taps += average_adaptive_taps(light_visibility_.lights()[i].screen_position, occlusion_map_size,
+                                          coefficients.density, coefficients.num_samples,
+                                          adaptive_sampling_.min_samples, adaptive_sampling_.texels_per_sample);
+        }
+    }
+    return taps;
+}
 
-    ImGui::Begin("Settings");
-    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
-                ImGui::GetIO().Framerate);
+void MainApplication::set_light_color(std::size_t light, const glm::vec3& color)
+{
+    light_colors_.at(light) = color;
+    // A single light, or lights sharing a color, only need a mask
+    const bool single_color{std::all_of(light_colors_.cbegin(), light_colors_.cend(),
+                                        [this](const glm::vec3& other) { return other == light_colors_.front(); })};
+    occlusion_format_ = single_color ? OcclusionFormat::Mask : OcclusionFormat::Color;
 
-    int render_mode_value{static_cast<int>(render_mode_)};
-    if (ImGui::TreeNode("Render Mode"))
+    gl::Texture::Attributes& attributes = occlusion_map_description_.attributes;
+    if (occlusion_format_ == OcclusionFormat::Mask)
     {
-        ImGui::RadioButton("Default Scene Only", &render_mode_value, static_cast<int>(RenderMode::DefaultSceneOnly));
-        ImGui::RadioButton("Occlusion Map Only", &render_mode_value, static_cast<int>(RenderMode::OcclusionMapOnly));
-        ImGui::RadioButton("Radial Blur Only", &render_mode_value, static_cast<int>(RenderMode::RadialBlurOnly));
-        ImGui::RadioButton("Complete Scene", &render_mode_value, static_cast<int>(RenderMode::CompleteRender));
-        render_mode_ = static_cast<RenderMode>(render_mode_value);
-        ImGui::TreePop();
+        attributes.internal_format = GL_R8;
+        attributes.pixel_data_format = GL_RED;
+        attributes.swizzle = std::array<GLint, 4>{GL_RED, GL_RED, GL_RED, GL_ONE};
+    }
+    else
+    {
+        attributes.internal_format = GL_R11F_G11F_B10F;
+        attributes.pixel_data_format = GL_RGB;
+        attributes.swizzle.reset();
     }
+    post_process_shader_->set_vec3_uniform(
+        "light_color", occlusion_format_ == OcclusionFormat::Mask ? light_colors_.front() : glm::vec3{1.0f});
+}
 
-    // See Mitchell "Volumetric Light Scattering as a Post-Process" for a detailed explanation
-    // of each post-processing parameter.
-    if (ImGui::TreeNode("Post-processing Coefficients"))
+void MainApplication::set_compact_occlusion_depth(bool compact)
+{
+    compact_occlusion_depth_ = compact;
+    occlusion_depth_description_.attributes.internal_format =
+        compact ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT32F;
+    occlusion_depth_description_.attributes.pixel_data_type = compact ? GL_UNSIGNED_SHORT : GL_FLOAT;
+}
+
+void MainApplication::set_blur_sampling(BlurSampling blur_sampling)
+{
+    blur_sampling_ = blur_sampling;
+    const bool cone_sampling{blur_sampling_ == BlurSampling::Cone};
+    occlusion_map_description_.attributes.generate_mipmap = cone_sampling;
+    occlusion_map_description_.attributes.min_filter = cone_sampling ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    for (auto* shader : single_pass_blur_shaders())
     {
-        if (ImGui::InputInt("Number of samples", &coefficients.num_samples))
-        {
-            coefficients.num_samples = std::clamp(coefficients.num_samples, 0, 512);
-            post_process_shader_->set_int_uniform("coefficients.num_samples", coefficients.num_samples);
-        }
+        shader->set_bool_uniform("cone_sampling", cone_sampling);
+    }
+}
 
-        if (ImGui::SliderFloat("Density", &coefficients.density, 0.0f, 2.0f))
-        {
-            post_process_shader_->set_float_uniform("coefficients.density", coefficients.density);
-        }
+std::optional<MainApplication::ScreenRectangle> MainApplication::compute_blur_region(
+    const std::vector<gl::Model*>& light_models, const std::vector<glm::vec4>& light_positions,
+    const glm::mat4& view_projection) const
+{
+    // Taps overshooting the light by more than their distance to it, or growing weights, may reach any pixel
+    if (coefficients.density > 2.0f || coefficients.decay > 1.0f)
+    {
+        return std::nullopt;
+    }
 
-        if (ImGui::SliderFloat("Exposure", &coefficients.exposure, 0.0f, 10.0f))
+    const glm::vec2 screen_size{static_cast<float>(width_), static_cast<float>(height_)};
+    const float max_distance{glm::length(screen_size)};
+    ScreenRectangle region{.min = glm::vec2{1.0f}, .max = glm::vec2{0.0f}};
+    for (std::size_t i = 0; i < light_models.size(); ++i)
+    {
+        // The source is bounded by a disk around the light enclosing the projection of its bounding box
+        const gl::AABB bounds{light_models[i]->bounds()};
+        const glm::mat4 mvp{view_projection * light_models[i]->transform()};
+        // Hidden lights have no rays
+        if (light_positions[i].w <= 0.0f)
         {
-            post_process_shader_->set_float_uniform("coefficients.exposure", coefficients.exposure);
+            continue;
         }
-
-        if (ImGui::SliderFloat("Decay", &coefficients.decay, 0.0f, 1.0f))
+        const glm::vec2 light_position{glm::vec2{light_positions[i]} * screen_size};
+        float radius{0.0f};
+        for (int corner = 0; corner < 8; ++corner)
         {
-            post_process_shader_->set_float_uniform("coefficients.decay", coefficients.decay);
+            const glm::vec4 clip_position{mvp * glm::vec4{(corner & 1) ? bounds.max_corner.x : bounds.min_corner.x,
+                                                          (corner & 2) ? bounds.max_corner.y : bounds.min_corner.y,
+                                                          (corner & 4) ? bounds.max_corner.z : bounds.min_corner.z,
+                                                          1.0f}};
+            // A source crossing the plane of the camera has no bounded projection
+            if (clip_position.w <= 0.0f)
+            {
+                return std::nullopt;
+            }
+            const glm::vec2 position{(glm::vec2{clip_position} / clip_position.w + 1.0f) * 0.5f * screen_size};
+            radius = std::max(radius, glm::distance(position, light_position));
         }
 
-        if (ImGui::SliderFloat("Weight", &coefficients.weight, 0.0f, 0.1f))
+        // The bound decreases with the distance, so the distance where it crosses the threshold is bisected
+        const float tap_weight{coefficients.weight * coefficients.exposure * light_positions[i].w};
+        const auto contribution = [this, radius, tap_weight](float distance) {
+            return blur_contribution_bound(distance, radius, coefficients.num_samples, coefficients.density,
+                                           coefficients.decay, tap_weight);
+        };
+        float reach{max_distance};
+        if (contribution(max_distance) < blur_region_threshold)
         {
-            post_process_shader_->set_float_uniform("coefficients.weight", coefficients.weight);
+            float lit_distance{radius};
+            for (int iteration = 0; iteration < 24; ++iteration)
+            {
+                const float distance{0.5f * (lit_distance + reach)};
+                (contribution(distance) < blur_region_threshold ? reach : lit_distance) = distance;
+            }
         }
+        region.min = glm::min(region.min, (light_position - reach) / screen_size);
+        region.max = glm::max(region.max, (light_position + reach) / screen_size);
+    }
 
-        ImGui::TreePop();
+    region.min = glm::clamp(region.min, 0.0f, 1.0f);
+    region.max = glm::max(glm::clamp(region.max, 0.0f, 1.0f), region.min);
+    if (region.min == glm::vec2{0.0f} && region.max == glm::vec2{1.0f})
+    {
+        return std::nullopt;
     }
+    return region;
+}
 
-    if (ImGui::TreeNode("Shadow Mapping Parameters"))
+GLuint MainApplication::blur_condition() const
+{
+    return blur_condition_light_ ? light_visibility_.frame_query(blur_condition_light_.value()) : 0;
+}
+
+gl::ScissorState MainApplication::blur_scissor(const std::array<int, 4>& viewport) const
+{
+    if (!blur_region_)
     {
-        if (ImGui::SliderFloat("Near plane", &shadow_map_parameters_.near_plane, 0.0f, 2.0f))
-        {
-            shadow_map_parameters_.set_projection();
-        }
+        return gl::ScissorState{};
+    }
 
-        if (ImGui::SliderFloat("Far plane", &shadow_map_parameters_.far_plane, 2.0f, 200.0f))
-        {
-            shadow_map_parameters_.set_projection();
-        }
+    const glm::vec2 size{static_cast<float>(viewport[2]), static_cast<float>(viewport[3])};
+    const glm::ivec2 min{glm::max(glm::ivec2{glm::floor(blur_region_->min * size)} - blur_region_margin, 0)};
+    const glm::ivec2 max{glm::min(glm::ivec2{glm::ceil(blur_region_->max * size)} + blur_region_margin,
+                                  glm::ivec2{viewport[2], viewport[3]})};
+    return gl::ScissorState{.enabled = true,
+                            .rectangle = {viewport[0] + min.x, viewport[1] + min.y, std::max(max.x - min.x, 0),
+                                          std::max(max.y - min.y, 0)}};
+}
 
-        if (ImGui::SliderFloat("Frustum Dimensions", &shadow_map_parameters_.frustum_dimension, 1.0f, 50.0f))
-        {
-            shadow_map_parameters_.set_projection();
-        }
+gl::RenderGraph::ResourceHandle MainApplication::add_radial_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                                 const std::vector<glm::vec4>& light_positions,
+                                                                 int max_samples, float sample_offset)
+{
+    const gl::RenderGraph::ResourceHandle output{render_graph_.create_texture("Radial blur", blur_description_)};
+    // The target is cleared when the pass only renders the blur region
+    const bool clear_output{blur_region_.has_value()};
+    // Executed once this function has returned, so the lambda captures copies
+    render_graph_.add_pass(
+        "Radial blur",
+        [occlusion_map, output, clear_output](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(occlusion_map);
+            builder.write(output, clear_output);
+        },
+        [this, occlusion_map, output, light_positions, max_samples,
+         sample_offset](const gl::RenderGraph::Resources& resources) {
+            gl::state_cache().set_scissor(blur_scissor(texture_viewport(resources.texture(output))));
+            pipelines_->radial_blur.bind();
+            resources.texture(occlusion_map).bind(0);
+            radial_blur_shader_->set_vec4_array_uniform("screen_space_light_positions[0]", light_positions);
+            radial_blur_shader_->set_int_uniform("max_samples", max_samples);
+            radial_blur_shader_->set_float_uniform("sample_offset", sample_offset);
+            // The history of the temporal blur must be fed on every frame, so its blur is unconditional
+            const gl::LightVisibility::ConditionalRender condition{
+                blur_method_ == BlurMethod::Temporal ? 0 : blur_condition()};
+            full_screen_quad_->render();
+        });
+    return output;
+}
 
-        if (ImGui::SliderFloat("Shadow Bias", &shadow_map_parameters_.bias, 0.001f, 0.01f))
+gl::RenderGraph::ResourceHandle MainApplication::add_temporal_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                                   gl::RenderGraph::ResourceHandle occlusion_depth,
+                                                                   const std::vector<glm::vec4>& light_positions,
+                                                                   const glm::mat4& view_projection,
+                                                                   const glm::vec4& screen_light_position,
+                                                                   const glm::vec3& light_position)
+{
+    // The histories follow the size of the blur targets; new histories start the accumulation over
+    const gl::TextureDescription history_description{render_graph_.sized_description(blur_description_)};
+    for (auto& history : temporal_blur_.histories)
+    {
+        if (!history || history->width() != history_description.width ||
+            history->height() != history_description.height)
         {
-            texture_blinn_phong_shader_->set_float_uniform("bias", shadow_map_parameters_.bias);
-            color_blinn_phong_shader_->set_float_uniform("bias", shadow_map_parameters_.bias);
+            if (history)
+            {
+                render_graph_.forget_texture(history.value());
+            }
+            const gl::GpuMemoryTracker::OwnerScope owner{"Temporal blur history"};
+            history.emplace(history_description.width, history_description.height, history_description.attributes);
+            gl::debug_output().label(GL_TEXTURE, history->id(), "Radial blur history");
+            temporal_blur_.history_valid = false;
         }
-
-        ImGui::SliderFloat3("Target position (lookAt)", glm::value_ptr(shadow_map_parameters_.target), -10.0f, 10.0f);
-
-        ImGui::TreePop();
     }
 
-    if (ImGui::SliderFloat3("Light Direction", glm::value_ptr(light_.direction), -20.0f, 20.0f))
+    /*
+    The history is dropped when the light moved in the scene, i.e. when its
+    position of the previous frame, seen by the current camera, is away from
+    its current position on the screen. Its motion can't be measured if it's
+    hidden or if its previous position is behind the camera.
+    */
+    const glm::vec4 previous_clip_light_position{view_projection *
+                                                 glm::vec4{temporal_blur_.previous_light_position, 1.0f}};
+    bool light_moved{true};
+    if (screen_light_position.w > 0.0f && previous_clip_light_position.w > 0.0f)
     {
-        models_.at("UVSphere").translation = light_.direction;
-        texture_blinn_phong_shader_->set_vec3_uniform("light.direction", light_.direction);
-        color_blinn_phong_shader_->set_vec3_uniform("light.direction", light_.direction);
+        const glm::vec2 previous_screen_light_position{
+            (glm::vec2{previous_clip_light_position} / previous_clip_light_position.w + 1.0f) * 0.5f};
+        light_moved = glm::distance(previous_screen_light_position, glm::vec2{screen_light_position}) >
+                      temporal_light_motion_threshold;
     }
+    const float history_weight{temporal_blur_.history_valid && !light_moved ? temporal_blur_.history_weight : 0.0f};
+    const glm::mat4 reprojection{temporal_blur_.previous_view_projection * glm::inverse(view_projection)};
+    temporal_blur_.previous_view_projection = view_projection;
+    temporal_blur_.previous_light_position = light_position;
+    temporal_blur_.history_valid = true;
+    const float sample_offset{
+        temporal_blur_.jitter_sequence[temporal_blur_.frame++ % temporal_blur_.jitter_sequence.size()]};
+
+    const gl::RenderGraph::ResourceHandle blurred_map{
+        add_radial_blur(occlusion_map, light_positions, temporal_blur_.samples, sample_offset)};
+    // The histories persist across frames, so they're owned by the application and imported into the graph
+    const gl::RenderGraph::ResourceHandle history{render_graph_.import_texture(
+        "Radial blur history", temporal_blur_.histories[temporal_blur_.current_history].value())};
+    temporal_blur_.current_history = 1 - temporal_blur_.current_history;
+    const gl::RenderGraph::ResourceHandle output{render_graph_.import_texture(
+        "Radial blur (temporal)", temporal_blur_.histories[temporal_blur_.current_history].value())};
+    // Executed once this function has returned, so the lambda captures copies
+    render_graph_.add_pass(
+        "Radial blur (temporal)",
+        [blurred_map, occlusion_map, occlusion_depth, history, output](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(blurred_map);
+            builder.read(occlusion_map);
+            builder.read(occlusion_depth);
+            builder.read(history);
+            // Every pixel is resolved, so the history of the frame needs no clear
+            builder.write(output, false);
+        },
+        [this, blurred_map, occlusion_map, occlusion_depth, history, reprojection,
+         history_weight](const gl::RenderGraph::Resources& resources) {
+            pipelines_->temporal_resolve.bind();
+            resources.texture(blurred_map).bind(0);
+            resources.texture(history).bind(1);
+            resources.texture(occlusion_depth).bind(2);
+            resources.texture(occlusion_map).bind(3);
+            temporal_resolve_shader_->set_mat4_uniform("reprojection", reprojection);
+            temporal_resolve_shader_->set_float_uniform("history_weight", history_weight);
+            temporal_resolve_shader_->set_float_uniform("occlusion_threshold", temporal_blur_.occlusion_threshold);
+            full_screen_quad_->render();
+        });
+    return output;
+}
+
+gl::RenderGraph::ResourceHandle MainApplication::add_compute_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                                  const glm::vec2& light_position)
+{
+    const gl::RenderGraph::ResourceHandle output{
+        render_graph_.create_texture("Radial blur (compute)", blur_description_)};
+    /*
+    The target is written as an image, so the pass doesn't draw into it; it's
+    only cleared when the dispatch covers the tiles of the blur region alone.
+    */
+    const bool clear_output{blur_region_.has_value()};
+    render_graph_.add_pass(
+        "Radial blur (compute)",
+        [occlusion_map, output, clear_output](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(occlusion_map);
+            builder.write(output, clear_output);
+        },
+        [this, occlusion_map, output, light_position](const gl::RenderGraph::Resources& resources) {
+            gl::Texture& blurred_map = resources.texture(output);
+            const gl::ScissorState region{blur_scissor(texture_viewport(blurred_map))};
+            const auto first_tile_x = static_cast<GLuint>(region.rectangle[0]) / compute_blur_tile_size;
+            const auto first_tile_y = static_cast<GLuint>(region.rectangle[1]) / compute_blur_tile_size;
+            const auto end_x = region.enabled ? static_cast<GLuint>(region.rectangle[0] + region.rectangle[2])
+                                              : blurred_map.width();
+            const auto end_y = region.enabled ? static_cast<GLuint>(region.rectangle[1] + region.rectangle[3])
+                                              : blurred_map.height();
+            compute_blur_shader_->use();
+            resources.texture(occlusion_map).bind(0);
+            blurred_map.bind_image(0, GL_WRITE_ONLY, 0);
+            compute_blur_shader_->set_vec2_uniform("screen_space_light_position", light_position);
+            compute_blur_shader_->set_uvec2_uniform("first_tile", glm::uvec2{first_tile_x, first_tile_y});
+            const GLuint tiles_x{(end_x + compute_blur_tile_size - 1) / compute_blur_tile_size};
+            const GLuint tiles_y{(end_y + compute_blur_tile_size - 1) / compute_blur_tile_size};
+            if (tiles_x > first_tile_x && tiles_y > first_tile_y)
+            {
+                glDispatchCompute(tiles_x - first_tile_x, tiles_y - first_tile_y, 1);
+            }
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        });
+    return output;
+}
+
+gl::RenderGraph::ResourceHandle MainApplication::add_epipolar_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                                   const glm::vec2& light_position)
+{
+    // Sums are fetched without filtering; their precision matters as windows are differences of prefix sums
+    const gl::Texture::Attributes epipolar_attributes{.wrap_s = GL_CLAMP_TO_EDGE,
+                                                      .wrap_t = GL_CLAMP_TO_EDGE,
+                                                      .min_filter = GL_NEAREST,
+                                                      .mag_filter = GL_NEAREST,
+                                                      .internal_format = GL_RGBA32F,
+                                                      .pixel_data_type = GL_FLOAT};
+    const gl::RenderGraph::ResourceHandle sums{render_graph_.create_texture(
+        "Epipolar sums", gl::TextureDescription{.width = epipolar_samples * epipolar_decay_rates,
+                                                .height = epipolar_lines,
+                                                .attributes = epipolar_attributes})};
+    const gl::RenderGraph::ResourceHandle lines{render_graph_.create_texture(
+        "Epipolar lines",
+        gl::TextureDescription{.width = epipolar_lines, .height = 1, .attributes = epipolar_attributes})};
+    const gl::RenderGraph::ResourceHandle output{
+        render_graph_.create_texture("Radial blur (epipolar)", blur_description_)};
+    // The gather target is cleared when the gather only renders the blur region
+    const bool clear_output{blur_region_.has_value()};
 
-    ImTextureID imgui_texture_id = reinterpret_cast<void*>(static_cast<std::intptr_t>(shadow_map_fbo_->depth_id()));
-    ImGui::Image(imgui_texture_id, ImVec2{200, 200}, ImVec2{0.0f, 0.0f}, ImVec2{1.0f, 1.0f},
-                 ImVec4{1.0f, 1.0f, 1.0f, 1.0f}, ImVec4{1.0f, 1.0f, 1.0f, 0.5f});
+    // Executed once this function has returned, so the lambdas capture copies
+    render_graph_.add_pass(
+        "Radial blur (epipolar scan)",
+        [occlusion_map, sums, lines](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(occlusion_map);
+            builder.write(sums, false);
+            builder.write(lines, false);
+        },
+        [this, occlusion_map, sums, lines, light_position](const gl::RenderGraph::Resources& resources) {
+            epipolar_scan_shader_->use();
+            resources.texture(occlusion_map).bind(0);
+            resources.texture(sums).bind_image(0, GL_WRITE_ONLY, 0);
+            resources.texture(lines).bind_image(1, GL_WRITE_ONLY, 0);
+            // The scan leaves the weight to the gather, so it lacks the uniforms of radial_blur_shaders
+            epipolar_scan_shader_->set_int_uniform("coefficients.num_samples", coefficients.num_samples);
+            epipolar_scan_shader_->set_float_uniform("coefficients.density", coefficients.density);
+            epipolar_scan_shader_->set_float_uniform("coefficients.decay", coefficients.decay);
+            epipolar_scan_shader_->set_vec2_uniform("screen_space_light_position", light_position);
+            glDispatchCompute(epipolar_lines, 1, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        });
+    render_graph_.add_pass(
+        "Radial blur (epipolar gather)",
+        [occlusion_map, sums, lines, output, clear_output](gl::RenderGraph::PassBuilder& builder) {
+            builder.read(occlusion_map);
+            builder.read(sums);
+            builder.read(lines);
+            builder.write(output, clear_output);
+        },
+        [this, occlusion_map, sums, lines, output, light_position](const gl::RenderGraph::Resources& resources) {
+            gl::state_cache().set_scissor(blur_scissor(texture_viewport(resources.texture(output))));
+            pipelines_->epipolar_gather.bind();
+            resources.texture(occlusion_map).bind(0);
+            resources.texture(sums).bind(1);
+            resources.texture(lines).bind(2);
+            epipolar_gather_shader_->set_vec2_uniform("screen_space_light_position", light_position);
+            const gl::LightVisibility::ConditionalRender condition{blur_condition()};
+            full_screen_quad_->render();
+        });
+    return output;
+}
+
+gl::RenderGraph::ResourceHandle MainApplication::add_multi_pass_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                                     const glm::vec2& light_position, float& gain)
+{
+    /*
+    Pass p takes taps^p times longer steps than the first one, and the steps
+    are fitted so that the farthest tap of the composite of the passes is the
+    farthest tap of the single-pass blur of num_samples taps. The composite
+    has taps^passes taps, denser towards the light since each pass scales the
+    distances of the taps of the previous ones. The decay between the taps of
+    a pass is that of the single-pass taps its step spans near the pixel.
+    */
+    const int passes{multi_pass_blur_.passes};
+    const int taps{multi_pass_blur_.taps};
+    const double samples{static_cast<double>(std::max(coefficients.num_samples, 1))};
+    const std::vector<double> step_fractions{multi_pass_step_fractions(passes, taps, coefficients.density)};
+    /*
+    The region is a square centered on the light, so the taps of its pixels
+    stay within it; its targets are cleared when the passes only render it.
+    */
+    const bool clear_output{blur_region_.has_value()};
+    gl::RenderGraph::ResourceHandle input{occlusion_map};
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        const double pass_step{step_fractions[static_cast<std::size_t>(pass)]};
+        const auto step_fraction = static_cast<float>(pass_step);
+        const double decay_exponent{
+            coefficients.density > 0.0f ? samples * pass_step / static_cast<double>(coefficients.density) : 0.0};
+        const auto tap_decay = static_cast<float>(std::pow(static_cast<double>(coefficients.decay), decay_exponent));
+
+        const gl::RenderGraph::ResourceHandle output{
+            render_graph_.create_texture("Radial blur " + std::to_string(pass + 1), blur_description_)};
+        // Executed once this function has returned, so the lambda captures copies
+        render_graph_.add_pass(
+            "Radial blur " + std::to_string(pass + 1),
+            [input, output, clear_output](gl::RenderGraph::PassBuilder& builder) {
+                builder.read(input);
+                builder.write(output, clear_output);
+            },
+            [this, input, output, light_position, taps, step_fraction,
+             tap_decay](const gl::RenderGraph::Resources& resources) {
+                gl::state_cache().set_scissor(blur_scissor(texture_viewport(resources.texture(output))));
+                pipelines_->multi_pass_blur.bind();
+                resources.texture(input).bind(0);
+                multi_pass_blur_shader_->set_vec2_uniform("screen_space_light_position", light_position);
+                multi_pass_blur_shader_->set_int_uniform("taps", taps);
+                multi_pass_blur_shader_->set_float_uniform("step_fraction", step_fraction);
+                multi_pass_blur_shader_->set_float_uniform("tap_decay", tap_decay);
+                const gl::LightVisibility::ConditionalRender condition{blur_condition()};
+                full_screen_quad_->render();
+            });
+        input = output;
+    }
+
+    /*
+    The passes average their taps, so the composite keeps the brightness of a
+    uniform occlusion map, which the single-pass blur scales by the sum of the
+    weights of its taps.
+    */
+    double weights_sum{0.0};
+    for (int sample = 0; sample < coefficients.num_samples; ++sample)
+    {
+        weights_sum += std::pow(static_cast<double>(coefficients.decay), sample);
+    }
+    gain = static_cast<float>(coefficients.weight * weights_sum);
+    return input;
+}
+
+void MainApplication::set_render_mode(RenderMode render_mode)
+{
+    set_parameter("render_mode", static_cast<float>(render_mode));
+}
+
+void MainApplication::set_blur_method(BlurMethod blur_method)
+{
+    set_parameter("blur_method", static_cast<float>(blur_method));
+}
+
+gl::BenchmarkReport MainApplication::run_benchmark(const BenchmarkSettings& settings)
+{
+    if (settings.camera_track && settings.camera_track->empty())
+    {
+        throw std::invalid_argument("The camera track of the benchmark has no keyframes");
+    }
+
+    // The profiler keeps the results of every frame of the run
+    const std::size_t measured_frames{settings.camera_track ? settings.camera_track->number_of_frames()
+                                                            : settings.frames};
+    const std::size_t total_frames{settings.warmup_frames + measured_frames};
+    gpu_profiler_ = std::make_unique<gl::GpuProfiler>(total_frames);
+
+    std::vector<double> cpu_frame_ms;
+    cpu_frame_ms.reserve(measured_frames);
+    // Counts summed over the measured frames, by pass
+    std::map<std::string, gl::BenchmarkReport::Counters> pass_counters;
+    for (std::size_t frame = 0; frame < total_frames; ++frame)
+    {
+        // The path is sampled at fixed steps rather than elapsed time, so every run renders the same frames
+        const std::size_t measured_frame{frame < settings.warmup_frames ? 0 : frame - settings.warmup_frames};
+        if (!settings.camera_track)
+        {
+            follow_benchmark_camera_path(camera(), measured_frames > 1 ? static_cast<float>(measured_frame) /
+                                                                             static_cast<float>(measured_frames - 1)
+                                                                       : 0.0f);
+        }
+        else if (frame < settings.warmup_frames)
+        {
+            gl::CameraTrack::apply(settings.camera_track->pose_at(0.0), camera());
+        }
+        else
+        {
+            if (frame == settings.warmup_frames)
+            {
+                start_playback(*settings.camera_track);
+            }
+            step_playback();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        gl::frame_stats().begin_frame();
+        render();
+        gl::frame_stats().end_frame();
+        gl::state_cache().invalidate();
+        present();
+        if (frame >= settings.warmup_frames)
+        {
+            cpu_frame_ms.emplace_back(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            for (const auto& pass : gl::frame_stats().last_frame())
+            {
+                gl::BenchmarkReport::Counters& counters = pass_counters[pass.name];
+                std::transform(counters.cbegin(), counters.cend(), pass.counters.cbegin(), counters.begin(),
+                               [](double sum, std::uint64_t count) { return sum + static_cast<double>(count); });
+            }
+        }
+    }
+    if (settings.camera_track)
+    {
+        stop_playback();
+    }
+    gpu_profiler_->flush();
+
+    GLint samples{0};
+    glGetNamedFramebufferParameteriv(default_framebuffer(), GL_SAMPLES, &samples);
+    gl::BenchmarkReport report{.renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+                               .width = width_,
+                               .height = height_,
+                               .samples = samples,
+                               .warmup_frames = settings.warmup_frames,
+                               .dropped_gpu_frames = gpu_profiler_->dropped_frames(),
+                               .cpu_frame_ms = std::move(cpu_frame_ms)};
+
+    // The GPU time of a frame is the sum of its passes
+    std::map<std::uint64_t, double> gpu_frame_ms;
+    for (const auto& scope : gpu_profiler_->scopes())
+    {
+        gl::BenchmarkReport::Pass& pass = report.passes.emplace_back(gl::BenchmarkReport::Pass{.name = scope.name});
+        for (const auto& sample : scope.history)
+        {
+            if (sample.frame >= settings.warmup_frames)
+            {
+                pass.cpu_ms.emplace_back(sample.cpu_ms);
+                pass.gpu_ms.emplace_back(sample.gpu_ms);
+                gpu_frame_ms[sample.frame] += sample.gpu_ms;
+            }
+        }
+    }
+    for (const auto& [frame, frame_ms] : gpu_frame_ms)
+    {
+        report.gpu_frame_ms.emplace_back(frame_ms);
+    }
+
+    // Counts are reported as means per measured frame
+    const auto mean_counters = [measured_frames](const gl::BenchmarkReport::Counters& sums) {
+        gl::BenchmarkReport::Counters means{};
+        std::transform(sums.cbegin(), sums.cend(), means.begin(),
+                       [measured_frames](double sum) { return sum / static_cast<double>(measured_frames); });
+        return means;
+    };
+    for (gl::BenchmarkReport::Pass& pass : report.passes)
+    {
+        pass.counters = mean_counters(pass_counters[pass.name]);
+    }
+    for (const auto& [name, sums] : pass_counters)
+    {
+        const gl::BenchmarkReport::Counters means{mean_counters(sums)};
+        std::transform(report.frame_counters.cbegin(), report.frame_counters.cend(), means.cbegin(),
+                       report.frame_counters.begin(), std::plus<>{});
+    }
+    report.gpu_memory = gl::gpu_memory().snapshot();
+
+    return report;
+}
+
+void MainApplication::apply_software_occlusion_culling(gl::Model& model, const glm::mat4& mvp)
+{
+    GL_PROFILE_SCOPE("culling", "Software occlusion culling");
+    const auto start = std::chrono::steady_clock::now();
+    software_occlusion_culler_->render_occluders(mvp);
+
+    software_culled_meshes_ = 0;
+    for (auto* render_data : {&model.opaque_render_data(), &model.semitransparent_render_data()})
+    {
+        for (auto& mesh_data : *render_data)
+        {
+            mesh_data.visible = software_occlusion_culler_->is_visible(mesh_data.mesh.bounds(), mvp);
+            if (!mesh_data.visible)
+            {
+                ++software_culled_meshes_;
+            }
+        }
+    }
+
+    software_occlusion_time_ms_ =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::array<gl::ShaderProgram*, 3> MainApplication::blinn_phong_shaders()
+{
+    return {texture_blinn_phong_shader_.get(), color_blinn_phong_shader_.get(), gpu_color_blinn_phong_shader_.get()};
+}
+
+std::array<gl::ShaderProgram*, 4> MainApplication::radial_blur_shaders()
+{
+    return {post_process_shader_.get(), radial_blur_shader_.get(), compute_blur_shader_.get(),
+            epipolar_gather_shader_.get()};
+}
+
+std::array<gl::ShaderProgram*, 2> MainApplication::single_pass_blur_shaders()
+{
+    return {post_process_shader_.get(), radial_blur_shader_.get()};
+}
+
+void MainApplication::ShadowMapParameters::set_projection()
+{
+    light_projection =
+        glm::ortho(-frustum_dimension, frustum_dimension, -frustum_dimension, frustum_dimension, near_plane, far_plane);
+}
+
+void MainApplication::set_parameter(std::string_view name, float value)
+{
+    record_parameter(name, value);
+    apply_track_parameter(name, value);
+}
+
+void MainApplication::apply_track_parameter(std::string_view name, float value)
+{
+    if (name == "render_mode")
+    {
+        render_mode_ = static_cast<RenderMode>(std::clamp(static_cast<int>(value), 0, 3));
+    }
+    else if (name == "blur_method")
+    {
+        blur_method_ = static_cast<BlurMethod>(std::clamp(static_cast<int>(value), 0, 4));
+    }
+    else if (name == "blur_resolution")
+    {
+        set_blur_resolution(value >= 4.0f   ? BlurResolution::Quarter
+                            : value >= 2.0f ? BlurResolution::Half
+                                            : BlurResolution::Full);
+    }
+    else if (name == "scissor_blur_region")
+    {
+        scissor_blur_region_ = value != 0.0f;
+    }
+    else if (name == "depth_aware_upsample")
+    {
+        depth_aware_upsample_ = value != 0.0f;
+    }
+    else if (name == "blur_sampling")
+    {
+        set_blur_sampling(value >= 1.0f ? BlurSampling::Cone : BlurSampling::Uniform);
+    }
+    else if (name == "cone_taps")
+    {
+        cone_taps_ = std::clamp(static_cast<int>(value), 8, 32);
+        for (auto* shader : single_pass_blur_shaders())
+        {
+            shader->set_int_uniform("cone_taps", cone_taps_);
+        }
+    }
+    else if (name == "adaptive_sampling.enabled" || name == "adaptive_sampling.jitter")
+    {
+        const bool enabled{value != 0.0f};
+        (name == "adaptive_sampling.enabled" ? adaptive_sampling_.enabled : adaptive_sampling_.jitter) = enabled;
+        for (auto* shader : single_pass_blur_shaders())
+        {
+            shader->set_bool_uniform(name == "adaptive_sampling.enabled" ? "adaptive_sampling" : "jitter_samples",
+                                     enabled);
+        }
+    }
+    else if (name == "adaptive_sampling.min_samples")
+    {
+        adaptive_sampling_.min_samples = std::clamp(static_cast<int>(value), 1, 64);
+        for (auto* shader : single_pass_blur_shaders())
+        {
+            shader->set_int_uniform("min_samples", adaptive_sampling_.min_samples);
+        }
+    }
+    else if (name == "adaptive_sampling.texels_per_sample")
+    {
+        adaptive_sampling_.texels_per_sample = std::clamp(value, 0.5f, 8.0f);
+        for (auto* shader : single_pass_blur_shaders())
+        {
+            shader->set_float_uniform("texels_per_sample", adaptive_sampling_.texels_per_sample);
+        }
+    }
+    else if (name == "temporal_blur.samples")
+    {
+        temporal_blur_.samples = std::clamp(static_cast<int>(value), 2, 32);
+    }
+    else if (name == "temporal_blur.history_weight")
+    {
+        temporal_blur_.history_weight = std::clamp(value, 0.0f, 0.98f);
+    }
+    else if (name == "temporal_blur.occlusion_threshold")
+    {
+        temporal_blur_.occlusion_threshold = std::clamp(value, 0.01f, 1.0f);
+    }
+    else if (name == "multi_pass_blur.passes")
+    {
+        multi_pass_blur_.passes = std::clamp(static_cast<int>(value), 1, 4);
+    }
+    else if (name == "multi_pass_blur.taps")
+    {
+        multi_pass_blur_.taps = std::clamp(static_cast<int>(value), 2, 16);
+    }
+    else if (name == "coefficients.num_samples")
+    {
+        coefficients.num_samples = std::clamp(static_cast<int>(value), 0, 512);
+        for (auto* shader : radial_blur_shaders())
+        {
+            shader->set_int_uniform("coefficients.num_samples", coefficients.num_samples);
+        }
+    }
+    else if (name.starts_with("coefficients."))
+    {
+        const std::map<std::string_view, float*> float_coefficients{{"coefficients.density", &coefficients.density},
+                                                                    {"coefficients.exposure", &coefficients.exposure},
+                                                                    {"coefficients.decay", &coefficients.decay},
+                                                                    {"coefficients.weight", &coefficients.weight}};
+        if (const auto coefficient = float_coefficients.find(name); coefficient != float_coefficients.cend())
+        {
+            *coefficient->second = value;
+            for (auto* shader : radial_blur_shaders())
+            {
+                // Shaders of the blur targets leave the exposure to the composite, so they lack its uniform
+                if (shader->uniform_location(std::string{name}) != -1)
+                {
+                    shader->set_float_uniform(std::string{name}, value);
+                }
+            }
+        }
+    }
+    else if (name == "shadow_map.near_plane" || name == "shadow_map.far_plane" ||
+             name == "shadow_map.frustum_dimension")
+    {
+        float& parameter{name == "shadow_map.near_plane"  ? shadow_map_parameters_.near_plane
+                         : name == "shadow_map.far_plane" ? shadow_map_parameters_.far_plane
+                                                          : shadow_map_parameters_.frustum_dimension};
+        parameter = value;
+        shadow_map_parameters_.set_projection();
+    }
+    else if (name == "shadow_map.size")
+    {
+        // The graph allocates a new shadow map; the previous one is released once it has been unused for a while
+        shadow_map_parameters_.size =
+            static_cast<int>(std::bit_floor(static_cast<unsigned int>(std::clamp(static_cast<int>(value), 512, 4096))));
+        shadow_map_description_.width = static_cast<std::uint32_t>(shadow_map_parameters_.size);
+        shadow_map_description_.height = static_cast<std::uint32_t>(shadow_map_parameters_.size);
+    }
+    else if (name == "occlusion_scale")
+    {
+        occlusion_scale_ = std::clamp(value, 0.25f, 1.0f);
+        occlusion_map_description_.scale = occlusion_scale_;
+        occlusion_depth_description_.scale = occlusion_scale_;
+    }
+    else if (name == "shadow_map.bias")
+    {
+        shadow_map_parameters_.bias = value;
+        for (auto* shader : blinn_phong_shaders())
+        {
+            shader->set_float_uniform("bias", shadow_map_parameters_.bias);
+        }
+    }
+    else if (const auto component = vector_component(name, "shadow_map.target."))
+    {
+        shadow_map_parameters_.target[*component] = value;
+    }
+    else if (name.starts_with("light_colors."))
+    {
+        for (std::size_t i = 0; i < number_of_lights; ++i)
+        {
+            if (const auto component = vector_component(name, "light_colors." + std::to_string(i) + "."))
+            {
+                glm::vec3 color{light_colors_[i]};
+                color[*component] = std::clamp(value, 0.0f, 1.0f);
+                set_light_color(i, color);
+            }
+        }
+    }
+    else if (name == "compact_occlusion_depth")
+    {
+        set_compact_occlusion_depth(value != 0.0f);
+    }
+    else if (const auto component = vector_component(name, "light.direction."))
+    {
+        light_.direction[*component] = value;
+        models_.at("UVSphere").translation = light_.direction;
+        for (auto* shader : blinn_phong_shaders())
+        {
+            shader->set_vec3_uniform("light.direction", light_.direction);
+        }
+    }
+    else if (name == "gpu_driven_culling")
+    {
+        gpu_driven_culling_ = value != 0.0f;
+    }
+    else if (name == "software_occlusion_culling")
+    {
+        software_occlusion_culling_ = value != 0.0f;
+    }
+    else
+    {
+        std::cerr << "Unknown camera track parameter " << name << "\n";
+    }
+}
+
+void MainApplication::resize(int width, int height)
+{
+    gl::Application::resize(width, height);
+    software_occlusion_culler_->resize(std::max(static_cast<std::uint32_t>(width_ / 4), 1u),
+                                       std::max(static_cast<std::uint32_t>(height_ / 4), 1u));
+}
+
+void MainApplication::render_imgui_editor()
+{
+    GL_PROFILE_SCOPE("frame", "ImGui");
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::Begin("Settings");
+    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
+                ImGui::GetIO().Framerate);
+
+    int render_mode_value{static_cast<int>(render_mode_)};
+    if (ImGui::TreeNode("Render Mode"))
+    {
+        bool render_mode_changed{false};
+        render_mode_changed |= ImGui::RadioButton("Default Scene Only", &render_mode_value,
+                                                  static_cast<int>(RenderMode::DefaultSceneOnly));
+        render_mode_changed |= ImGui::RadioButton("Occlusion Map Only", &render_mode_value,
+                                                  static_cast<int>(RenderMode::OcclusionMapOnly));
+        render_mode_changed |= ImGui::RadioButton("Radial Blur Only", &render_mode_value,
+                                                  static_cast<int>(RenderMode::RadialBlurOnly));
+        render_mode_changed |= ImGui::RadioButton("Complete Scene", &render_mode_value,
+                                                  static_cast<int>(RenderMode::CompleteRender));
+        if (render_mode_changed)
+        {
+            set_parameter("render_mode", static_cast<float>(render_mode_value));
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Window: %dx%d", width_, height_);
+        if (ImGui::SliderFloat("Occlusion Map Scale", &occlusion_scale_, 0.25f, 1.0f))
+        {
+            set_parameter("occlusion_scale", occlusion_scale_);
+        }
+        for (std::size_t i = 0; i < number_of_lights; ++i)
+        {
+            const std::string prefix{"light_colors." + std::to_string(i) + "."};
+            glm::vec3 light_color{light_colors_[i]};
+            if (ImGui::ColorEdit3(("Light " + std::to_string(i + 1) + " Color").c_str(), glm::value_ptr(light_color)))
+            {
+                set_parameter(prefix + "x", light_color.x);
+                set_parameter(prefix + "y", light_color.y);
+                set_parameter(prefix + "z", light_color.z);
+            }
+        }
+        ImGui::Text("Occlusion map: %s", occlusion_format_ == OcclusionFormat::Mask ? "R8 mask" : "R11G11B10F");
+        bool compact_occlusion_depth{compact_occlusion_depth_};
+        if (ImGui::Checkbox("16-bit Occlusion Depth", &compact_occlusion_depth))
+        {
+            set_parameter("compact_occlusion_depth", compact_occlusion_depth ? 1.0f : 0.0f);
+        }
+
+        ImGui::Separator();
+        int blur_method_value{static_cast<int>(blur_method_)};
+        bool blur_method_changed{false};
+        blur_method_changed |= ImGui::RadioButton("Single-pass Blur", &blur_method_value,
+                                                  static_cast<int>(BlurMethod::SinglePass));
+        blur_method_changed |= ImGui::RadioButton("Multi-pass Blur", &blur_method_value,
+                                                  static_cast<int>(BlurMethod::MultiPass));
+        blur_method_changed |= ImGui::RadioButton("Compute Blur", &blur_method_value,
+                                                  static_cast<int>(BlurMethod::Compute));
+        blur_method_changed |= ImGui::RadioButton("Epipolar Blur", &blur_method_value,
+                                                  static_cast<int>(BlurMethod::Epipolar));
+        blur_method_changed |= ImGui::RadioButton("Temporal Blur", &blur_method_value,
+                                                  static_cast<int>(BlurMethod::Temporal));
+        if (blur_method_changed)
+        {
+            set_parameter("blur_method", static_cast<float>(blur_method_value));
+        }
+        int blur_resolution_value{gl::to_underlying(blur_resolution_)};
+        bool blur_resolution_changed{false};
+        ImGui::Text("Blur resolution:");
+        ImGui::SameLine();
+        blur_resolution_changed |= ImGui::RadioButton("Full", &blur_resolution_value,
+                                                      gl::to_underlying(BlurResolution::Full));
+        ImGui::SameLine();
+        blur_resolution_changed |= ImGui::RadioButton("1/2", &blur_resolution_value,
+                                                      gl::to_underlying(BlurResolution::Half));
+        ImGui::SameLine();
+        blur_resolution_changed |= ImGui::RadioButton("1/4", &blur_resolution_value,
+                                                      gl::to_underlying(BlurResolution::Quarter));
+        if (blur_resolution_changed)
+        {
+            set_parameter("blur_resolution", static_cast<float>(blur_resolution_value));
+        }
+        if (blur_resolution_ != BlurResolution::Full &&
+            ImGui::Checkbox("Depth-aware Upsampling", &depth_aware_upsample_))
+        {
+            set_parameter("depth_aware_upsample", depth_aware_upsample_ ? 1.0f : 0.0f);
+        }
+        if (ImGui::Checkbox("Scissor Blur Region", &scissor_blur_region_))
+        {
+            set_parameter("scissor_blur_region", scissor_blur_region_ ? 1.0f : 0.0f);
+        }
+        if (scissor_blur_region_)
+        {
+            const glm::vec2 region_size{blur_region_ ? blur_region_->max - blur_region_->min : glm::vec2{1.0f}};
+            ImGui::Text("Blur region: %.0f%% of the screen", 100.0f * region_size.x * region_size.y);
+        }
+        std::size_t visible_lights{0};
+        for (std::size_t i = 0; i < light_visibility_.lights().size(); ++i)
+        {
+            visible_lights += light_visibility_.is_visible(i) ? 1 : 0;
+        }
+        ImGui::Text("Visible lights: %zu of %zu", visible_lights, light_visibility_.lights().size());
+        if (blur_method_ == BlurMethod::SinglePass)
+        {
+            int blur_sampling_value{gl::to_underlying(blur_sampling_)};
+            bool blur_sampling_changed{false};
+            blur_sampling_changed |= ImGui::RadioButton("Uniform Taps (quality)", &blur_sampling_value,
+                                                        gl::to_underlying(BlurSampling::Uniform));
+            ImGui::SameLine();
+            blur_sampling_changed |= ImGui::RadioButton("Cone-traced Mips (speed)", &blur_sampling_value,
+                                                        gl::to_underlying(BlurSampling::Cone));
+            if (blur_sampling_changed)
+            {
+                set_parameter("blur_sampling", static_cast<float>(blur_sampling_value));
+            }
+            if (blur_sampling_ == BlurSampling::Cone && ImGui::SliderInt("Cone Taps", &cone_taps_, 8, 32))
+            {
+                set_parameter("cone_taps", static_cast<float>(cone_taps_));
+            }
+            if (blur_sampling_ == BlurSampling::Uniform)
+            {
+                if (ImGui::Checkbox("Adaptive Taps", &adaptive_sampling_.enabled))
+                {
+                    set_parameter("adaptive_sampling.enabled", adaptive_sampling_.enabled ? 1.0f : 0.0f);
+                }
+                if (adaptive_sampling_.enabled)
+                {
+                    if (ImGui::SliderInt("Min Taps", &adaptive_sampling_.min_samples, 1, 64))
+                    {
+                        set_parameter("adaptive_sampling.min_samples",
+                                      static_cast<float>(adaptive_sampling_.min_samples));
+                    }
+                    if (ImGui::SliderFloat("Texels per Tap", &adaptive_sampling_.texels_per_sample, 0.5f, 8.0f))
+                    {
+                        set_parameter("adaptive_sampling.texels_per_sample", adaptive_sampling_.texels_per_sample);
+                    }
+                    ImGui::Text("Average taps per pixel: %.1f of %d", average_blur_taps(), coefficients.num_samples);
+                }
+                if (ImGui::Checkbox("Jittered Taps", &adaptive_sampling_.jitter))
+                {
+                    set_parameter("adaptive_sampling.jitter", adaptive_sampling_.jitter ? 1.0f : 0.0f);
+                }
+            }
+        }
+        if (blur_method_ == BlurMethod::Temporal)
+        {
+            if (ImGui::SliderInt("Taps per Frame", &temporal_blur_.samples, 2, 32))
+            {
+                set_parameter("temporal_blur.samples", static_cast<float>(temporal_blur_.samples));
+            }
+            if (ImGui::SliderFloat("History Weight", &temporal_blur_.history_weight, 0.0f, 0.98f))
+            {
+                set_parameter("temporal_blur.history_weight", temporal_blur_.history_weight);
+            }
+            if (ImGui::SliderFloat("Occlusion Threshold", &temporal_blur_.occlusion_threshold, 0.01f, 1.0f))
+            {
+                set_parameter("temporal_blur.occlusion_threshold", temporal_blur_.occlusion_threshold);
+            }
+        }
+        if (blur_method_ == BlurMethod::MultiPass)
+        {
+            if (ImGui::SliderInt("Passes", &multi_pass_blur_.passes, 1, 4))
+            {
+                set_parameter("multi_pass_blur.passes", static_cast<float>(multi_pass_blur_.passes));
+            }
+            if (ImGui::SliderInt("Taps per pass", &multi_pass_blur_.taps, 2, 16))
+            {
+                set_parameter("multi_pass_blur.taps", static_cast<float>(multi_pass_blur_.taps));
+            }
+            ImGui::Text("Effective taps: %.0f", std::pow(static_cast<double>(multi_pass_blur_.taps),
+                                                         multi_pass_blur_.passes));
+        }
+
+        // GPU time of the blur, whichever passes implement it
+        double blur_ms{0.0};
+        for (const auto& scope : gpu_profiler_->scopes())
+        {
+            if (scope.name == "Post-process" || scope.name.starts_with("Radial blur"))
+            {
+                blur_ms += scope.average_ms;
+            }
+        }
+        ImGui::Text("Blur and composite GPU time: %.3f ms", blur_ms);
+        ImGui::TreePop();
+    }
+
+    // See Mitchell "Volumetric Light Scattering as a Post-Process" for a detailed explanation
+    // of each post-processing parameter.
+    if (ImGui::TreeNode("Post-processing Coefficients"))
+    {
+        if (ImGui::InputInt("Number of samples", &coefficients.num_samples))
+        {
+            set_parameter("coefficients.num_samples", static_cast<float>(coefficients.num_samples));
+        }
+
+        if (ImGui::SliderFloat("Density", &coefficients.density, 0.0f, 2.0f))
+        {
+            set_parameter("coefficients.density", coefficients.density);
+        }
+
+        if (ImGui::SliderFloat("Exposure", &coefficients.exposure, 0.0f, 10.0f))
+        {
+            set_parameter("coefficients.exposure", coefficients.exposure);
+        }
+
+        if (ImGui::SliderFloat("Decay", &coefficients.decay, 0.0f, 1.0f))
+        {
+            set_parameter("coefficients.decay", coefficients.decay);
+        }
+
+        if (ImGui::SliderFloat("Weight", &coefficients.weight, 0.0f, 0.1f))
+        {
+            set_parameter("coefficients.weight", coefficients.weight);
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Shadow Mapping Parameters"))
+    {
+        if (ImGui::SliderFloat("Near plane", &shadow_map_parameters_.near_plane, 0.0f, 2.0f))
+        {
+            set_parameter("shadow_map.near_plane", shadow_map_parameters_.near_plane);
+        }
+
+        if (ImGui::SliderFloat("Far plane", &shadow_map_parameters_.far_plane, 2.0f, 200.0f))
+        {
+            set_parameter("shadow_map.far_plane", shadow_map_parameters_.far_plane);
+        }
+
+        if (ImGui::SliderFloat("Frustum Dimensions", &shadow_map_parameters_.frustum_dimension, 1.0f, 50.0f))
+        {
+            set_parameter("shadow_map.frustum_dimension", shadow_map_parameters_.frustum_dimension);
+        }
+
+        if (ImGui::SliderFloat("Shadow Bias", &shadow_map_parameters_.bias, 0.001f, 0.01f))
+        {
+            set_parameter("shadow_map.bias", shadow_map_parameters_.bias);
+        }
+
+        constexpr std::array<const char*, 4> shadow_map_sizes{"512", "1024", "2048", "4096"};
+        int shadow_map_size_index{std::countr_zero(static_cast<unsigned int>(shadow_map_parameters_.size)) - 9};
+        if (ImGui::Combo("Shadow Map Size", &shadow_map_size_index, shadow_map_sizes.data(),
+                         static_cast<int>(shadow_map_sizes.size())))
+        {
+            set_parameter("shadow_map.size", static_cast<float>(512 << shadow_map_size_index));
+        }
+
+        if (ImGui::SliderFloat3("Target position (lookAt)", glm::value_ptr(shadow_map_parameters_.target), -10.0f,
+                                10.0f))
+        {
+            set_parameter("shadow_map.target.x", shadow_map_parameters_.target.x);
+            set_parameter("shadow_map.target.y", shadow_map_parameters_.target.y);
+            set_parameter("shadow_map.target.z", shadow_map_parameters_.target.z);
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::SliderFloat3("Light Direction", glm::value_ptr(light_.direction), -20.0f, 20.0f))
+    {
+        set_parameter("light.direction.x", light_.direction.x);
+        set_parameter("light.direction.y", light_.direction.y);
+        set_parameter("light.direction.z", light_.direction.z);
+    }
+
+    if (ImGui::TreeNode("Culling"))
+    {
+        if (ImGui::Checkbox("GPU-driven culling (Hi-Z)", &gpu_driven_culling_))
+        {
+            set_parameter("gpu_driven_culling", gpu_driven_culling_ ? 1.0f : 0.0f);
+        }
+        ImGui::Text("Indirect draws: %zu", gpu_driven_sibenik_->number_of_draws());
+        if (ImGui::Checkbox("CPU software occlusion culling", &software_occlusion_culling_))
+        {
+            set_parameter("software_occlusion_culling", software_occlusion_culling_ ? 1.0f : 0.0f);
+        }
+        ImGui::Text("%.*s rasterizer, %zu threads, %zu occluder triangles",
+                    static_cast<int>(gl::SoftwareOcclusionCuller::instruction_set().size()),
+                    gl::SoftwareOcclusionCuller::instruction_set().data(),
+                    software_occlusion_culler_->number_of_threads(),
+                    software_occlusion_culler_->number_of_occluder_triangles());
+        if (software_occlusion_culling_)
+        {
+            ImGui::Text("Culled meshes: %zu (%.3f ms)", software_culled_meshes_, software_occlusion_time_ms_);
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Camera Track"))
+    {
+        // Tracks are saved to and played back from camera_track.bin, e.g. to be passed to --benchmark --track
+        try
+        {
+            if (is_recording())
+            {
+                if (ImGui::Button("Stop recording"))
+                {
+                    stop_recording().save("camera_track.bin");
+                }
+            }
+            else if (is_playing_back())
+            {
+                if (ImGui::Button("Stop playback"))
+                {
+                    stop_playback();
+                }
+            }
+            else
+            {
+                if (ImGui::Button("Record"))
+                {
+                    start_recording();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Play"))
+                {
+                    start_playback(gl::CameraTrack::load("camera_track.bin"));
+                }
+            }
+        }
+        catch (const std::runtime_error& error)
+        {
+            std::cerr << error.what() << "\n";
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Render Queue"))
+    {
+        constexpr std::array<std::pair<RenderPass, const char*>, 4> passes{
+            {{RenderPass::Occlusion, "Occlusion"},
+             {RenderPass::Shadow, "Shadow"},
+             {RenderPass::Scene, "Scene"},
+             {RenderPass::Transparent, "Transparent"}}};
+        ImGui::Text("Packets: %zu", render_queue_.size());
+        for (const auto& [pass, name] : passes)
+        {
+            const gl::PassStatistics& statistics{render_queue_.statistics(gl::to_underlying(pass))};
+            ImGui::Text("%s: %zu draws, %zu programs, %zu textures, %zu VAOs, %zu blend, %zu uniforms, %zu skipped",
+                        name, statistics.draws, statistics.program_binds, statistics.texture_binds,
+                        statistics.vertex_array_binds, statistics.blend_changes, statistics.uniform_updates,
+                        statistics.redundant_binds_skipped);
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("State Cache"))
+    {
+        const gl::StateCache& state_cache{gl::state_cache()};
+        const gl::StateCache::Counters total{state_cache.total_counters()};
+        ImGui::Text("Total: %zu issued, %zu avoided", total.issued, total.avoided);
+        for (int category = 0; category < gl::to_underlying(gl::StateCache::Category::Count); ++category)
+        {
+            const auto state_category = static_cast<gl::StateCache::Category>(category);
+            const gl::StateCache::Counters& counters{state_cache.counters(state_category)};
+            const std::string_view name{gl::StateCache::category_name(state_category)};
+            ImGui::Text("%.*s: %zu issued, %zu avoided", static_cast<int>(name.size()), name.data(), counters.issued,
+                        counters.avoided);
+        }
+        if (ImGui::Button("Reset counters"))
+        {
+            gl::state_cache().reset_counters();
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Frame Statistics"))
+    {
+        const gl::FrameStats& frame_stats{gl::frame_stats()};
+        constexpr int number_of_columns{static_cast<int>(gl::FrameStats::number_of_counters) + 1};
+        if (ImGui::BeginTable("Counters", number_of_columns, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Pass");
+            for (std::size_t counter = 0; counter < gl::FrameStats::number_of_counters; ++counter)
+            {
+                ImGui::TableSetupColumn(
+                    gl::FrameStats::counter_name(static_cast<gl::FrameStats::Counter>(counter)).data());
+            }
+            ImGui::TableHeadersRow();
+
+            const auto counters_row = [](std::string_view name, const gl::FrameStats::Counters& counters) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.*s", static_cast<int>(name.size()), name.data());
+                for (const std::uint64_t count : counters)
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(count));
+                }
+            };
+            for (const auto& pass : frame_stats.last_frame())
+            {
+                counters_row(pass.name, pass.counters);
+            }
+            counters_row("Total", frame_stats.last_frame_total());
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("GPU Memory"))
+    {
+        gl::GpuMemoryTracker& gpu_memory{gl::gpu_memory()};
+        const gl::GpuMemoryTracker::Snapshot snapshot{gpu_memory.snapshot()};
+        constexpr std::uint64_t mebibyte{1024 * 1024};
+        const auto to_mebibytes = [](std::uint64_t bytes) {
+            return static_cast<double>(bytes) / static_cast<double>(mebibyte);
+        };
+
+        // A budget of 0 disables the warning
+        int budget_mebibytes{static_cast<int>(snapshot.budget_bytes.value_or(0) / mebibyte)};
+        if (ImGui::InputInt("Budget (MiB)", &budget_mebibytes, 16, 256))
+        {
+            gpu_memory.set_budget(budget_mebibytes > 0
+                                      ? std::optional{static_cast<std::uint64_t>(budget_mebibytes) * mebibyte}
+                                      : std::nullopt);
+        }
+        ImGui::Text("Total: %.1f MiB (peak %.1f MiB)", to_mebibytes(snapshot.total_bytes),
+                    to_mebibytes(snapshot.peak_bytes));
+        if (snapshot.budget_bytes)
+        {
+            const float fraction{static_cast<float>(static_cast<double>(snapshot.total_bytes) /
+                                                    static_cast<double>(snapshot.budget_bytes.value()))};
+            if (gpu_memory.is_over_budget())
+            {
+                ImGui::TextColored(ImVec4{1.0f, 0.3f, 0.3f, 1.0f}, "Over budget");
+            }
+            ImGui::ProgressBar(std::min(fraction, 1.0f));
+        }
+
+        constexpr int number_of_columns{static_cast<int>(gl::GpuMemoryTracker::number_of_categories) + 3};
+        if (ImGui::BeginTable("Owners", number_of_columns, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Owner");
+            for (std::size_t category = 0; category < gl::GpuMemoryTracker::number_of_categories; ++category)
+            {
+                ImGui::TableSetupColumn(gl::GpuMemoryTracker::category_name(
+                                            static_cast<gl::GpuMemoryTracker::Category>(category))
+                                            .data());
+            }
+            ImGui::TableSetupColumn("Total (MiB)");
+            ImGui::TableSetupColumn("Resources");
+            ImGui::TableHeadersRow();
+
+            const auto bytes_row = [&to_mebibytes](std::string_view name, const gl::GpuMemoryTracker::Totals& bytes,
+                                                   std::size_t resources) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.*s", static_cast<int>(name.size()), name.data());
+                std::uint64_t total{0};
+                for (const std::uint64_t category_bytes : bytes)
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", to_mebibytes(category_bytes));
+                    total += category_bytes;
+                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", to_mebibytes(total));
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", resources);
+            };
+            std::size_t resources{0};
+            for (const auto& owner : snapshot.owners)
+            {
+                bytes_row(owner.owner, owner.bytes, owner.resources);
+                resources += owner.resources;
+            }
+            bytes_row("Total", snapshot.totals, resources);
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+
+    if (gl::debug_output().is_enabled() && ImGui::TreeNode("Debug Output"))
+    {
+        gl::DebugOutput& debug_output{gl::debug_output()};
+        for (std::size_t type = 0; type < gl::DebugOutput::number_of_message_types; ++type)
+        {
+            const std::string_view name{gl::DebugOutput::type_name(static_cast<gl::DebugOutput::MessageType>(type))};
+            ImGui::Text("%.*s: %llu", static_cast<int>(name.size()), name.data(),
+                        static_cast<unsigned long long>(debug_output.counts()[type]));
+        }
+        if (ImGui::Button("Clear"))
+        {
+            debug_output.clear();
+        }
+
+        if (ImGui::BeginTable("Messages", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            for (const char* header : {"Type", "Count", "Message"})
+            {
+                ImGui::TableSetupColumn(header);
+            }
+            ImGui::TableHeadersRow();
+            for (const gl::DebugOutput::Message& message : debug_output.log())
+            {
+                const std::string_view type{gl::DebugOutput::type_name(message.type)};
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.*s", static_cast<int>(type.size()), type.data());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(message.count));
+                ImGui::TableNextColumn();
+                ImGui::TextWrapped("%s", message.text.c_str());
+            }
+            ImGui::EndTable();
+        }
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("GPU Profiler"))
+    {
+        if (!gpu_profiler_->pipeline_statistics_supported())
+        {
+            ImGui::Text("Pipeline statistics queries aren't supported");
+        }
+        ImGui::Text("Dropped frames: %zu", gpu_profiler_->dropped_frames());
+        if (ImGui::BeginTable("Passes", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            for (const char* header : {"Pass", "Average (ms)", "P95 (ms)", "VS invocations", "FS invocations",
+                                       "Primitives"})
+            {
+                ImGui::TableSetupColumn(header);
+            }
+            ImGui::TableHeadersRow();
+            for (const auto& scope : gpu_profiler_->scopes())
+            {
+                if (scope.history.empty())
+                {
+                    continue;
+                }
+                const gl::GpuProfiler::Sample& latest{scope.history.back()};
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", scope.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", scope.average_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", scope.p95_ms);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(latest.vertex_shader_invocations));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(latest.fragment_shader_invocations));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(latest.primitives));
+            }
+            ImGui::EndTable();
+        }
+        if (ImGui::Button("Export CSV"))
+        {
+            try
+            {
+                gpu_profiler_->export_csv("gpu_profile.csv");
+            }
+            catch (const std::runtime_error& error)
+            {
+                std::cerr << error.what() << "\n";
+            }
+        }
+        ImGui::TreePop();
+    }
+
+#ifdef GL_ENABLE_CPU_PROFILER
+    if (ImGui::TreeNode("CPU Profiler"))
+    {
+        const gl::CpuProfiler& cpu_profiler{gl::cpu_profiler()};
+        double startup_ms{0.0};
+        for (const auto& phase : cpu_profiler.phases())
+        {
+            ImGui::BulletText("%s: %.1f ms", phase.name.c_str(), phase.duration_ms);
+            startup_ms += phase.duration_ms;
+        }
+        ImGui::Text("Startup phases: %.1f ms", startup_ms);
+        ImGui::Text("Events: %zu recorded, %zu overwritten", cpu_profiler.recorded_events(),
+                    cpu_profiler.overwritten_events());
+        if (ImGui::Button("Export trace"))
+        {
+            try
+            {
+                cpu_profiler.export_chrome_trace("cpu_trace.json");
+            }
+            catch (const std::runtime_error& error)
+            {
+                std::cerr << error.what() << "\n";
+            }
+        }
+        ImGui::TreePop();
+    }
+#endif
+
+    if (ImGui::TreeNode("Render Graph"))
+    {
+        const gl::RenderGraph::Statistics& statistics{render_graph_.statistics()};
+        ImGui::Text("Passes: %zu executed, %zu declared", statistics.executed_passes, statistics.declared_passes);
+        for (const auto& culled_pass : render_graph_.culled_passes())
+        {
+            ImGui::BulletText("Culled: %s", culled_pass.c_str());
+        }
+        ImGui::Text("Transient targets: %zu (%.2f MB)", statistics.transient_targets,
+                    statistics.requested_bytes / (1024.0f * 1024.0f));
+        ImGui::Text("Pooled textures: %zu (%.2f MB)", statistics.pooled_textures,
+                    statistics.pooled_bytes / (1024.0f * 1024.0f));
+        ImGui::TreePop();
+    }
+
+    if (displayed_shadow_map_id_ != 0)
+    {
+        ImTextureID imgui_texture_id = reinterpret_cast<void*>(static_cast<std::intptr_t>(displayed_shadow_map_id_));
+        ImGui::Image(imgui_texture_id, ImVec2{200, 200}, ImVec2{0.0f, 0.0f}, ImVec2{1.0f, 1.0f},
+                     ImVec4{1.0f, 1.0f, 1.0f, 1.0f}, ImVec4{1.0f, 1.0f, 1.0f, 0.5f});
+    }
 
     ImGui::End();
 
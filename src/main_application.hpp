@@ -1,18 +1,82 @@
 #ifndef MAIN_APPLICATION_HPP
 #define MAIN_APPLICATION_HPP
 
+#include <array>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 #include "gl/application.hpp"
-#include "gl/framebuffer.hpp"
+#include "gl/benchmark.hpp"
+#include "gl/gpu_culling.hpp"
+#include "gl/gpu_profiler.hpp"
 #include "gl/light.hpp"
+#include "gl/light_visibility.hpp"
 #include "gl/model.hpp"
+#include "gl/render_graph.hpp"
+#include "gl/render_queue.hpp"
 #include "gl/shader.hpp"
+#include "gl/software_occlusion.hpp"
+#include "gl/state.hpp"
 
 class MainApplication : public gl::Application
 {
 public:
-    MainApplication(int window_width, int window_height, std::string_view title);
+    /*
+    Parameters of a benchmark run; the camera follows a scripted path over the
+    measured frames, or the given camera track whose length then sets the
+    number of measured frames.
+    */
+    struct BenchmarkSettings
+    {
+        std::size_t frames{600};
+        // Frames rendered from the start of the path before measuring, e.g. while drivers compile shaders
+        std::size_t warmup_frames{60};
+        std::optional<gl::CameraTrack> camera_track{};
+    };
+
+    enum class RenderMode
+    {
+        DefaultSceneOnly = 0,
+        OcclusionMapOnly,
+        RadialBlurOnly,
+        CompleteRender
+    };
+
+    // Implementations of the radial blur of the occlusion map
+    enum class BlurMethod
+    {
+        // Mitchell's blur: every pixel takes num_samples taps towards the light
+        SinglePass = 0,
+        /*
+        Passes of a few taps ping-ponging between blur targets, each
+        pass multiplying the step of the previous one by its number of taps,
+        so that the rays reach taps^passes taps.
+        */
+        MultiPass,
+        /*
+        Compute shader: each workgroup loads the band of the occlusion map
+        crossed by the rays of its tile into shared memory, where the rays
+        then march.
+        */
+        Compute,
+        /*
+        Epipolar sampling: a compute pass samples the occlusion map along
+        lines from the light to the border of the screen and scans each line
+        into decayed prefix sums, from which every pixel reads the sum of its
+        ray in a few fetches, however many samples it takes.
+        */
+        Epipolar,
+        /*
+        Single-pass blur taking a few taps per frame, offset differently on
+        every frame, accumulated into a history reprojected from the previous
+        frames.
+        */
+        Temporal
+    };
+
+    MainApplication(int window_width, int window_height, std::string_view title,
+                    gl::ContextSettings context_settings = {});
     MainApplication(const MainApplication&) = delete;
     MainApplication(MainApplication&&) = delete;
     MainApplication& operator=(const MainApplication&) = delete;
@@ -21,14 +85,24 @@ public:
 
     void render() override;
     void render_imgui_editor() override;
+    void resize(int width, int height) override;
+    void set_render_mode(RenderMode render_mode);
+    void set_blur_method(BlurMethod blur_method);
+    // Renders the frames of the benchmark as fast as possible and returns their CPU and GPU times
+    gl::BenchmarkReport run_benchmark(const BenchmarkSettings& settings);
+
+protected:
+    void apply_track_parameter(std::string_view name, float value) override;
 
 private:
-    enum class RenderMode
+
+    // Passes of the render queue, submitted in this order
+    enum class RenderPass : std::uint8_t
     {
-        DefaultSceneOnly = 0,
-        OcclusionMapOnly,
-        RadialBlurOnly,
-        CompleteRender
+        Occlusion = 0,
+        Shadow,
+        Scene,
+        Transparent
     };
 
     struct PostprocessingCoefficients
@@ -40,12 +114,118 @@ private:
         float weight;
     };
 
+    /*
+    Resolution of the target of the radial blur, as a divisor of the window
+    resolution. The blur of lower resolutions is upsampled by the composite,
+    guided by the depth of the occlusion pre-pass.
+    */
+    enum class BlurResolution
+    {
+        // The single-pass blur is computed by the composite itself
+        Full = 1,
+        Half = 2,
+        Quarter = 4
+    };
+
+    // Light sources of the scene, i.e. NUM_LIGHTS of the post-process shaders
+    static constexpr std::size_t number_of_lights{1};
+
+    /*
+    Format of the occlusion map, which the blur reads up to num_samples times
+    per pixel. Lights of a single color, e.g. a single light, only need a mask
+    of their sources, whose color the composite applies; lights of different
+    colors need their colors in the map.
+    */
+    enum class OcclusionFormat
+    {
+        // R8, sampled as white through the swizzle of the texture: a quarter of the bytes of RGBA8
+        Mask = 0,
+        // R11G11B10F
+        Color
+    };
+
+    // Sampling of the occlusion map by the single-pass blur, trading quality for speed
+    enum class BlurSampling
+    {
+        // num_samples taps evenly spaced along the ray
+        Uniform = 0,
+        // cone_taps taps of the mip chain of the occlusion map, over segments growing along the ray
+        Cone
+    };
+
+    /*
+    Scales the taps of the single-pass blur with the length of the ray of
+    each pixel, between min_samples and num_samples.
+    */
+    struct AdaptiveSampling
+    {
+        bool enabled{true};
+        int min_samples{8};
+        float texels_per_sample{2.0f};
+        // Jitters the taps with interleaved gradient noise, trading banding for noise
+        bool jitter{false};
+    };
+
+    struct MultiPassBlur
+    {
+        int passes{3};
+        int taps{8};
+    };
+
+    /*
+    Settings and state of the temporal blur. The history holds the blur
+    accumulated over the previous frames, and the luminance of the occlusion
+    map in its alpha channel, to detect the pixels whose occlusion changed.
+    Two histories alternate over the frames: the resolve reads the previous
+    one and writes the other, which the composite then reads.
+    */
+    struct TemporalBlur
+    {
+        int samples{8};
+        // Weight of the history in the blend with the blur of the frame
+        float history_weight{0.9375f};
+        // Largest change of the luminance of the occlusion map of a pixel for which its history is kept
+        float occlusion_threshold{0.1f};
+        std::array<std::optional<gl::Texture>, 2> histories{};
+        // History written by the last frame
+        std::size_t current_history{0};
+        bool history_valid{false};
+        glm::mat4 previous_view_projection{1.0f};
+        glm::vec3 previous_light_position{0.0f};
+        // Offsets of the taps within their steps, in fractions of a step, cycled through over the frames
+        std::array<float, 16> jitter_sequence{};
+        std::size_t frame{0};
+    };
+
+    // Rectangle of the screen in texture coordinates
+    struct ScreenRectangle
+    {
+        glm::vec2 min{0.0f};
+        glm::vec2 max{1.0f};
+    };
+
+    // Pipeline states bound by the passes; the post-process pipelines are indexed by RenderMode
+    struct Pipelines
+    {
+        gl::PipelineState color;
+        gl::PipelineState shadow_map;
+        gl::PipelineState texture_blinn_phong;
+        gl::PipelineState gpu_color_blinn_phong;
+        std::array<gl::PipelineState, 4> post_process;
+        gl::PipelineState radial_blur;
+        gl::PipelineState multi_pass_blur;
+        gl::PipelineState epipolar_gather;
+        gl::PipelineState temporal_resolve;
+    };
+
     struct ShadowMapParameters
     {
         float near_plane{0.1f};
         float far_plane{100.0f};
         float frustum_dimension{24.2f};
         float bias{0.005f};
+        // Width and height of the shadow map, a power of two between 512 and 4096
+        int size{1024};
         glm::mat4 light_projection;
         glm::vec3 target{0.0f};
 
@@ -54,13 +234,32 @@ private:
 
     std::unique_ptr<gl::ShaderProgram> texture_blinn_phong_shader_{};
     std::unique_ptr<gl::ShaderProgram> color_blinn_phong_shader_{};
+    std::unique_ptr<gl::ShaderProgram> gpu_color_blinn_phong_shader_{};
     std::unique_ptr<gl::ShaderProgram> color_shader_{};
     std::unique_ptr<gl::ShaderProgram> post_process_shader_{};
+    // Single-pass blur rendered into the blur target rather than composited
+    std::unique_ptr<gl::ShaderProgram> radial_blur_shader_{};
+    std::unique_ptr<gl::ShaderProgram> compute_blur_shader_{};
     std::unique_ptr<gl::ShaderProgram> shadow_map_shader_{};
-    std::unique_ptr<gl::Framebuffer> occlusion_fbo_{};
-    std::unique_ptr<gl::Framebuffer> shadow_map_fbo_{};
+    std::unique_ptr<gl::ShaderProgram> multi_pass_blur_shader_{};
+    std::unique_ptr<gl::ShaderProgram> epipolar_scan_shader_{};
+    std::unique_ptr<gl::ShaderProgram> epipolar_gather_shader_{};
+    std::unique_ptr<gl::ShaderProgram> temporal_resolve_shader_{};
+    std::unique_ptr<Pipelines> pipelines_{};
     std::unique_ptr<gl::IndexedMesh> full_screen_quad_{};
+    std::unique_ptr<gl::HiZPyramid> hi_z_pyramid_{};
+    std::unique_ptr<gl::GpuDrivenModel> gpu_driven_sibenik_{};
+    std::unique_ptr<gl::SoftwareOcclusionCuller> software_occlusion_culler_{};
     std::unordered_map<std::string, gl::Model> models_{};
+    gl::RenderQueue render_queue_{};
+    gl::RenderGraph render_graph_{};
+    std::unique_ptr<gl::GpuProfiler> gpu_profiler_{};
+    gl::TextureDescription occlusion_map_description_{};
+    gl::TextureDescription occlusion_depth_description_{};
+    gl::TextureDescription shadow_map_description_{};
+    gl::TextureDescription blur_description_{};
+    // Shadow map displayed by the GUI, or 0 if it wasn't rendered on the current frame
+    std::uint32_t displayed_shadow_map_id_{0};
     RenderMode render_mode_{RenderMode::CompleteRender};
     gl::DirectionalLight light_{.direction = glm::vec3{1.0f, 1.0f, 1.0f},
                                 .ambient = glm::vec3{0.2f, 0.2f, 0.2f},
@@ -69,9 +268,103 @@ private:
     PostprocessingCoefficients coefficients{
         .num_samples = 100, .density = 1.0f, .exposure = 1.0f, .decay = 1.0f, .weight = 0.01f};
     bool apply_radial_blur_{true};
+    BlurMethod blur_method_{BlurMethod::SinglePass};
+    MultiPassBlur multi_pass_blur_{};
+    TemporalBlur temporal_blur_{};
+    BlurSampling blur_sampling_{BlurSampling::Uniform};
+    int cone_taps_{16};
+    AdaptiveSampling adaptive_sampling_{};
+    gl::LightVisibility light_visibility_{};
+    // Light whose occlusion query conditions the rendering of the blur on the current frame, if any
+    std::optional<std::size_t> blur_condition_light_{};
+    // Restricts the passes of the blur to the part of the screen the blur of the lights reaches
+    bool scissor_blur_region_{true};
+    // Part of the screen reached by the blur on the current frame, or empty if it's the whole screen
+    std::optional<ScreenRectangle> blur_region_{};
+    OcclusionFormat occlusion_format_{OcclusionFormat::Mask};
+    // Colors of the lights, in the order of the light models of the frame; white until set
+    std::array<glm::vec3, number_of_lights> light_colors_{};
+    // Stores the occlusion depth in 16 bits, which loses precision far from the camera
+    bool compact_occlusion_depth_{false};
+    // Size of the occlusion map and depth relative to the window
+    float occlusion_scale_{0.5f};
+    BlurResolution blur_resolution_{BlurResolution::Half};
+    bool depth_aware_upsample_{true};
+    bool gpu_driven_culling_{false};
+    bool software_occlusion_culling_{false};
+    std::size_t software_culled_meshes_{0};
+    float software_occlusion_time_ms_{0.0f};
     ShadowMapParameters shadow_map_parameters_{};
 
     void set_shadow_map_transforms();
+    // Applies a parameter changed through the GUI and records it if a camera track is being recorded
+    void set_parameter(std::string_view name, float value);
+    // Marks the meshes of the model hidden by the software occluders as not visible
+    void apply_software_occlusion_culling(gl::Model& model, const glm::mat4& mvp);
+    // Sizes the blur targets after the blur resolution
+    void set_blur_resolution(BlurResolution blur_resolution);
+    /*
+    Average taps per pixel of the adaptive single-pass blur towards the
+    visible lights, estimated on the CPU; only computed for the GUI.
+    */
+    float average_blur_taps() const;
+    // Selects the format of the occlusion map from the colors of the lights
+    void set_light_color(std::size_t light, const glm::vec3& color);
+    void set_compact_occlusion_depth(bool compact);
+    // Gives the occlusion map a mip chain if the blur samples it
+    void set_blur_sampling(BlurSampling blur_sampling);
+    /*
+    Adds a pass rendering the single-pass blur of the occlusion map into a
+    blur target, with at most max_samples taps moved towards the pixels by
+    sample_offset steps.
+    */
+    gl::RenderGraph::ResourceHandle add_radial_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                    const std::vector<glm::vec4>& light_positions, int max_samples,
+                                                    float sample_offset);
+    /*
+    Bounds the part of the screen where the blur of the lights adds at least
+    a step of an 8-bit channel, knowing that only the light sources are lit
+    in the occlusion map; empty if the blur may reach the whole screen.
+    */
+    std::optional<ScreenRectangle> compute_blur_region(const std::vector<gl::Model*>& light_models,
+                                                       const std::vector<glm::vec4>& light_positions,
+                                                       const glm::mat4& view_projection) const;
+    // Occlusion query of the current frame skipping the blur while its light is occluded, or 0
+    GLuint blur_condition() const;
+    // Scissor restricting a pass to the blur region of a target with the given viewport, if the region is set
+    gl::ScissorState blur_scissor(const std::array<int, 4>& viewport) const;
+    // Adds a compute pass blurring the occlusion map towards the light into a blur target
+    gl::RenderGraph::ResourceHandle add_compute_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                     const glm::vec2& light_position);
+    // Adds the passes scanning the occlusion map along epipolar lines and gathering the blur from the scans
+    gl::RenderGraph::ResourceHandle add_epipolar_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                      const glm::vec2& light_position);
+    /*
+    Adds the passes of the temporal blur: the single-pass blur of the frame
+    with a few jittered taps, then its blend with the reprojected history.
+    The history follows the primary light, whose screen_light_position is
+    its entry of light_positions and light_position its position in world
+    space.
+    */
+    gl::RenderGraph::ResourceHandle add_temporal_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                      gl::RenderGraph::ResourceHandle occlusion_depth,
+                                                      const std::vector<glm::vec4>& light_positions,
+                                                      const glm::mat4& view_projection,
+                                                      const glm::vec4& screen_light_position,
+                                                      const glm::vec3& light_position);
+    /*
+    Adds the passes of the multi-pass blur of the occlusion map towards the
+    light; returns the blurred map and sets the gain restoring the
+    brightness of a single-pass blur with the current coefficients.
+    */
+    gl::RenderGraph::ResourceHandle add_multi_pass_blur(gl::RenderGraph::ResourceHandle occlusion_map,
+                                                        const glm::vec2& light_position, float& gain);
+    // Shaders sharing the light and shadow uniforms
+    std::array<gl::ShaderProgram*, 3> blinn_phong_shaders();
+    // Shaders sharing the coefficients of the radial blur
+    std::array<gl::ShaderProgram*, 4> radial_blur_shaders();
+    // Shaders of the single-pass blur, composited or rendered into the blur target
+    std::array<gl::ShaderProgram*, 2> single_pass_blur_shaders();
 };
 
 #endif // MAIN_APPLICATION_HPP
\ No newline at end of file
@@ -0,0 +1,431 @@
+/*
+Rendering and performance regression harness: renders fixed viewpoints of the
+scene in every render mode offscreen, compares the frames against golden
+images and the GPU times of the passes against a baseline, and prints a JSON
+report. Consecutive frames have correlated timings (clocks, caches, thermal
+state), so each case is rendered by several fresh benchmark runs and the
+rank test compares the medians of the runs rather than individual frames.
+Run with --update to record new golden images and a new baseline, e.g. after
+an intended change of the rendering.
+*/
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gl/benchmark.hpp"
+#include "gl/camera_track.hpp"
+#include "gl/image.hpp"
+#include "gl/json.hpp"
+#include "main_application.hpp"
+
+namespace
+{
+
+struct Options
+{
+    bool update{false};
+    int width{640};
+    int height{360};
+    int samples{4};
+    // Benchmark runs per case, i.e. number of timing samples of each pass, and measured frames per run
+    std::size_t runs{8};
+    std::size_t frames{30};
+    std::size_t warmup_frames{10};
+    std::filesystem::path golden_directory{"regression"};
+    // Channels may differ by this much, e.g. because of different rasterization rules between drivers
+    int channel_tolerance{8};
+    double max_differing_fraction{0.001};
+    // A pass regressed if it's significantly slower and its median time grew by more than the threshold
+    double significance{0.01};
+    double slowdown_threshold{0.05};
+    // The report is printed to the standard output if no file is given
+    std::string output_filename{};
+};
+
+struct Viewpoint
+{
+    std::string_view name;
+    gl::CameraTrack::Pose pose;
+};
+
+const std::array<Viewpoint, 3> viewpoints{
+    {{"nave", {.position = glm::vec3{-12.0f, 2.0f, 0.0f}, .pitch_yaw = glm::vec2{5.0f, 90.0f}}},
+     {"window", {.position = glm::vec3{-5.73f, 1.91f, 2.15f}, .pitch_yaw = glm::vec2{3.0f, 84.5f}}},
+     {"apse", {.position = glm::vec3{9.0f, 4.0f, -1.0f}, .pitch_yaw = glm::vec2{20.0f, 70.0f}}}}};
+
+const std::array<std::pair<std::string_view, MainApplication::RenderMode>, 4> render_modes{
+    {{"default_scene", MainApplication::RenderMode::DefaultSceneOnly},
+     {"occlusion_map", MainApplication::RenderMode::OcclusionMapOnly},
+     {"radial_blur", MainApplication::RenderMode::RadialBlurOnly},
+     {"complete", MainApplication::RenderMode::CompleteRender}}};
+
+// Name under which the GPU time of whole frames is compared, along with the passes
+constexpr std::string_view frame_timing{"Frame"};
+
+constexpr std::string_view usage{
+    "Usage: regression [--update] [--golden-dir DIR] [--runs N] [--frames N] [--warmup N] [--width W]\n"
+    "                  [--height H] [--samples S] [--tolerance T] [--max-differing F] [--significance A]\n"
+    "                  [--slowdown F] [--output FILE]\n"
+    "  --update         Record the golden images and timing baseline instead of comparing against them\n"
+    "  --golden-dir     Directory of the golden images and of baseline.txt (default: regression)\n"
+    "  --runs           Benchmark runs per case, whose median times are compared (default: 8)\n"
+    "  --frames         Measured frames per run (default: 30)\n"
+    "  --tolerance      Largest difference of a channel not counted as a differing pixel (default: 8)\n"
+    "  --max-differing  Largest fraction of differing pixels of a matching image (default: 0.001)\n"
+    "  --significance   Largest p-value of a significant slowdown (default: 0.01)\n"
+    "  --slowdown       Smallest relative growth of the median time reported as a regression (default: 0.05)\n"};
+
+// Median times of the runs in milliseconds, per case and per pass
+using Timings = std::map<std::string, std::map<std::string, std::vector<double>>>;
+
+template <typename T>
+T parse_number(std::string_view option, std::string_view value, T minimum)
+{
+    std::istringstream stream{std::string{value}};
+    T number{};
+    if (!(stream >> number) || !stream.eof() || number < minimum)
+    {
+        throw std::invalid_argument("Invalid value " + std::string{value} + " for option " + std::string{option});
+    }
+    return number;
+}
+
+Options parse_options(const std::vector<std::string_view>& arguments)
+{
+    Options options;
+    for (std::size_t i = 0; i < arguments.size(); ++i)
+    {
+        const std::string_view option{arguments[i]};
+        if (option == "--update")
+        {
+            options.update = true;
+            continue;
+        }
+
+        if (i + 1 == arguments.size())
+        {
+            throw std::invalid_argument("Unknown option or missing value: " + std::string{option});
+        }
+        const std::string_view value{arguments[++i]};
+        if (option == "--golden-dir")
+        {
+            options.golden_directory = value;
+        }
+        else if (option == "--runs")
+        {
+            options.runs = parse_number<std::size_t>(option, value, 1);
+        }
+        else if (option == "--frames")
+        {
+            options.frames = parse_number<std::size_t>(option, value, 1);
+        }
+        else if (option == "--warmup")
+        {
+            options.warmup_frames = parse_number<std::size_t>(option, value, 0);
+        }
+        else if (option == "--width")
+        {
+            options.width = parse_number(option, value, 1);
+        }
+        else if (option == "--height")
+        {
+            options.height = parse_number(option, value, 1);
+        }
+        else if (option == "--samples")
+        {
+            options.samples = parse_number(option, value, 0);
+        }
+        else if (option == "--tolerance")
+        {
+            options.channel_tolerance = parse_number(option, value, 0);
+        }
+        else if (option == "--max-differing")
+        {
+            options.max_differing_fraction = parse_number(option, value, 0.0);
+        }
+        else if (option == "--significance")
+        {
+            options.significance = parse_number(option, value, 0.0);
+        }
+        else if (option == "--slowdown")
+        {
+            options.slowdown_threshold = parse_number(option, value, 0.0);
+        }
+        else if (option == "--output")
+        {
+            options.output_filename = value;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option: " + std::string{option});
+        }
+    }
+    return options;
+}
+
+/*
+The baseline is a text file with a line per case and pass: the case and pass
+names and the median times of the runs, separated by tabs. Every run is
+stored rather than a summary, since the rank test compares distributions.
+*/
+Timings read_baseline(const std::filesystem::path& filename)
+{
+    std::ifstream file{filename};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + filename.string() +
+                                 "; record a baseline with --update first");
+    }
+
+    Timings timings;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream{line};
+        std::string case_name;
+        std::string pass_name;
+        if (!std::getline(stream, case_name, '\t') || !std::getline(stream, pass_name, '\t'))
+        {
+            continue;
+        }
+        std::vector<double>& samples = timings[case_name][pass_name];
+        for (double sample{0.0}; stream >> sample;)
+        {
+            samples.emplace_back(sample);
+        }
+    }
+    return timings;
+}
+
+void write_baseline(const std::filesystem::path& filename, const Timings& timings)
+{
+    std::ofstream file{filename};
+    if (!file)
+    {
+        throw std::runtime_error("Failure to open file " + filename.string() + " for writing");
+    }
+
+    file.precision(6);
+    for (const auto& [case_name, passes] : timings)
+    {
+        for (const auto& [pass_name, samples] : passes)
+        {
+            file << case_name << '\t' << pass_name << '\t';
+            for (const double sample : samples)
+            {
+                file << sample << ' ';
+            }
+            file << '\n';
+        }
+    }
+}
+
+double median(std::vector<double> samples)
+{
+    return gl::summarize_durations(std::move(samples)).median_ms;
+}
+
+// Compares the rendered frame to its golden image and writes the result as a JSON object; returns false on mismatch
+bool check_image(std::ostream& report, const Options& options, const std::filesystem::path& golden_filename,
+                 const gl::Image& frame)
+{
+    report << "\"image\": {\"golden\": ";
+    gl::write_json_string(report, golden_filename.string());
+    if (options.update)
+    {
+        gl::write_png(golden_filename.string(), frame);
+        report << ", \"status\": \"updated\"}";
+        return true;
+    }
+
+    if (!std::filesystem::exists(golden_filename))
+    {
+        report << ", \"status\": \"missing\"}";
+        return false;
+    }
+
+    const gl::Image golden{gl::read_png(golden_filename.string())};
+    if (golden.width != frame.width || golden.height != frame.height)
+    {
+        report << ", \"status\": \"size_mismatch\"}";
+        return false;
+    }
+
+    const gl::ImageDifference difference{gl::compare_images(golden, frame, options.channel_tolerance)};
+    const bool matches{difference.differing_fraction <= options.max_differing_fraction};
+    report << ", \"status\": " << (matches ? "\"pass\"" : "\"fail\"")
+           << ", \"max_channel_difference\": " << difference.max_channel_difference
+           << ", \"mean_channel_difference\": " << difference.mean_channel_difference
+           << ", \"differing_pixels\": " << difference.differing_pixels
+           << ", \"differing_fraction\": " << difference.differing_fraction << "}";
+    return matches;
+}
+
+// Compares the timings of the passes of a case to the baseline and writes them as a JSON array; false on regression
+bool check_timings(std::ostream& report, const Options& options,
+                   const std::map<std::string, std::vector<double>>& baseline,
+                   const std::map<std::string, std::vector<double>>& current)
+{
+    bool passed{true};
+    report << "\"passes\": [";
+    for (auto pass = current.cbegin(); pass != current.cend(); ++pass)
+    {
+        report << (pass == current.cbegin() ? "\n" : ",\n") << "      {\"name\": ";
+        gl::write_json_string(report, pass->first);
+        const double current_median{median(pass->second)};
+        report << ", \"median_ms\": " << current_median;
+
+        const auto baseline_pass = baseline.find(pass->first);
+        if (options.update)
+        {
+            report << ", \"status\": \"updated\"}";
+            continue;
+        }
+        if (baseline_pass == baseline.cend() || baseline_pass->second.empty())
+        {
+            // New passes have nothing to be compared to, which isn't a regression
+            report << ", \"status\": \"new\"}";
+            continue;
+        }
+
+        const double baseline_median{median(baseline_pass->second)};
+        const gl::MannWhitneyResult test{gl::mann_whitney_u(baseline_pass->second, pass->second)};
+        const double change{baseline_median > 0.0 ? current_median / baseline_median - 1.0 : 0.0};
+        const bool regressed{test.p_value < options.significance && change > options.slowdown_threshold};
+        passed = passed && !regressed;
+        report << ", \"baseline_median_ms\": " << baseline_median << ", \"change\": " << change
+               << ", \"u\": " << test.u << ", \"p_value\": " << test.p_value
+               << ", \"status\": " << (regressed ? "\"regression\"" : "\"pass\"") << "}";
+    }
+    report << "\n    ]";
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    try
+    {
+        options = parse_options(std::vector<std::string_view>(argv + 1, argv + argc));
+    }
+    catch (const std::invalid_argument& exception)
+    {
+        std::cerr << exception.what() << '\n' << usage;
+        return EXIT_FAILURE;
+    }
+
+    bool passed{true};
+    try
+    {
+        const std::filesystem::path baseline_filename{options.golden_directory / "baseline.txt"};
+        Timings baseline;
+        if (options.update)
+        {
+            std::filesystem::create_directories(options.golden_directory);
+        }
+        else
+        {
+            baseline = read_baseline(baseline_filename);
+        }
+
+        MainApplication application{options.width, options.height, "Regression",
+                                    gl::ContextSettings{.headless = true, .samples = options.samples}};
+        std::ostringstream report;
+        report.setf(std::ios::fixed, std::ios::floatfield);
+        report.precision(4);
+        report << "{\n  \"renderer\": ";
+        std::string renderer;
+        Timings timings;
+        for (const Viewpoint& viewpoint : viewpoints)
+        {
+            // Both keyframes hold the same pose, so every measured frame renders the same image
+            gl::CameraTrack track;
+            track.add_keyframe(0.0, viewpoint.pose);
+            track.add_keyframe((static_cast<double>(options.frames) - 0.5) * gl::CameraTrack::time_step,
+                               viewpoint.pose);
+
+            for (const auto& [mode_name, render_mode] : render_modes)
+            {
+                const std::string case_name{std::string{viewpoint.name} + "_" + std::string{mode_name}};
+                application.set_render_mode(render_mode);
+                std::map<std::string, std::vector<double>>& case_timings = timings[case_name];
+                // Each run warms up again, so the runs are independent samples of the time of the case
+                for (std::size_t run = 0; run < options.runs; ++run)
+                {
+                    const gl::BenchmarkReport benchmark{application.run_benchmark(
+                        {.warmup_frames = options.warmup_frames, .camera_track = track})};
+                    if (renderer.empty())
+                    {
+                        renderer = benchmark.renderer;
+                        gl::write_json_string(report, renderer);
+                        report << ",\n  \"width\": " << options.width << ",\n  \"height\": " << options.height
+                               << ",\n  \"runs\": " << options.runs << ",\n  \"frames\": " << options.frames
+                               << ",\n  \"cases\": [";
+                    }
+
+                    // Frames and passes whose queries were all dropped have no time for this run
+                    const auto add_run = [&case_timings](const std::string& name, const std::vector<double>& times) {
+                        if (!times.empty())
+                        {
+                            case_timings[name].emplace_back(median(times));
+                        }
+                    };
+                    add_run(std::string{frame_timing}, benchmark.gpu_frame_ms);
+                    for (const auto& pass : benchmark.passes)
+                    {
+                        add_run(pass.name, pass.gpu_ms);
+                    }
+                }
+
+                report << (timings.size() == 1 ? "\n" : ",\n") << "    {\"name\": ";
+                gl::write_json_string(report, case_name);
+                report << ",\n    ";
+                passed &= check_image(report, options, options.golden_directory / (case_name + ".png"),
+                                      application.capture_frame());
+                report << ",\n    ";
+                passed &= check_timings(report, options, baseline[case_name], case_timings);
+                report << "}";
+            }
+        }
+        report << "\n  ],\n  \"passed\": " << (passed ? "true" : "false") << "\n}\n";
+
+        if (options.update)
+        {
+            write_baseline(baseline_filename, timings);
+        }
+
+        if (options.output_filename.empty())
+        {
+            std::cout << report.str();
+        }
+        else
+        {
+            std::ofstream file{options.output_filename};
+            if (!file)
+            {
+                throw std::runtime_error("Failure to open file " + options.output_filename + " for writing");
+            }
+            file << report.str();
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}